@@ -114,6 +114,9 @@ const string Cobalt::Initialize(PluginHost::IShell *service) {
       stateControl->Register(&_notification);
       stateControl->Configure(_service);
       stateControl->Release();
+
+      if (config.PerformanceInterval.Value() > 0)
+        _performanceReporter.Start(config.PerformanceInterval.Value());
     }
   }
 
@@ -138,6 +141,8 @@ void Cobalt::Deinitialize(PluginHost::IShell *service) {
   PluginHost::IStateControl *stateControl(
     _cobalt->QueryInterface<PluginHost::IStateControl>());
 
+  _performanceReporter.Cancel();
+
   // Make sure the Activated and Deactivated are no longer called before we
   // start cleaning up..
   _service->Unregister(&_notification);
@@ -289,6 +294,12 @@ void Cobalt::Deactivated(RPC::IRemoteConnection *connection) {
   }
 }
 
+void Cobalt::ReportPerformance() {
+  JsonObject metrics;
+  if (get_performance(metrics) == Core::ERROR_NONE)
+    event_performance(metrics);
+}
+
 void Cobalt::Closure() {
   TRACE(Trace::Information, (_T("Closure: \"true\"")));
   _service->Notify(_T("{\"Closure\": true }"));
@@ -84,7 +84,64 @@ private:
     Cobalt &_parent;
   };
 
+  // Periodically broadcasts the 'performance' metrics.
+  class PerformanceReporter: public Core::Thread {
+  private:
+    PerformanceReporter() = delete;
+    PerformanceReporter(const PerformanceReporter&) = delete;
+    PerformanceReporter& operator=(const PerformanceReporter&) = delete;
+
+  public:
+    explicit PerformanceReporter(Cobalt &parent) :
+      Core::Thread(0, _T("CobaltPerformance")), _parent(parent), _interval(0) {
+    }
+    ~PerformanceReporter() {
+      Stop();
+      Wait(Thread::STOPPED | Thread::BLOCKED, Core::infinite);
+    }
+
+    void Start(const uint32_t intervalInSeconds) {
+      _interval = intervalInSeconds * 1000;
+      _skip = true;
+      Run();
+    }
+    void Cancel() {
+      Block();
+      Wait(Thread::BLOCKED | Thread::STOPPED, Core::infinite);
+    }
+
+  private:
+    virtual uint32_t Worker() override {
+      // The first round only waits for the interval to pass.
+      if (_skip == false)
+        _parent.ReportPerformance();
+      _skip = false;
+      return (_interval);
+    }
+
+  private:
+    Cobalt &_parent;
+    uint32_t _interval;
+    bool _skip { true };
+  };
+
 public:
+  class Config: public Core::JSON::Container {
+  private:
+    Config(const Config&) = delete;
+    Config& operator=(const Config&) = delete;
+
+  public:
+    Config() :
+      Core::JSON::Container(), PerformanceInterval(60) {
+      Add(_T("performanceinterval"), &PerformanceInterval);
+    }
+    ~Config() {
+    }
+  public:
+    Core::JSON::DecUInt16 PerformanceInterval;
+  };
+
   class Data: public Core::JSON::Container {
   private:
     Data(const Data&) = delete;
@@ -111,7 +168,8 @@ public:
 public:
   Cobalt() :
     _skipURL(0), _hidden(false), _cobalt(nullptr),
-    _memory(nullptr), _service(nullptr), _notification(this) {
+    _memory(nullptr), _service(nullptr), _notification(this),
+    _performanceReporter(*this) {
     RegisterAll();
   }
   virtual ~Cobalt() {
@@ -151,6 +209,7 @@ private:
   void URLChanged(const string &URL);
   void Hidden(const bool hidden);
   void Closure();
+  void ReportPerformance();
 
   inline void ConnectionTermination(uint32_t connectionId)
   {
@@ -184,6 +243,9 @@ private:
   uint32_t get_accessibility(JsonObject &response) const;
   uint32_t set_accessibility(const JsonObject &param);
 
+  uint32_t get_performance(JsonObject &response) const;
+  void event_performance(const JsonObject &metrics);
+
 private:
   uint8_t _skipURL;
   uint32_t _connectionId;
@@ -192,6 +254,7 @@ private:
   Exchange::IMemory *_memory;
   PluginHost::IShell *_service;
   Core::Sink<Notification> _notification;
+  PerformanceReporter _performanceReporter;
 };
 
 }  // namespace Plugin
@@ -16,6 +16,8 @@
 * SPDX-License-Identifier: Apache-2.0
 */
 #include "Module.h"
+#include <dirent.h>
+#include <unistd.h>
 #include <interfaces/IMemory.h>
 #include <interfaces/IBrowser.h>
 #include <interfaces/IDictionary.h>
@@ -32,12 +34,25 @@ void SbRdkResume();
 void SbRdkPause();
 void SbRdkUnpause();
 void SbRdkQuit();
+
+typedef enum SbRdkTransitionResult {
+  kSbRdkTransitionCompleted,
+  kSbRdkTransitionSuperseded,
+  kSbRdkTransitionAborted,
+} SbRdkTransitionResult;
+typedef void (*SbRdkTransitionCallbackFunc)(SbRdkTransitionResult result, int64_t latency, void* user_data);
+void SbRdkSuspendAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
+void SbRdkResumeAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
+void SbRdkPauseAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
+
 void SbRdkSetSetting(const char* key, const char* json);
 int  SbRdkGetSetting(const char* key, char** out_json);
 
 typedef int (*SbRdkCallbackFunc)(void *user_data);
 void SbRdkSetConcealRequestHandler(SbRdkCallbackFunc cb, void* user_data);
 void SbRdkSetCobaltExitStrategy(const char* strategy);
+void SbRdkWarmUp();
+void SbRdkMarkLaunchRequest();
 
 }  // extern "C"
 
@@ -72,6 +87,21 @@ static void SetThunderAccessPointIfNeeded() {
   file.Close();
 }
 
+// Threads reported by the 'performance' metrics. Names as truncated by the
+// kernel to 15 characters.
+static const struct {
+  const char* label;
+  const char* comm;
+} kThreadGroups[] = {
+  // Event loops shared by the players and audio sinks.
+  { "medialoop", "media_loop" },
+  { "hangdetector", "hangdetector_th" },
+  // Decryption runs on the streaming threads of the appsrc elements.
+  { "videodecrypt", "vidsrc:src" },
+  { "audiodecrypt", "audsrc:src" },
+};
+static constexpr size_t kThreadGroupCount = sizeof(kThreadGroups) / sizeof(kThreadGroups[0]);
+
 enum StateChangeCommand : uint16_t {
   SUSPEND = PluginHost::IStateControl::SUSPEND,
   RESUME = PluginHost::IStateControl::RESUME,
@@ -100,7 +130,8 @@ private:
       , ContentDir()
       , PreloadEnabled()
       , EssosContextDestroy()
-      , AutoSuspendDelay() {
+      , AutoSuspendDelay()
+      , WarmStart() {
       Add(_T("url"), &Url);
       Add(_T("clientidentifier"), &ClientIdentifier);
       Add(_T("language"), &Language);
@@ -111,6 +142,9 @@ private:
       Add(_T("autosuspenddelay"), &AutoSuspendDelay);
       Add(_T("systemproperties"), &SystemProperties);
       Add(_T("closurepolicy"), &ClosurePolicy);
+      Add(_T("memoryprofile"), &MemoryProfile);
+      Add(_T("threadconfig"), &ThreadConfig);
+      Add(_T("warmstart"), &WarmStart);
     }
     ~Config() {
     }
@@ -126,6 +160,9 @@ private:
     Core::JSON::DecUInt16 AutoSuspendDelay;
     Core::JSON::VariantContainer SystemProperties;
     Core::JSON::String ClosurePolicy;
+    Core::JSON::VariantContainer MemoryProfile;
+    Core::JSON::VariantContainer ThreadConfig;
+    Core::JSON::Boolean WarmStart;
   };
 
   class NotificationSink: public Core::Thread {
@@ -155,33 +192,85 @@ private:
 
   private:
     virtual uint32_t Worker() {
-      bool success = false;
-
       _lock.Lock();
       const StateChangeCommand command = _command;
       _lock.Unlock();
 
-      if ((IsRunning() == true) && (success == false)) {
-        success = _parent.RequestForStateChange(command);
+      // Doesn't wait for the transition, StateChangeCompleted() follows
+      // from the Cobalt thread.
+      if (IsRunning() == true) {
+        _parent.RequestForStateChange(command);
       }
       Block();
-      _parent.StateChangeCompleted(success, command);
 
-      if (success == true) {
-        _lock.Lock();
-        bool completed = (command == _command);
+      _lock.Lock();
+      bool completed = (command == _command);
+      _lock.Unlock();
+      // Spin one more time
+      if (!completed)
+        Run();
+
+      return (Core::infinite);
+    }
+
+  private:
+    CobaltImplementation &_parent;
+    StateChangeCommand _command;
+    mutable Core::CriticalSection _lock;
+  };
+
+  // Reports finished transitions from its own thread, StateChangeDone()
+  // runs on the Cobalt thread which must not wait for the clients.
+  class StateChangeNotifier: public Core::Thread {
+  private:
+    StateChangeNotifier() = delete;
+    StateChangeNotifier(const StateChangeNotifier&) = delete;
+    StateChangeNotifier& operator=(const StateChangeNotifier&) = delete;
+
+  public:
+    StateChangeNotifier(CobaltImplementation &parent) :
+      _parent(parent) {
+    }
+    virtual ~StateChangeNotifier() {
+      Stop();
+      Wait(Thread::STOPPED | Thread::BLOCKED, Core::infinite);
+    }
+
+  public:
+    void StateChangeCompleted(bool success,
+                              const StateChangeCommand command) {
+      _lock.Lock();
+      _results.emplace_back(success, command);
+      _lock.Unlock();
+      Run();
+    }
+
+  private:
+    virtual uint32_t Worker() {
+      _lock.Lock();
+      while (IsRunning() == true && !_results.empty()) {
+        const std::pair<bool, StateChangeCommand> result = _results.front();
+        _results.pop_front();
         _lock.Unlock();
-        // Spin one more time
-        if (!completed)
-          Run();
+        _parent.StateChangeCompleted(result.first, result.second);
+        _lock.Lock();
       }
+      _lock.Unlock();
+      Block();
+
+      _lock.Lock();
+      bool completed = _results.empty();
+      _lock.Unlock();
+      // Spin one more time
+      if (!completed)
+        Run();
 
       return (Core::infinite);
     }
 
   private:
     CobaltImplementation &_parent;
-    StateChangeCommand _command;
+    std::list<std::pair<bool, StateChangeCommand>> _results;
     mutable Core::CriticalSection _lock;
   };
 
@@ -244,10 +333,20 @@ private:
     }
     virtual ~CobaltWindow()
     {
+      Quit();
+      exit(_exitCode);
+    }
+
+    // Stops the app and waits for the Cobalt thread. Pending state changes
+    // complete as aborted from here.
+    void Quit()
+    {
+      if (_quit)
+        return;
+      _quit = true;
       Block();
       SbRdkQuit();
       Wait(Thread::BLOCKED | Thread::STOPPED | Thread::STOPPING, Core::infinite);
-      exit(_exitCode);
     }
 
     uint32_t Configure(PluginHost::IShell* service) {
@@ -321,6 +420,18 @@ private:
           SbRdkSetSetting("systemproperties", properties.c_str());
       }
 
+      if (config.MemoryProfile.IsSet() == true) {
+        std::string profile;
+        if (config.MemoryProfile.ToString(profile))
+          SbRdkSetSetting("memoryprofile", profile.c_str());
+      }
+
+      if (config.ThreadConfig.IsSet() == true) {
+        std::string threads;
+        if (config.ThreadConfig.ToString(threads))
+          SbRdkSetSetting("threadconfig", threads.c_str());
+      }
+
       SYSLOG(Logging::Notification, (_T("Preload is set to: %s\n"), _preloadEnabled ? "true" : "false"));
 
       if (config.ClosurePolicy.IsSet() == true) {
@@ -337,36 +448,52 @@ private:
         return 0;
       }, this);
 
-      Run();
+      if (config.WarmStart.IsSet() == true) {
+        _warmStart = config.WarmStart.Value();
+      }
+
+      if (_warmStart) {
+        // Stay in standby with the platform layer warming up in the
+        // background, Launch() starts the app.
+        SYSLOG(Logging::Notification, (_T("Warm start enabled, waiting for launch\n")));
+        _preloadEnabled = false;
+        SbRdkWarmUp();
+      } else {
+        Run();
+      }
       return result;
     }
 
-    bool Suspend(const bool suspend)
+    // Starts the app of a warm-start host, |url| replaces the configured one
+    // when not empty.
+    void Launch(const string& url) {
+      if (!url.empty())
+        _url = url;
+      SYSLOG(Logging::Notification, (_T("Launching warm-start host, url: %s\n"), _url.c_str()));
+      Run();
+    }
+
+    void Suspend(const bool suspend, SbRdkTransitionCallbackFunc cb, void* user_data)
     {
       if (suspend == true) {
-        SbRdkSuspend();
+        SbRdkSuspendAsync(cb, user_data);
       }
       else {
-        SbRdkResume();
+        SbRdkResumeAsync(cb, user_data);
       }
-      return (true);
     }
 
-    bool Pause(const bool paused)
+    void Pause(SbRdkTransitionCallbackFunc cb, void* user_data)
     {
-      if (paused == true) {
-        SbRdkPause();
-      }
-      else {
-        SbRdkUnpause();
-      }
-      return (true);
+      SbRdkPauseAsync(cb, user_data);
     }
 
     string Url() const { return _url; }
 
     bool IsPreloadEnabled() const { return _preloadEnabled; }
 
+    bool IsWarmStartEnabled() const { return _warmStart; }
+
     uint16_t AutoSuspendDelayInSeconds() const { return _autoSuspendDelayInSeconds; }
 
   private:
@@ -415,12 +542,164 @@ private:
     }
 
     int _exitCode { 0 };
+    bool _quit { false };
     string _url;
     CobaltImplementation &_parent;
     bool _preloadEnabled { false };
+    bool _warmStart { false };
     uint16_t _autoSuspendDelayInSeconds { 30 };
   };
 
+  // Samples memory usage and CPU time of the well known Cobalt threads from
+  // /proc. CPU load is computed against the previous sample.
+  class ProcessMetrics {
+  private:
+    ProcessMetrics(const ProcessMetrics&) = delete;
+    ProcessMetrics& operator=(const ProcessMetrics&) = delete;
+
+    struct Usage {
+      uint32_t threads { 0 };
+      uint64_t ticks { 0 };
+    };
+
+  public:
+    ProcessMetrics()
+      : _ticksPerSecond(sysconf(_SC_CLK_TCK)) {
+    }
+
+    void Collect(JsonObject& metrics) {
+      Usage usage[kThreadGroupCount];
+      Usage process;
+      ReadThreads(usage, process);
+
+      JsonObject memory;
+      uint64_t rss = 0, pss = 0;
+      ReadMemory(rss, pss);
+      memory.Set(_T("rss"), Core::JSON::Variant(rss));
+      memory.Set(_T("pss"), Core::JSON::Variant(pss));
+      metrics.Set(_T("memory"), memory);
+
+      _lock.Lock();
+      const uint64_t now = Core::Time::Now().Ticks();
+      const uint64_t elapsed = (_lastSample != 0) ? now - _lastSample : 0;
+
+      JsonObject threads;
+      for (size_t i = 0; i < kThreadGroupCount; ++i) {
+        threads.Set(kThreadGroups[i].label, ToJson(usage[i], _lastTicks[i], elapsed));
+        _lastTicks[i] = usage[i].ticks;
+      }
+      metrics.Set(_T("threads"), threads);
+      metrics.Set(_T("process"), ToJson(process, _lastProcessTicks, elapsed));
+      _lastProcessTicks = process.ticks;
+      _lastSample = now;
+      _lock.Unlock();
+    }
+
+  private:
+    JsonObject ToJson(const Usage& usage, uint64_t lastTicks, uint64_t elapsedUs) const {
+      JsonObject result;
+      uint32_t load = 0;
+      if (_ticksPerSecond > 0 && elapsedUs > 0 && usage.ticks > lastTicks) {
+        // Percent of a single core.
+        load = static_cast<uint32_t>(((usage.ticks - lastTicks) * 100 * Core::Time::MicroSecondsPerSecond) /
+                                     (_ticksPerSecond * elapsedUs));
+      }
+      result.Set(_T("threads"), Core::JSON::Variant(usage.threads));
+      result.Set(_T("cputime"), Core::JSON::Variant(
+        _ticksPerSecond > 0 ? (usage.ticks * 1000) / _ticksPerSecond : 0));
+      result.Set(_T("cpu"), Core::JSON::Variant(load));
+      return result;
+    }
+
+    // Fills |comm| and returns utime + stime of a /proc/.../stat file.
+    static bool ReadStat(const char* path, char* comm, size_t commSize, uint64_t& ticks) {
+      char buffer[512];
+      FILE* file = fopen(path, "r");
+      if (file == nullptr)
+        return false;
+      size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+      fclose(file);
+      buffer[length] = '\0';
+
+      char* begin = strchr(buffer, '(');
+      char* end = strrchr(buffer, ')');
+      if (begin == nullptr || end == nullptr || end < begin)
+        return false;
+      size_t commLength = std::min<size_t>(end - begin - 1, commSize - 1);
+      memcpy(comm, begin + 1, commLength);
+      comm[commLength] = '\0';
+
+      unsigned long long utime = 0, stime = 0;
+      if (sscanf(end + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2)
+        return false;
+      ticks = utime + stime;
+      return true;
+    }
+
+    static void ReadThreads(Usage* usage, Usage& process) {
+      char comm[32];
+      uint64_t ticks = 0;
+      if (ReadStat("/proc/self/stat", comm, sizeof(comm), ticks)) {
+        process.ticks = ticks;
+      }
+
+      DIR* dir = opendir("/proc/self/task");
+      if (dir == nullptr)
+        return;
+      struct dirent* entry;
+      while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] == '.')
+          continue;
+        ++process.threads;
+        string path = string("/proc/self/task/") + entry->d_name + "/stat";
+        if (!ReadStat(path.c_str(), comm, sizeof(comm), ticks))
+          continue;
+        for (size_t i = 0; i < kThreadGroupCount; ++i) {
+          if (strcmp(comm, kThreadGroups[i].comm) == 0) {
+            ++usage[i].threads;
+            usage[i].ticks += ticks;
+            break;
+          }
+        }
+      }
+      closedir(dir);
+    }
+
+    // Values in kB. PSS is only known on kernels providing smaps_rollup.
+    static void ReadMemory(uint64_t& rss, uint64_t& pss) {
+      char line[128];
+      unsigned long long value = 0;
+      FILE* file = fopen("/proc/self/smaps_rollup", "r");
+      if (file != nullptr) {
+        while (fgets(line, sizeof(line), file) != nullptr) {
+          if (sscanf(line, "Rss: %llu kB", &value) == 1)
+            rss = value;
+          else if (sscanf(line, "Pss: %llu kB", &value) == 1)
+            pss = value;
+        }
+        fclose(file);
+        if (rss != 0)
+          return;
+      }
+      file = fopen("/proc/self/status", "r");
+      if (file != nullptr) {
+        while (fgets(line, sizeof(line), file) != nullptr) {
+          if (sscanf(line, "VmRSS: %llu kB", &value) == 1) {
+            rss = value;
+            break;
+          }
+        }
+        fclose(file);
+      }
+    }
+
+    const long _ticksPerSecond;
+    Core::CriticalSection _lock;
+    uint64_t _lastSample { 0 };
+    uint64_t _lastTicks[kThreadGroupCount] { };
+    uint64_t _lastProcessTicks { 0 };
+  };
+
 private:
   CobaltImplementation(const CobaltImplementation&) = delete;
   CobaltImplementation& operator=(const CobaltImplementation&) = delete;
@@ -434,15 +713,26 @@ public:
     _cobaltClients(),
     _stateControlClients(),
     _sink(*this),
+    _notifier(*this),
     _delayedSuspend(*this) {
   }
 
   virtual ~CobaltImplementation() {
+    // The aborted state changes are reported through _notifier, which goes
+    // away before _window.
+    _window.Quit();
   }
 
   virtual uint32_t Configure(PluginHost::IShell *service) {
+    // Activation launches the app unless it waits in warm-start standby,
+    // then the resume request does.
+    SbRdkMarkLaunchRequest();
     uint32_t result = _window.Configure(service);
-    if (_window.IsPreloadEnabled()) {
+    if (_window.IsWarmStartEnabled()) {
+      // Reported as suspended until the first resume request launches it.
+      _standby = true;
+      _state = PluginHost::IStateControl::SUSPENDED;
+    } else if (_window.IsPreloadEnabled()) {
       _state = PluginHost::IStateControl::SUSPENDED;
       _statePending = PluginHost::IStateControl::SUSPENDED;
       _delayedSuspend.Schedule(Core::Time::Now().Add(_window.AutoSuspendDelayInSeconds() * 1000));
@@ -454,15 +744,29 @@ public:
 
   virtual void SetURL(const string &URL) override {
     SYSLOG(Logging::Notification, (_T("deeplink=%s\n"), URL.c_str()));
+    _adminLock.Lock();
+    if (_standby) {
+      // Launched with it instead.
+      _standbyURL = URL;
+      _adminLock.Unlock();
+      return;
+    }
+    _adminLock.Unlock();
     SbRdkHandleDeepLink(URL.c_str());
   }
 
   virtual string GetURL() const override {
-    return _window.Url();
+    _adminLock.Lock();
+    string url = _standby && !_standbyURL.empty() ? _standbyURL : _window.Url();
+    _adminLock.Unlock();
+    return url;
   }
 
   virtual uint32_t GetFPS() const override {
-    return 0;
+    JsonObject metrics;
+    if (!GetStarboardMetrics(metrics))
+      return 0;
+    return static_cast<uint32_t>(metrics.Get(_T("fps")).Number());
   }
 
   virtual void Hide(const bool hidden) {
@@ -546,6 +850,10 @@ public:
     } else {
       switch (command) {
         case PluginHost::IStateControl::SUSPEND:
+          if (_standby) {
+            result = Core::ERROR_NONE;
+            break;
+          }
           if (_state == PluginHost::IStateControl::RESUMED || _statePending == PluginHost::IStateControl::RESUMED) {
             _statePending = PluginHost::IStateControl::SUSPENDED;
             _sink.RequestForStateChange(
@@ -554,6 +862,15 @@ public:
           result = Core::ERROR_NONE;
           break;
         case PluginHost::IStateControl::RESUME:
+          if (_standby) {
+            SbRdkMarkLaunchRequest();
+            _standby = false;
+            _window.Launch(_standbyURL);
+            _standbyURL.clear();
+            _adminLock.Unlock();
+            StateChange(PluginHost::IStateControl::RESUMED);
+            return Core::ERROR_NONE;
+          }
           if (_state == PluginHost::IStateControl::SUSPENDED || _statePending == PluginHost::IStateControl::SUSPENDED) {
             _statePending = PluginHost::IStateControl::RESUMED;
             _sink.RequestForStateChange(
@@ -637,6 +954,25 @@ public:
   void Unregister(const string& nameSpace, struct IDictionary::INotification* sink) override  {  }
   IIterator* Get(const string& nameSpace) const override { return nullptr; }
   bool Get(const string& nameSpace, const string& key, string& value /* @out */) const override {
+    if (nameSpace == "metrics") {
+      if (key == "performance") {
+        JsonObject metrics;
+        GetStarboardMetrics(metrics);
+        _processMetrics.Collect(metrics);
+        return metrics.ToString(value);
+      }
+      // "trace": Chrome trace event JSON, empty unless Cobalt runs with
+      // COBALT_TRACE. "decoders": video decoder assignments. "players":
+      // playback stats of the live players.
+      if (key == "trace" || key == "decoders" || key == "players") {
+        char* json = nullptr;
+        if (SbRdkGetSetting(key.c_str(), &json) == 0) {
+          value.assign(json);
+          free(json);
+          return true;
+        }
+      }
+    }
     if (nameSpace == "settings") {
       if (key == "accessibility") {
         char* json = nullptr;
@@ -675,6 +1011,16 @@ public:
   END_INTERFACE_MAP
 
 private:
+  // Frame rate and lifecycle timings tracked by the starboard layer.
+  static bool GetStarboardMetrics(JsonObject& metrics) {
+    char* json = nullptr;
+    if (SbRdkGetSetting("performance", &json) != 0)
+      return false;
+    bool result = metrics.FromString(json);
+    free(json);
+    return result;
+  }
+
   static const char* ToString(const StateChangeCommand command) {
     switch(command) {
       case StateChangeCommand::SUSPEND:
@@ -689,37 +1035,51 @@ private:
     return "unknown";
   }
 
-  inline bool RequestForStateChange(
-    const StateChangeCommand command) {
-    bool result = false;
+  struct StateChangeRequest {
+    CobaltImplementation* parent;
+    StateChangeCommand command;
+  };
+
+  static void StateChangeDone(SbRdkTransitionResult result, int64_t latency, void* user_data) {
+    std::unique_ptr<StateChangeRequest> request(static_cast<StateChangeRequest*>(user_data));
+
+    SYSLOG(Logging::Notification, (_T("Cobalt state change -> %s %s after %dms\n"),
+      ToString(request->command),
+      result == kSbRdkTransitionCompleted ? "completed" :
+      result == kSbRdkTransitionSuperseded ? "superseded" : "aborted",
+      static_cast<int>(latency / 1000)));
 
+    // A later request took over and reports the final state.
+    if (result == kSbRdkTransitionSuperseded)
+      return;
+
+    request->parent->_notifier.StateChangeCompleted(result == kSbRdkTransitionCompleted, request->command);
+  }
+
+  inline void RequestForStateChange(
+    const StateChangeCommand command) {
     SYSLOG(Logging::Notification, (_T("Cobalt request state change -> %s\n"), ToString(command)));
 
+    StateChangeRequest* request = new StateChangeRequest { this, command };
     switch (command) {
       case StateChangeCommand::SUSPEND: {
-        if (_window.Suspend(true) == true) {
-          result = true;
-        }
+        _window.Suspend(true, &StateChangeDone, request);
         break;
       }
       case StateChangeCommand::RESUME: {
         // implies unpause
-        if (_window.Suspend(false) == true) {
-          result = true;
-        }
+        _window.Suspend(false, &StateChangeDone, request);
         break;
       }
       case StateChangeCommand::BACKGROUND: {
-        if (_window.Pause(true) == true) {
-          result = true;
-        }
+        _window.Pause(&StateChangeDone, request);
         break;
       }
       default:
         ASSERT(false);
+        delete request;
         break;
     }
-    return result;
   }
 
   void StateChange(const PluginHost::IStateControl::state newState) {
@@ -758,7 +1118,11 @@ private:
   std::list<Exchange::IBrowser::INotification*> _cobaltClients;
   std::list<PluginHost::IStateControl::INotification*> _stateControlClients;
   NotificationSink _sink;
+  StateChangeNotifier _notifier;
   DelayedSuspend _delayedSuspend;
+  mutable ProcessMetrics _processMetrics;
+  bool _standby { false };
+  string _standbyURL;
 };
 
 SERVICE_REGISTRATION(CobaltImplementation, 1, 0);
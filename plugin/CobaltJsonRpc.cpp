@@ -34,17 +34,19 @@ using namespace JsonData::StateControl;
 void Cobalt::RegisterAll() {
   // Property < Core::JSON::String >    (_T("url"), &Cobalt::get_url, &Cobalt::set_url, this); /* Browser */
   // Property < Core::JSON::EnumType < VisibilityType >> (_T("visibility"), &Cobalt::get_visibility, &Cobalt::set_visibility, this); /* Browser */
-  // Property < Core::JSON::DecUInt32 > (_T("fps"), &Cobalt::get_fps, nullptr, this); /* Browser */
   Register<Core::JSON::String,void>(_T("deeplink"), &Cobalt::endpoint_deeplink, this);
   Property < Core::JSON::EnumType < StateType >> (_T("state"), &Cobalt::get_state, &Cobalt::set_state, this); /* StateControl */
   Property < JsonObject >(_T("accessibility"), &Cobalt::get_accessibility, &Cobalt::set_accessibility, this);
+  Property < Core::JSON::DecUInt32 > (_T("fps"), &Cobalt::get_fps, nullptr, this); /* Browser */
+  Property < JsonObject >(_T("performance"), &Cobalt::get_performance, nullptr, this);
 }
 
 void Cobalt::UnregisterAll() {
   Unregister(_T("deeplink"));
   Unregister(_T("state"));
   Unregister(_T("accessibility"));
-  // Unregister(_T("fps"));
+  Unregister(_T("fps"));
+  Unregister(_T("performance"));
   // Unregister(_T("visibility"));
   // Unregister(_T("url"));
 }
@@ -257,6 +259,36 @@ uint32_t Cobalt::set_accessibility(const JsonObject &param)
   return result;
 }
 
+// Property: performance - Process and rendering metrics
+// Return codes:
+//  - ERROR_NONE: Success
+//  - ERROR_GENERAL: Failed to get metrics
+uint32_t Cobalt::get_performance(JsonObject &response) const
+{
+  ASSERT(_cobalt != nullptr);
+  uint32_t result = Core::ERROR_GENERAL;
+
+  Exchange::IDictionary *dict(
+    _cobalt->QueryInterface<Exchange::IDictionary>());
+  if (dict == nullptr) {
+    SYSLOG(Trace::Error, (_T("IDictionary is not implemented")));
+  } else {
+    std::string json;
+    if (!dict->Get("metrics", "performance", json)) {
+      SYSLOG(Trace::Error, (_T("Cannot get 'performance' metrics")));
+    }
+    else if (!response.FromString(json)) {
+      SYSLOG(Trace::Error, (_T("Cannot convert to JSON object")));
+    }
+    else {
+      result = Core::ERROR_NONE;
+    }
+    dict->Release();
+  }
+
+  return result;
+}
+
 // Event: urlchange - Signals a URL change in the browser
 void Cobalt::event_urlchange(const string &url, const bool &loaded) /* Browser */
 {
@@ -285,6 +317,12 @@ void Cobalt::event_statechange(const bool &suspended) /* StateControl */
   Notify(_T("statechange"), params);
 }
 
+// Event: performance - Periodic process and rendering metrics
+void Cobalt::event_performance(const JsonObject &metrics)
+{
+  Notify(_T("performance"), metrics);
+}
+
 // Event: closure - Notifies that app requested to close its window
 void Cobalt::event_closure() /* Browser */
 {
@@ -0,0 +1,26 @@
+# Copyright 2020 Comcast Cable Communications Management, LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+{
+  'targets': [
+    {
+      'target_name': 'starboard_platform_tests',
+      'type': 'none',
+      'dependencies': [
+        '<(DEPTH)/third_party/starboard/rdk/shared/tools/player_replay/player_replay.gyp:player_replay',
+      ],
+    },
+  ],
+}
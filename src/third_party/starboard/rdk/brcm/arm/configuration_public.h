@@ -278,6 +278,17 @@
 // specify that.
 #define SB_NETWORK_IO_BUFFER_ALIGNMENT 16
 
+// Upper bound, in megabytes, of the memory the RDK memory profile assumes is
+// available to Cobalt when sizing its caches. The effective value is the
+// smallest of this hint, MemTotal and the cgroup memory limit. Set to 0 to
+// rely on runtime detection only.
+#define SB_RDK_MEMORY_PROFILE_HINT_MB 0
+
+// JSON with the default scheduling of Cobalt threads, e.g.
+// "{\"policy\":\"rr\",\"rtpriority\":5,\"highcpus\":\"2-3\"}". Empty
+// keeps real time threads on SCHED_RR and leaves affinity alone.
+#define SB_RDK_THREAD_CONFIG ""
+
 // --- Network Configuration -------------------------------------------------
 
 // Specifies whether this platform supports IPV6.
@@ -75,9 +75,9 @@ const bool kSbHasAc3Audio = true;
 // non-zero on platforms with webm/vp9 support.
 const bool kSbHasMediaWebmVp9Support = false;
 
-// On default Linux desktop, you must be a superuser in order to set real time
-// scheduling on threads.
-const bool kSbHasThreadPrioritySupport = false;
+// Real time scheduling needs CAP_SYS_NICE or an RLIMIT_RTPRIO, without them
+// threads fall back to nice values. See shared/thread_priority.h.
+const bool kSbHasThreadPrioritySupport = true;
 
 // Determines the alignment that allocations should have on this platform.
 const size_t kSbMallocAlignment = 16;
@@ -35,7 +35,10 @@
 #include "starboard/speech_synthesis.h"
 #include "starboard/shared/starboard/audio_sink/audio_sink_internal.h"
 
+#include "third_party/starboard/rdk/shared/media/gst_media_utils.h"
 #include "third_party/starboard/rdk/shared/window/window_internal.h"
+#include "third_party/starboard/rdk/shared/warm_start.h"
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
 #include "third_party/starboard/rdk/shared/log_override.h"
 
 #include <fcntl.h>
@@ -57,6 +60,8 @@ void Teardown();
 
 namespace player {
 void ForceStop();
+void SetAudioOnly(bool audio_only);
+void Prewarm();
 }  // namespace player
 
 EssTerminateListener Application::terminateListener = {
@@ -106,6 +111,20 @@ Application::~Application() {
 }
 
 void Application::Initialize() {
+  StartRDKServicesNotifications();
+
+  // Already done ahead of launch in warm-start mode.
+  if (!WarmStart::IsWarm()) {
+    PrefetchRDKServices();
+
+    prewarm_thread_ =
+      SbThreadCreate(0, kSbThreadPriorityLow, kSbThreadNoAffinity, true,
+                     "player_prewarm", [](void*) -> void* {
+                       player::Prewarm();
+                       return nullptr;
+                     }, nullptr);
+  }
+
   wakeup_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
   if ( wakeup_fd_ == -1 ) {
     SB_LOG(ERROR) << "Failed to create eventfd, error: " << errno << " (" << strerror(errno) << ')';
@@ -131,7 +150,13 @@ void Application::Initialize() {
 }
 
 void Application::Teardown() {
+  if (SbThreadIsValid(prewarm_thread_)) {
+    SbThreadJoin(prewarm_thread_, nullptr);
+    prewarm_thread_ = kSbThreadInvalid;
+  }
+
   SbAudioSinkPrivate::TearDown();
+  media::SaveMediaCapabilities();
   libcobalt_api::Teardown();
   TeardownJSONRPCLink();
 
@@ -150,6 +175,7 @@ Application::PollNextSystemEvent() {
   SbTime now = SbTimeGetMonotonicNow();
   if ((now - ess_loop_last_ts_) > kEssRunLoopPeriod) {
     ess_loop_last_ts_ = now;
+    RDK_TRACE_SCOPE("EssosEventLoop");
     EssContextRunEventLoopOnce( ctx_ );
   }
   return NULL;
@@ -186,6 +212,7 @@ Application::WaitForSystemEventWithTimeout(SbTime time) {
   if ( fds_sz != 0 ) {
     timeout.tv_sec = time / kSbTimeSecond;
     timeout.tv_nsec = (time % kSbTimeSecond) * kSbTimeNanosecondsPerMicrosecond;
+    RDK_TRACE_SCOPE("WaitForSystemEvent");
     rc = ppoll(fds, fds_sz, &timeout, NULL);
   }
 
@@ -245,6 +272,13 @@ void Application::Inject(Event* e) {
   if (e && e->event && e->event->type == kSbEventTypeFreeze) {
     player::ForceStop();
   }
+  // Nothing is visible while concealed, keep background playback to audio.
+  if (e && e->event && e->event->type == kSbEventTypeConceal) {
+    player::SetAudioOnly(true);
+  }
+  if (e && e->event && e->event->type == kSbEventTypeReveal) {
+    player::SetAudioOnly(false);
+  }
 #else
   if (e && e->event && e->event->type == kSbEventTypeSuspend) {
     player::ForceStop();
@@ -256,6 +290,7 @@ void Application::Inject(Event* e) {
 
 void Application::OnSuspend() {
   SbSpeechSynthesisCancel();
+  media::SaveMediaCapabilities();
   DestroyNativeWindow();
   setTimerInterval(ess_timer_fd_, kSbTimeSecond);
 }
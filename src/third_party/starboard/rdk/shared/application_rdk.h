@@ -37,6 +37,7 @@
 #include "starboard/shared/internal_only.h"
 #include "starboard/shared/starboard/application.h"
 #include "starboard/shared/starboard/queue_application.h"
+#include "starboard/thread.h"
 #include "starboard/types.h"
 
 #include "third_party/starboard/rdk/shared/ess_input.h"
@@ -118,6 +119,7 @@ class Application : public ::starboard::shared::starboard::QueueApplication {
   int monitor_timer_fd_ { -1 };
 
   std::unique_ptr<HangMonitor> hang_monitor_ { nullptr };
+  SbThread prewarm_thread_ { kSbThreadInvalid };
 };
 
 }  // namespace shared
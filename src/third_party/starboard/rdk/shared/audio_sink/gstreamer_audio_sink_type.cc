@@ -42,7 +42,9 @@
 #include <gst/audio/streamvolume.h>
 #include <gst/gst.h>
 
+#include "starboard/common/condition_variable.h"
 #include "starboard/common/mutex.h"
+#include "starboard/common/semaphore.h"
 #include "starboard/configuration.h"
 #include "starboard/file.h"
 #include "starboard/media.h"
@@ -51,6 +53,8 @@
 #include "starboard/time.h"
 
 #include "third_party/starboard/rdk/shared/hang_detector.h"
+#include "third_party/starboard/rdk/shared/media/media_event_loop_pool.h"
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
 
 namespace third_party {
 namespace starboard {
@@ -95,7 +99,6 @@ class GStreamerAudioSink : public SbAudioSinkPrivate {
   }
 
  private:
-  static void* AudioThreadEntryPoint(void* context);
   static gboolean BusMessageCallback(GstBus* bus,
                                      GstMessage* message,
                                      gpointer user_data);
@@ -119,17 +122,18 @@ class GStreamerAudioSink : public SbAudioSinkPrivate {
   SbAudioSinkPrivate::ErrorFunc error_func_{nullptr};
   SbAudioSinkFrameBuffers frame_buffers_{nullptr};
   int frame_buffers_size_in_frames_{0};
-  SbThread audio_loop_thread_{kSbThreadInvalid};
   void* context_{nullptr};
   ::starboard::Mutex mutex_;
+  ::starboard::ConditionVariable eos_condition_{mutex_};
   GstElement* pipeline_{nullptr};
   GstElement* appsrc_{nullptr};
   GstElement* queue_{nullptr};
   GstElement* audiosink_{nullptr};
-  GMainLoop* mainloop_{nullptr};
+  // Shared with the players and other sinks, see MediaEventLoopPool.
   GMainContext* main_loop_context_{nullptr};
   guint source_id_{0};
   bool destroying_{false};
+  bool eos_received_{false};
   bool enough_data_{false};
   std::string file_name_;
   int total_frames_{0};
@@ -169,8 +173,8 @@ GStreamerAudioSink::GStreamerAudioSink(
       << "It seems SbAudioSinkIsAudioFrameStorageTypeSupported() was changed "
       << "without adjustng here.";
 
-  main_loop_context_ = g_main_context_new();
-  mainloop_ = g_main_loop_new(main_loop_context_, FALSE);
+  main_loop_context_ = media::MediaEventLoopPool::Acquire();
+  SB_DCHECK(main_loop_context_);
   g_main_context_push_thread_default(main_loop_context_);
 
   GSource* src = g_timeout_source_new(hang_monitor_.GetResetInterval() / kSbTimeMillisecond);
@@ -225,11 +229,6 @@ GStreamerAudioSink::GStreamerAudioSink(
   gst_element_set_state(pipeline_, GST_STATE_PLAYING);
 
   g_main_context_pop_thread_default(main_loop_context_);
-
-  audio_loop_thread_ = SbThreadCreate(
-      0, kSbThreadPriorityRealTime, kSbThreadNoAffinity, true, "audio_loop",
-      &GStreamerAudioSink::AudioThreadEntryPoint, this);
-  SB_DCHECK(SbThreadIsValid(audio_loop_thread_));
 }
 
 GStreamerAudioSink::~GStreamerAudioSink() {
@@ -241,23 +240,26 @@ GStreamerAudioSink::~GStreamerAudioSink() {
     hang_monitor_.Reset();
   }
 
-  GSource* timeout_src = g_timeout_source_new_seconds(1);
-  g_source_set_callback(timeout_src, [](gpointer data) -> gboolean {
-    g_main_loop_quit((GMainLoop*)data);
-    return G_SOURCE_REMOVE;
-  }, mainloop_, nullptr);
-  g_source_attach(timeout_src, main_loop_context_);
-  g_source_unref(timeout_src);
-
-  mutex_.Acquire();
-  destroying_ = true;
-  mutex_.Release();
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    destroying_ = true;
+  }
 
   // this will wake up apprsc if it is waiting for data
   gst_app_src_set_max_bytes(GST_APP_SRC(appsrc_), 1);
 
-  bool rc = SbThreadJoin(audio_loop_thread_, nullptr);
-  SB_DCHECK(rc);
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    SbTimeMonotonic deadline = SbTimeGetMonotonicNow() + kSbTimeSecond;
+    while (!eos_received_) {
+      SbTime remaining = deadline - SbTimeGetMonotonicNow();
+      if (remaining <= 0) {
+        GST_WARNING_OBJECT(pipeline_, "Timed out waiting for EOS");
+        break;
+      }
+      eos_condition_.WaitTimed(remaining);
+    }
+  }
 
   gst_element_set_state(pipeline_, GST_STATE_NULL);
   if (source_id_ > -1) {
@@ -267,22 +269,21 @@ GStreamerAudioSink::~GStreamerAudioSink() {
   GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
   gst_bus_set_sync_handler(bus, nullptr, nullptr, nullptr);
   gst_object_unref(bus);
-  g_main_loop_unref(mainloop_);
-  gst_object_unref(pipeline_);
-  g_main_context_unref(main_loop_context_);
-}
-
-// static
-void* GStreamerAudioSink::AudioThreadEntryPoint(void* context) {
-  SB_DCHECK(context);
 
-  GStreamerAudioSink* sink = reinterpret_cast<GStreamerAudioSink*>(context);
-  GST_TRACE_OBJECT(sink->pipeline_, "TID: %d", SbThreadGetId());
-  g_main_context_push_thread_default(sink->main_loop_context_);
-  sink->hang_monitor_.Reset();
-  g_main_loop_run(sink->mainloop_);
+  // The loop outlives this sink, let a callback that is already being
+  // dispatched finish before the members go away.
+  ::starboard::Semaphore done;
+  GSource* barrier = g_idle_source_new();
+  g_source_set_callback(barrier, [](gpointer data) -> gboolean {
+    static_cast<::starboard::Semaphore*>(data)->Put();
+    return G_SOURCE_REMOVE;
+  }, &done, nullptr);
+  g_source_attach(barrier, main_loop_context_);
+  g_source_unref(barrier);
+  done.Take();
 
-  return nullptr;
+  gst_object_unref(pipeline_);
+  media::MediaEventLoopPool::Release(main_loop_context_);
 }
 
 // static
@@ -299,8 +300,11 @@ gboolean GStreamerAudioSink::BusMessageCallback(GstBus* bus,
     case GST_MESSAGE_EOS:
       if (GST_MESSAGE_SRC(message) == GST_OBJECT(sink->pipeline_)) {
         GST_INFO_OBJECT(sink->pipeline_, "EOS");
-        if (sink->destroying_)
-          g_main_loop_quit(sink->mainloop_);
+        ::starboard::ScopedLock lock(sink->mutex_);
+        if (sink->destroying_) {
+          sink->eos_received_ = true;
+          sink->eos_condition_.Broadcast();
+        }
       }
       break;
 
@@ -392,6 +396,8 @@ void GStreamerAudioSink::AppSrcNeedData(GstAppSrc* src,
       frames_to_write = std::min(kFramesPerRequest, frames_to_write);
 
       if (is_playing && frames_to_write > 0) {
+          RDK_TRACE_SCOPE("AudioPush");
+          RDK_TRACE_COUNTER("AudioFramesInBuffer", frames_in_buffer);
           GstBuffer* buffer = gst_buffer_new_allocate(
               nullptr, frames_to_write * sink->GetBytesPerFrame(), nullptr);
           uint8_t* beginning = static_cast<uint8_t*>(sink->frame_buffers_[0]) +
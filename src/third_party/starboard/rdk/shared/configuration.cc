@@ -34,6 +34,7 @@
 #include "starboard/common/configuration_defaults.h"
 
 #include "third_party/starboard/rdk/shared/libcobalt.h"
+#include "third_party/starboard/rdk/shared/memory_profile.h"
 
 namespace third_party {
 namespace starboard {
@@ -50,6 +51,60 @@ const char* CobaltUserOnExitStrategy() {
   return SbRdkGetCobaltExitStrategy();
 }
 
+int CobaltSkiaCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kSkiaCache,
+    ::starboard::common::CobaltSkiaCacheSizeInBytesDefault());
+}
+
+int CobaltOffscreenTargetCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kOffscreenTargetCache,
+    ::starboard::common::CobaltOffscreenTargetCacheSizeInBytesDefault());
+}
+
+int CobaltEncodedImageCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kEncodedImageCache,
+    ::starboard::common::CobaltEncodedImageCacheSizeInBytesDefault());
+}
+
+int CobaltImageCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kImageCache,
+    ::starboard::common::CobaltImageCacheSizeInBytesDefault());
+}
+
+int CobaltLocalTypefaceCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kLocalTypefaceCache,
+    ::starboard::common::CobaltLocalTypefaceCacheSizeInBytesDefault());
+}
+
+int CobaltRemoteTypefaceCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kRemoteTypefaceCache,
+    ::starboard::common::CobaltRemoteTypefaceCacheSizeInBytesDefault());
+}
+
+int CobaltMeshCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kMeshCache,
+    ::starboard::common::CobaltMeshCacheSizeInBytesDefault());
+}
+
+int CobaltSoftwareSurfaceCacheSizeInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kSoftwareSurfaceCache,
+    ::starboard::common::CobaltSoftwareSurfaceCacheSizeInBytesDefault());
+}
+
+int64_t CobaltJsGarbageCollectionThresholdInBytes() {
+  return MemoryProfile::GetCacheSizeInBytes(
+    MemoryProfile::kJsGarbageCollectionThreshold,
+    ::starboard::common::CobaltJsGarbageCollectionThresholdInBytesDefault());
+}
+
 const CobaltExtensionConfigurationApi kConfigurationApi = {
     kCobaltExtensionConfigurationName,
     2,
@@ -58,18 +113,18 @@ const CobaltExtensionConfigurationApi kConfigurationApi = {
     &::starboard::common::CobaltEglSwapIntervalDefault,
     &::starboard::common::CobaltFallbackSplashScreenUrlDefault,
     &CobaltEnableQuic,
-    &::starboard::common::CobaltSkiaCacheSizeInBytesDefault,
-    &::starboard::common::CobaltOffscreenTargetCacheSizeInBytesDefault,
-    &::starboard::common::CobaltEncodedImageCacheSizeInBytesDefault,
-    &::starboard::common::CobaltImageCacheSizeInBytesDefault,
-    &::starboard::common::CobaltLocalTypefaceCacheSizeInBytesDefault,
-    &::starboard::common::CobaltRemoteTypefaceCacheSizeInBytesDefault,
-    &::starboard::common::CobaltMeshCacheSizeInBytesDefault,
-    &::starboard::common::CobaltSoftwareSurfaceCacheSizeInBytesDefault,
+    &CobaltSkiaCacheSizeInBytes,
+    &CobaltOffscreenTargetCacheSizeInBytes,
+    &CobaltEncodedImageCacheSizeInBytes,
+    &CobaltImageCacheSizeInBytes,
+    &CobaltLocalTypefaceCacheSizeInBytes,
+    &CobaltRemoteTypefaceCacheSizeInBytes,
+    &CobaltMeshCacheSizeInBytes,
+    &CobaltSoftwareSurfaceCacheSizeInBytes,
     &::starboard::common::CobaltImageCacheCapacityMultiplierWhenPlayingVideoDefault,
     &::starboard::common::CobaltSkiaGlyphAtlasWidthDefault,
     &::starboard::common::CobaltSkiaGlyphAtlasHeightDefault,
-    &::starboard::common::CobaltJsGarbageCollectionThresholdInBytesDefault,
+    &CobaltJsGarbageCollectionThresholdInBytes,
     &::starboard::common::CobaltReduceCpuMemoryByDefault,
     &::starboard::common::CobaltReduceGpuMemoryByDefault,
     &::starboard::common::CobaltGcZealDefault,
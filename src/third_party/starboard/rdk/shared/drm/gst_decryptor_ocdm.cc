@@ -18,6 +18,7 @@
 
 #if defined(HAS_OCDM)
 #include "third_party/starboard/rdk/shared/drm/drm_system_ocdm.h"
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
 
 #include "starboard/common/mutex.h"
 #include "starboard/common/condition_variable.h"
@@ -219,10 +220,14 @@ struct _CobaltOcdmDecryptorPrivate : public DrmSystemOcdm::Observer {
     }
 #endif
 
-    int rc = drm_system_->Decrypt(
-      current_session_id_, buffer,
-      subsamples, subsample_count,
-      iv, key, caps);
+    int rc;
+    {
+      RDK_TRACE_SCOPE("Decrypt");
+      rc = drm_system_->Decrypt(
+        current_session_id_, buffer,
+        subsamples, subsample_count,
+        iv, key, caps);
+    }
 
     if ( caps ) {
       gst_caps_unref(caps);
@@ -32,11 +32,18 @@
 #include "starboard/common/log.h"
 
 #include "third_party/starboard/rdk/shared/application_rdk.h"
+#include "third_party/starboard/rdk/shared/performance_metrics.h"
 
 #include <essos-app.h>
 
 extern "C" EGLDisplay __real_eglGetDisplay(EGLNativeDisplayType native_display);
 extern "C" SB_EXPORT_PLATFORM EGLDisplay __wrap_eglGetDisplay(EGLNativeDisplayType native_display);
+extern "C" EGLBoolean __real_eglSwapBuffers(EGLDisplay display, EGLSurface surface);
+extern "C" SB_EXPORT_PLATFORM EGLBoolean __wrap_eglSwapBuffers(EGLDisplay display, EGLSurface surface);
+extern "C" EGLBoolean __real_eglSwapInterval(EGLDisplay display, EGLint interval);
+extern "C" SB_EXPORT_PLATFORM EGLBoolean __wrap_eglSwapInterval(EGLDisplay display, EGLint interval);
+
+using third_party::starboard::rdk::shared::PerformanceMetrics;
 
 extern "C" SB_EXPORT_PLATFORM EGLDisplay __wrap_eglGetDisplay(
     EGLNativeDisplayType native_display) {
@@ -46,3 +53,22 @@ extern "C" SB_EXPORT_PLATFORM EGLDisplay __wrap_eglGetDisplay(
     return __real_eglGetDisplay(reinterpret_cast<EGLNativeDisplayType>(display_type));
   return __real_eglGetDisplay(native_display);
 }
+
+extern "C" SB_EXPORT_PLATFORM EGLBoolean __wrap_eglSwapBuffers(
+    EGLDisplay display, EGLSurface surface) {
+  EGLBoolean result = __real_eglSwapBuffers(display, surface);
+  if (result == EGL_TRUE) {
+    PerformanceMetrics::OnFrameRendered();
+    // Applied here, on the thread the context is current on.
+    int interval;
+    if (PerformanceMetrics::TakeSwapIntervalChange(interval))
+      __real_eglSwapInterval(display, interval);
+  }
+  return result;
+}
+
+extern "C" SB_EXPORT_PLATFORM EGLBoolean __wrap_eglSwapInterval(
+    EGLDisplay display, EGLint interval) {
+  return __real_eglSwapInterval(
+    display, PerformanceMetrics::OnSwapIntervalRequested(interval));
+}
@@ -31,6 +31,7 @@
 #include "starboard/common/mutex.h"
 
 #include "third_party/starboard/rdk/shared/log_override.h"
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
 
 namespace third_party {
 namespace starboard {
@@ -101,7 +102,7 @@ struct HangDetector
       return;
 
     thread_ =
-      SbThreadCreate(0, kSbThreadNoPriority, kSbThreadNoAffinity, true,
+      SbThreadCreate(0, kSbThreadPriorityHigh, kSbThreadNoAffinity, true,
                      "hangdetector_thread", &HangDetector::ThreadEntryPoint, this);
     SB_DCHECK(SbThreadIsValid(thread_));
   }
@@ -135,6 +136,7 @@ struct HangDetector
       SbTimeMonotonic now = SbTimeGetMonotonicNow();
       if ( now > next_check ) {
         next_check = now + check_interval_;
+        bool dump_trace = false;
 
         for (const auto& m : monitors_) {
           if ( m->GetExpirationTime() > now )
@@ -143,19 +145,31 @@ struct HangDetector
           pid_t tid = m->GetTID();
           std::string name = m->Name();
 
-          if ( m->IncExpirationCount() < kMaxExpirationCount ) {
+          int expiration_count = m->IncExpirationCount();
+          if ( expiration_count < kMaxExpirationCount ) {
             print_action( pid, tid, name );
+            // The start of the stall is still in the trace buffers.
+            dump_trace |= (expiration_count == 1);
             continue;
           }
 
           mutex_.Release();
+          if ( TraceRecorder::IsEnabled() )
+            TraceRecorder::Dump();
           kill_action( pid, tid, name );
           mutex_.Acquire();
 
           running_ = false;
+          dump_trace = false;
           SB_CHECK(false);
           break;
         }
+
+        if ( dump_trace && TraceRecorder::IsEnabled() ) {
+          mutex_.Release();
+          TraceRecorder::Dump();
+          mutex_.Acquire();
+        }
       }
     }
   }
@@ -18,6 +18,8 @@
 #include "third_party/starboard/rdk/shared/libcobalt.h"
 
 #include <cstring>
+#include <memory>
+#include <vector>
 
 #include "starboard/common/condition_variable.h"
 #include "starboard/common/mutex.h"
@@ -25,9 +27,17 @@
 #include "starboard/once.h"
 #include "starboard/memory.h"
 #include "starboard/string.h"
+#include "starboard/time.h"
 
 #include "third_party/starboard/rdk/shared/rdkservices.h"
+#include "third_party/starboard/rdk/shared/memory_profile.h"
+#include "third_party/starboard/rdk/shared/performance_metrics.h"
+#include "third_party/starboard/rdk/shared/thread_priority.h"
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
+#include "third_party/starboard/rdk/shared/media/decoder_arbiter.h"
+#include "third_party/starboard/rdk/shared/player/player_internal.h"
 #include "third_party/starboard/rdk/shared/application_rdk.h"
+#include "third_party/starboard/rdk/shared/warm_start.h"
 
 using namespace third_party::starboard::rdk::shared;
 
@@ -46,12 +56,24 @@ struct APIContext
     starboard::ScopedLock lock(mutex_);
     running_ = (nullptr != Application::Get());
     condition_.Broadcast();
+    DispatchPendingLocked(lock);
   }
 
   void OnTeardown()
   {
-    starboard::ScopedLock lock(mutex_);
-    running_ = false;
+    Waiters aborted;
+    {
+      starboard::ScopedLock lock(mutex_);
+      running_ = false;
+      // The app won't report events still in its queue.
+      if (in_flight_)
+        aborted.swap(in_flight_->waiters);
+      if (pending_)
+        aborted.insert(aborted.end(), pending_->waiters.begin(), pending_->waiters.end());
+      in_flight_.reset();
+      pending_.reset();
+    }
+    Complete(aborted, kSbRdkTransitionAborted);
   }
 
   void SendLink(const char* link)
@@ -61,83 +83,44 @@ struct APIContext
     Application::Get()->Link(link);
   }
 
-  void RequestSuspend() {
-    starboard::ScopedLock lock(mutex_);
-    WaitForApp(lock);
-    starboard::Semaphore sem;
-#if SB_API_VERSION >= 13
-    Application::Get()->Freeze(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#else
-    Application::Get()->Suspend(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#endif
-    sem.Take();
-  }
-
-  void RequestResume() {
-    starboard::ScopedLock lock(mutex_);
-    WaitForApp(lock);
-    starboard::Semaphore sem;
-#if SB_API_VERSION >= 13
-    Application::Get()->Focus(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#else
-    Application::Get()->Unpause(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#endif
-    sem.Take();
-  }
-
-  void RequestPause() {
-    starboard::ScopedLock lock(mutex_);
-    WaitForApp(lock);
-    starboard::Semaphore sem;
-#if SB_API_VERSION >= 13
-    Application::Get()->Blur(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#else
-    Application::Get()->Pause(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#endif
-    sem.Take();
+  // Queues a lifecycle transition. At most one is handed to the app at a
+  // time; a request for the state the app is already heading to joins it,
+  // any other replaces the one still waiting.
+  void RequestTransition(PerformanceMetrics::Transition transition,
+                         SbRdkTransitionCallbackFunc cb, void* user_data) {
+    Waiters superseded;
+    {
+      starboard::ScopedLock lock(mutex_);
+      Waiter waiter { cb, user_data, SbTimeGetMonotonicNow() };
+      if (in_flight_ && GetTarget(in_flight_->transition) == GetTarget(transition)) {
+        if (pending_) {
+          superseded.swap(pending_->waiters);
+          pending_.reset();
+        }
+        in_flight_->waiters.push_back(waiter);
+      } else if (pending_) {
+        if (GetTarget(pending_->transition) != GetTarget(transition)) {
+          superseded.swap(pending_->waiters);
+          pending_->transition = transition;
+        }
+        pending_->waiters.push_back(waiter);
+      } else {
+        pending_.reset(new PendingTransition(transition));
+        pending_->waiters.push_back(waiter);
+      }
+      DispatchPendingLocked(lock);
+    }
+    Complete(superseded, kSbRdkTransitionSuperseded);
   }
 
-  void RequestUnpause() {
-    starboard::ScopedLock lock(mutex_);
-    WaitForApp(lock);
+  void RequestTransitionAndWait(PerformanceMetrics::Transition transition) {
     starboard::Semaphore sem;
-#if SB_API_VERSION >= 13
-    Application::Get()->Focus(
-      &sem,
-      [](void* ctx) {
-        reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#else
-    Application::Get()->Unpause(
-      &sem,
-      [](void* ctx) {
+    RequestTransition(
+      transition,
+      [](SbRdkTransitionResult, SbTime, void* ctx) {
         reinterpret_cast<starboard::Semaphore*>(ctx)->Put();
-      });
-#endif
+      },
+      &sem);
     sem.Take();
   }
 
@@ -230,6 +213,106 @@ struct APIContext
   }
 
 private:
+  enum Target {
+    kTargetStarted,
+    kTargetPaused,
+    kTargetSuspended,
+  };
+
+  struct Waiter {
+    SbRdkTransitionCallbackFunc cb;
+    void* user_data;
+    SbTimeMonotonic requested;
+  };
+  typedef std::vector<Waiter> Waiters;
+
+  struct PendingTransition {
+    explicit PendingTransition(PerformanceMetrics::Transition transition)
+      : transition(transition) { }
+
+    PerformanceMetrics::Transition transition;
+    Waiters waiters;
+    SbTimeMonotonic started { 0 };
+  };
+
+  static Target GetTarget(PerformanceMetrics::Transition transition)
+  {
+    switch (transition) {
+      case PerformanceMetrics::kSuspend:
+        return kTargetSuspended;
+      case PerformanceMetrics::kPause:
+        return kTargetPaused;
+      default:
+        break;
+    }
+    return kTargetStarted;
+  }
+
+  static void Complete(const Waiters& waiters, SbRdkTransitionResult result)
+  {
+    SbTimeMonotonic now = SbTimeGetMonotonicNow();
+    for (const Waiter& waiter : waiters) {
+      if (waiter.cb)
+        waiter.cb(result, now - waiter.requested, waiter.user_data);
+    }
+  }
+
+  void DispatchPendingLocked(starboard::ScopedLock &)
+  {
+    if (!running_ || in_flight_ || !pending_)
+      return;
+
+    in_flight_ = std::move(pending_);
+    in_flight_->started = SbTimeGetMonotonicNow();
+
+    auto done = [](void* ctx) {
+      reinterpret_cast<APIContext*>(ctx)->OnTransitionDone();
+    };
+    switch (GetTarget(in_flight_->transition)) {
+#if SB_API_VERSION >= 13
+      case kTargetSuspended:
+        Application::Get()->Freeze(this, done);
+        break;
+      case kTargetPaused:
+        Application::Get()->Blur(this, done);
+        break;
+      case kTargetStarted:
+        Application::Get()->Focus(this, done);
+        break;
+#else
+      case kTargetSuspended:
+        Application::Get()->Suspend(this, done);
+        break;
+      case kTargetPaused:
+        Application::Get()->Pause(this, done);
+        break;
+      case kTargetStarted:
+        Application::Get()->Unpause(this, done);
+        break;
+#endif
+    }
+  }
+
+  // Runs on the app thread once the in-flight transition was handled.
+  void OnTransitionDone()
+  {
+    Waiters waiters;
+    PerformanceMetrics::Transition transition;
+    SbTime duration;
+    {
+      starboard::ScopedLock lock(mutex_);
+      if (!in_flight_)
+        return;
+      transition = in_flight_->transition;
+      duration = SbTimeGetMonotonicNow() - in_flight_->started;
+      waiters.swap(in_flight_->waiters);
+      in_flight_.reset();
+      DispatchPendingLocked(lock);
+    }
+    PerformanceMetrics::RecordTransition(transition, duration);
+    Complete(waiters, kSbRdkTransitionCompleted);
+  }
+
   void WaitForApp(starboard::ScopedLock &)
   {
     while ( running_ == false )
@@ -244,6 +327,8 @@ private:
   SbRdkCallbackFunc conceal_request_cb_ { nullptr };
   void* conceal_request_cb_data_ { nullptr };
   std::string exit_strategy_ { "stop" };
+  std::unique_ptr<PendingTransition> in_flight_;
+  std::unique_ptr<PendingTransition> pending_;
 };
 
 SB_ONCE_INITIALIZE_FUNCTION(APIContext, GetContext);
@@ -279,19 +364,35 @@ void SbRdkHandleDeepLink(const char* link) {
 }
 
 void SbRdkSuspend() {
-  GetContext()->RequestSuspend();
+  GetContext()->RequestTransitionAndWait(PerformanceMetrics::kSuspend);
 }
 
 void SbRdkResume() {
-  GetContext()->RequestResume();
+  GetContext()->RequestTransitionAndWait(PerformanceMetrics::kResume);
 }
 
 void SbRdkPause() {
-  GetContext()->RequestPause();
+  GetContext()->RequestTransitionAndWait(PerformanceMetrics::kPause);
 }
 
 void SbRdkUnpause() {
-  GetContext()->RequestUnpause();
+  GetContext()->RequestTransitionAndWait(PerformanceMetrics::kUnpause);
+}
+
+void SbRdkSuspendAsync(SbRdkTransitionCallbackFunc cb, void* user_data) {
+  GetContext()->RequestTransition(PerformanceMetrics::kSuspend, cb, user_data);
+}
+
+void SbRdkResumeAsync(SbRdkTransitionCallbackFunc cb, void* user_data) {
+  GetContext()->RequestTransition(PerformanceMetrics::kResume, cb, user_data);
+}
+
+void SbRdkPauseAsync(SbRdkTransitionCallbackFunc cb, void* user_data) {
+  GetContext()->RequestTransition(PerformanceMetrics::kPause, cb, user_data);
+}
+
+void SbRdkUnpauseAsync(SbRdkTransitionCallbackFunc cb, void* user_data) {
+  GetContext()->RequestTransition(PerformanceMetrics::kUnpause, cb, user_data);
 }
 
 void SbRdkQuit() {
@@ -308,6 +409,12 @@ void SbRdkSetSetting(const char* key, const char* json) {
   else if (strcmp(key, "systemproperties") == 0) {
     SystemProperties::SetSettings(json);
   }
+  else if (strcmp(key, "memoryprofile") == 0) {
+    MemoryProfile::SetSettings(json);
+  }
+  else if (strcmp(key, "threadconfig") == 0) {
+    ThreadPriority::SetSettings(json);
+  }
 }
 
 int SbRdkGetSetting(const char* key, char** out_json) {
@@ -323,6 +430,24 @@ int SbRdkGetSetting(const char* key, char** out_json) {
   else if (strcmp(key, "systemproperties") == 0) {
     result = SystemProperties::GetSettings(tmp);
   }
+  else if (strcmp(key, "memoryprofile") == 0) {
+    result = MemoryProfile::GetSettings(tmp);
+  }
+  else if (strcmp(key, "threadconfig") == 0) {
+    result = ThreadPriority::GetSettings(tmp);
+  }
+  else if (strcmp(key, "performance") == 0) {
+    result = PerformanceMetrics::GetMetrics(tmp);
+  }
+  else if (strcmp(key, "trace") == 0) {
+    result = TraceRecorder::Export(tmp);
+  }
+  else if (strcmp(key, "decoders") == 0) {
+    result = media::DecoderArbiter::GetState(tmp);
+  }
+  else if (strcmp(key, "players") == 0) {
+    result = player::GetPlayerStats(tmp);
+  }
 
   if (result && !tmp.empty()) {
     char *out = (char*)malloc(tmp.size() + 1);
@@ -359,4 +484,12 @@ const char* SbRdkGetCobaltExitStrategy() {
   return GetContext()->GetCobaltExitStrategy();
 }
 
+void SbRdkWarmUp() {
+  WarmStart::Begin();
+}
+
+void SbRdkMarkLaunchRequest() {
+  PerformanceMetrics::OnLaunchRequested();
+}
+
 }  // extern "C"
@@ -18,16 +18,40 @@
 #define THIRD_PARTY_STARBOARD_RDK_SHARED_LIBCOBALT_H_
 
 #include "starboard/export.h"
+#include "starboard/time.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 SB_EXPORT_PLATFORM void SbRdkHandleDeepLink(const char* link);
+// Block until the app is running and the transition finished.
 SB_EXPORT_PLATFORM void SbRdkSuspend();
 SB_EXPORT_PLATFORM void SbRdkResume();
 SB_EXPORT_PLATFORM void SbRdkPause();
 SB_EXPORT_PLATFORM void SbRdkUnpause();
+
+typedef enum SbRdkTransitionResult {
+  kSbRdkTransitionCompleted,
+  // Replaced by a request for another state before it was started.
+  kSbRdkTransitionSuperseded,
+  // The app stopped first.
+  kSbRdkTransitionAborted,
+} SbRdkTransitionResult;
+
+// |latency| is the time from the request to its result. Invoked on the app
+// thread, or on the requesting thread for superseded requests; must not
+// block.
+typedef void (*SbRdkTransitionCallbackFunc)(SbRdkTransitionResult result, SbTime latency, void* user_data);
+
+// Non-blocking variants, |cb| (may be null) is invoked exactly once.
+// Transitions are handed to the app one at a time: a request for the state
+// the app is already heading to joins that transition, otherwise it
+// replaces the one still waiting.
+SB_EXPORT_PLATFORM void SbRdkSuspendAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
+SB_EXPORT_PLATFORM void SbRdkResumeAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
+SB_EXPORT_PLATFORM void SbRdkPauseAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
+SB_EXPORT_PLATFORM void SbRdkUnpauseAsync(SbRdkTransitionCallbackFunc cb, void* user_data);
 SB_EXPORT_PLATFORM void SbRdkQuit();
 SB_EXPORT_PLATFORM void SbRdkSetSetting(const char* key, const char* json);
 SB_EXPORT_PLATFORM int  SbRdkGetSetting(const char* key, char** out_json);  // caller is responsible to free
@@ -41,6 +65,15 @@ SB_EXPORT_PLATFORM void SbRdkRequestConceal();
 SB_EXPORT_PLATFORM void SbRdkSetCobaltExitStrategy(const char* strategy);
 SB_EXPORT_PLATFORM const char* SbRdkGetCobaltExitStrategy();
 
+// Pre-initializes the platform layer in the background ahead of
+// StarboardMain(). Call after the environment has been set up.
+SB_EXPORT_PLATFORM void SbRdkWarmUp();
+
+// Marks the arrival of the request that launches the app, the start of the
+// reported launch latency. Call when the request arrives, ahead of
+// StarboardMain().
+SB_EXPORT_PLATFORM void SbRdkMarkLaunchRequest();
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
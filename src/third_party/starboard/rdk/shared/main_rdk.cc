@@ -38,6 +38,8 @@
 #include "starboard/shared/signal/suspend_signals.h"
 
 #include "third_party/starboard/rdk/shared/application_rdk.h"
+#include "third_party/starboard/rdk/shared/performance_metrics.h"
+#include "third_party/starboard/rdk/shared/warm_start.h"
 
 namespace third_party {
 namespace starboard {
@@ -73,6 +75,10 @@ static void UninstallStopSignalHandlers() {
 extern "C" SB_EXPORT_PLATFORM int main(int argc, char** argv) {
   tzset();
 
+  using third_party::starboard::rdk::shared::PerformanceMetrics;
+  using third_party::starboard::rdk::shared::WarmStart;
+  PerformanceMetrics::OnLaunch(WarmStart::Finish());
+
   GError* error = NULL;
   gst_init_check(NULL, NULL, &error);
   g_free(error);
@@ -0,0 +1,335 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "third_party/starboard/rdk/shared/media/decoder_arbiter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <core/JSON.h>
+
+#include "starboard/once.h"
+#include "starboard/time.h"
+#include "starboard/common/mutex.h"
+#include "third_party/starboard/rdk/shared/media/gst_media_utils.h"
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+using namespace WPEFramework;
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+namespace {
+
+const int kDefaultPrimaryDecoders = 1;
+const int kDefaultSecondaryDecoders = 1;
+const int kDefaultSecondaryMaxHeight = 1080;
+
+int GetEnvInt(const char* name, int default_value) {
+  const char* value = getenv(name);
+  if (value == nullptr || *value == '\0')
+    return default_value;
+  return std::max(0, atoi(value));
+}
+
+const char* CodecName(SbMediaVideoCodec codec) {
+  switch (codec) {
+    case kSbMediaVideoCodecH264: return "h264";
+    case kSbMediaVideoCodecH265: return "h265";
+    case kSbMediaVideoCodecVp9: return "vp9";
+    case kSbMediaVideoCodecAv1: return "av1";
+    default: break;
+  }
+  return "other";
+}
+
+const char* DecoderName(DecoderArbiter::Decoder decoder) {
+  switch (decoder) {
+    case DecoderArbiter::kPrimary: return "primary";
+    case DecoderArbiter::kSecondary: return "secondary";
+    case DecoderArbiter::kUnreserved: return "unreserved";
+    default: break;
+  }
+  return "none";
+}
+
+class Arbiter {
+public:
+  struct PoolData : public Core::JSON::Container {
+    PoolData()
+      : Core::JSON::Container() {
+      Add(_T("capacity"), &Capacity);
+      Add(_T("used"), &Used);
+    }
+    PoolData(const PoolData&) = delete;
+    PoolData& operator=(const PoolData&) = delete;
+
+    Core::JSON::DecUInt32 Capacity;
+    Core::JSON::DecUInt32 Used;
+  };
+
+  struct PlayerData : public Core::JSON::Container {
+    PlayerData()
+      : Core::JSON::Container() {
+      Init();
+    }
+    PlayerData(const PlayerData& other)
+      : Core::JSON::Container()
+      , Codec(other.Codec)
+      , Width(other.Width)
+      , Height(other.Height)
+      , Decoder(other.Decoder)
+      , Visible(other.Visible) {
+      Init();
+    }
+    PlayerData& operator=(const PlayerData& other) {
+      Codec = other.Codec;
+      Width = other.Width;
+      Height = other.Height;
+      Decoder = other.Decoder;
+      Visible = other.Visible;
+      return *this;
+    }
+
+    Core::JSON::String Codec;
+    Core::JSON::DecUInt32 Width;
+    Core::JSON::DecUInt32 Height;
+    Core::JSON::String Decoder;
+    Core::JSON::Boolean Visible;
+
+  private:
+    void Init() {
+      Add(_T("codec"), &Codec);
+      Add(_T("width"), &Width);
+      Add(_T("height"), &Height);
+      Add(_T("decoder"), &Decoder);
+      Add(_T("visible"), &Visible);
+    }
+  };
+
+  struct StateData : public Core::JSON::Container {
+    StateData()
+      : Core::JSON::Container() {
+      Add(_T("primary"), &Primary);
+      Add(_T("secondary"), &Secondary);
+      Add(_T("preempted"), &Preempted);
+      Add(_T("downgraded"), &Downgraded);
+      Add(_T("unreserved"), &Unreserved);
+      Add(_T("rejected"), &Rejected);
+      Add(_T("players"), &Players);
+    }
+    StateData(const StateData&) = delete;
+    StateData& operator=(const StateData&) = delete;
+
+    PoolData Primary;
+    PoolData Secondary;
+    Core::JSON::DecUInt32 Preempted;
+    Core::JSON::DecUInt32 Downgraded;
+    Core::JSON::DecUInt32 Unreserved;
+    Core::JSON::DecUInt32 Rejected;
+    Core::JSON::ArrayType<PlayerData> Players;
+  };
+
+  Arbiter()
+    : primary_capacity_(std::max(1, GetEnvInt("COBALT_PRIMARY_VIDEO_DECODERS", kDefaultPrimaryDecoders)))
+    , secondary_capacity_(GetEnvInt("COBALT_SECONDARY_VIDEO_DECODERS", kDefaultSecondaryDecoders))
+    , secondary_max_height_(GetEnvInt("COBALT_SECONDARY_VIDEO_DECODER_MAX_HEIGHT", kDefaultSecondaryMaxHeight)) {
+    SB_LOG(INFO) << "Video decoders: " << primary_capacity_ << " primary, "
+                 << secondary_capacity_ << " secondary (up to "
+                 << secondary_max_height_ << " lines)";
+  }
+
+  DecoderArbiter::Decoder Acquire(void* owner,
+                                  SbMediaVideoCodec codec,
+                                  const char* max_video_capabilities,
+                                  DecoderArbiter::PreemptFunc preempt_func) {
+    Entry entry;
+    entry.owner = owner;
+    entry.codec = codec;
+    entry.preempt_func = preempt_func;
+    entry.since = SbTimeGetMonotonicNow();
+
+    const bool limited = IsLimitedVideoCapabilities(max_video_capabilities);
+    if (limited) {
+      entry.width = GetVideoCapability(max_video_capabilities, "width");
+      entry.height = GetVideoCapability(max_video_capabilities, "height");
+    }
+
+    void* preempted_owner = nullptr;
+    DecoderArbiter::PreemptFunc preempted_func = nullptr;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      if (!limited) {
+        if (CountUsed(DecoderArbiter::kPrimary) < primary_capacity_) {
+          entry.decoder = DecoderArbiter::kPrimary;
+        } else if (Entry* hidden = FindOldestHiddenPrimary()) {
+          SB_LOG(INFO) << "Preempting primary decoder of hidden " << CodecName(hidden->codec)
+                       << " player " << hidden->owner;
+          // Stays listed without a decoder until the player is destroyed.
+          hidden->decoder = DecoderArbiter::kNone;
+          preempted_owner = hidden->owner;
+          preempted_func = hidden->preempt_func;
+          ++preempted_;
+          entry.decoder = DecoderArbiter::kPrimary;
+        } else if (CountUsed(DecoderArbiter::kSecondary) < secondary_capacity_) {
+          SB_LOG(WARNING) << "Primary decoders are in use by visible players, "
+                          << CodecName(codec) << " player gets a secondary decoder";
+          ++downgraded_;
+          entry.decoder = DecoderArbiter::kSecondary;
+        } else {
+          SB_LOG(WARNING) << "No decoder left for " << CodecName(codec)
+                          << " player, all are in use by visible players";
+        }
+      } else if (entry.height <= secondary_max_height_ &&
+                 CountUsed(DecoderArbiter::kSecondary) < secondary_capacity_) {
+        entry.decoder = DecoderArbiter::kSecondary;
+      } else {
+        SB_LOG(WARNING) << "No secondary decoder fits " << CodecName(codec) << ' ' << entry.height
+                        << " lines preview, running it without a reserved decoder";
+        ++unreserved_;
+        entry.decoder = DecoderArbiter::kUnreserved;
+      }
+
+      if (entry.decoder == DecoderArbiter::kNone) {
+        ++rejected_;
+        return DecoderArbiter::kNone;
+      }
+
+      SB_LOG(INFO) << "Assigned " << DecoderName(entry.decoder) << " decoder to "
+                   << CodecName(codec) << " player " << owner;
+      entries_.push_back(entry);
+    }
+
+    // The owner checks it is still alive, it may be going away concurrently.
+    if (preempted_func)
+      preempted_func(preempted_owner);
+    return entry.decoder;
+  }
+
+  void Release(void* owner) {
+    ::starboard::ScopedLock lock(mutex_);
+    entries_.erase(
+      std::remove_if(entries_.begin(), entries_.end(),
+                     [owner](const Entry& entry) { return entry.owner == owner; }),
+      entries_.end());
+  }
+
+  void SetVisible(void* owner, bool visible) {
+    ::starboard::ScopedLock lock(mutex_);
+    for (Entry& entry : entries_) {
+      if (entry.owner == owner)
+        entry.visible = visible;
+    }
+  }
+
+  bool GetState(std::string& out_json) {
+    StateData data;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      data.Primary.Capacity = primary_capacity_;
+      data.Primary.Used = CountUsed(DecoderArbiter::kPrimary);
+      data.Secondary.Capacity = secondary_capacity_;
+      data.Secondary.Used = CountUsed(DecoderArbiter::kSecondary);
+      data.Preempted = preempted_;
+      data.Downgraded = downgraded_;
+      data.Unreserved = unreserved_;
+      data.Rejected = rejected_;
+      for (const Entry& entry : entries_) {
+        PlayerData& player = data.Players.Add();
+        player.Codec = CodecName(entry.codec);
+        player.Width = entry.width;
+        player.Height = entry.height;
+        player.Decoder = DecoderName(entry.decoder);
+        player.Visible = entry.visible;
+      }
+    }
+    return data.ToString(out_json);
+  }
+
+private:
+  struct Entry {
+    void* owner { nullptr };
+    SbMediaVideoCodec codec { kSbMediaVideoCodecNone };
+    int width { 0 };
+    int height { 0 };
+    DecoderArbiter::Decoder decoder { DecoderArbiter::kNone };
+    DecoderArbiter::PreemptFunc preempt_func { nullptr };
+    SbTimeMonotonic since { 0 };
+    // Until bounds say otherwise, a new player is about to be shown.
+    bool visible { true };
+  };
+
+  int CountUsed(DecoderArbiter::Decoder decoder) const {
+    return std::count_if(entries_.begin(), entries_.end(),
+                         [decoder](const Entry& entry) { return entry.decoder == decoder; });
+  }
+
+  Entry* FindOldestHiddenPrimary() {
+    Entry* oldest = nullptr;
+    for (Entry& entry : entries_) {
+      if (entry.decoder == DecoderArbiter::kPrimary && !entry.visible &&
+          (!oldest || entry.since < oldest->since))
+        oldest = &entry;
+    }
+    return oldest;
+  }
+
+  const int primary_capacity_;
+  const int secondary_capacity_;
+  const int secondary_max_height_;
+  ::starboard::Mutex mutex_;
+  std::vector<Entry> entries_;
+  uint32_t preempted_ { 0 };
+  uint32_t downgraded_ { 0 };
+  uint32_t unreserved_ { 0 };
+  uint32_t rejected_ { 0 };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(Arbiter, GetArbiter);
+
+}  // namespace
+
+// static
+DecoderArbiter::Decoder DecoderArbiter::Acquire(void* owner,
+                                                SbMediaVideoCodec codec,
+                                                const char* max_video_capabilities,
+                                                PreemptFunc preempt_func) {
+  return GetArbiter()->Acquire(owner, codec, max_video_capabilities, preempt_func);
+}
+
+// static
+void DecoderArbiter::Release(void* owner) {
+  GetArbiter()->Release(owner);
+}
+
+// static
+void DecoderArbiter::SetVisible(void* owner, bool visible) {
+  GetArbiter()->SetVisible(owner, visible);
+}
+
+// static
+bool DecoderArbiter::GetState(std::string& out_json) {
+  return GetArbiter()->GetState(out_json);
+}
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
@@ -0,0 +1,78 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_DECODER_ARBITER_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_DECODER_ARBITER_H_
+
+#include <string>
+
+#include "starboard/media.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+
+// Hands out the hardware video decoders to the players alive at the same
+// time. Platforms have a number of full ("primary") decoders and of reduced
+// ("secondary") ones, set with COBALT_PRIMARY_VIDEO_DECODERS (default 1)
+// and COBALT_SECONDARY_VIDEO_DECODERS (default 1); secondary decoders take
+// up to COBALT_SECONDARY_VIDEO_DECODER_MAX_HEIGHT lines (default 1080).
+//
+// Players created without max video capabilities (or with only the low
+// latency hint) ask for a primary decoder. When none is free, one is taken
+// from a player that isn't visible (empty bounds). New players count as
+// visible. The players on screen keep theirs: the new player gets a
+// secondary decoder instead, or is refused when none is left. Players with
+// limited capabilities (previews) get a secondary decoder when one fits,
+// otherwise they run without a reserved decoder and the platform decides,
+// as it did before there was an arbiter.
+class DecoderArbiter {
+public:
+  enum Decoder {
+    kNone,
+    kPrimary,
+    kSecondary,
+    kUnreserved,
+  };
+
+  // Called when the owner loses its decoder to a newer player, without the
+  // arbiter lock held. Must not block.
+  typedef void (*PreemptFunc)(void* owner);
+
+  // |max_video_capabilities| may be null or empty for foreground players.
+  // Returns kNone if the player should be refused. Called before the player
+  // is built, |owner| is released once the player is gone.
+  static Decoder Acquire(void* owner,
+                         SbMediaVideoCodec codec,
+                         const char* max_video_capabilities,
+                         PreemptFunc preempt_func);
+  static void Release(void* owner);
+  // The owner's video is on screen or not, from its bounds.
+  static void SetVisible(void* owner, bool visible);
+
+  // Current assignments and decision counters as JSON.
+  static bool GetState(std::string& out_json);
+};
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_DECODER_ARBITER_H_
@@ -14,8 +14,12 @@
 // limitations under the License.
 //
 // SPDX-License-Identifier: Apache-2.0
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <map>
+#include <sstream>
 #include <type_traits>
 
 #include <glib.h>
@@ -24,8 +28,13 @@
 
 #include "starboard/configuration.h"
 #include "starboard/configuration_constants.h"
+#include "starboard/common/file.h"
 #include "starboard/common/log.h"
+#include "starboard/common/mutex.h"
+#include "starboard/once.h"
+#include "starboard/system.h"
 #include "third_party/starboard/rdk/shared/media/gst_media_utils.h"
+#include "third_party/starboard/rdk/shared/rdkservices.h"
 #include "third_party/starboard/rdk/shared/log_override.h"
 
 namespace third_party {
@@ -129,19 +138,199 @@ bool GstRegistryHasElementForCodecImpl(C codec) {
   return false;
 }
 
+const char kCapabilityCacheFileName[] = "gst_media_capabilities";
+
+// FNV-1a, stable across builds and runs unlike std::hash.
+uint64_t HashString(const std::string& value) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : value) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Codec support computed from the registry scan above. The results are kept
+// for as long as the registry does not change and are saved to the cache
+// directory, keyed by the installed plugins and the firmware version, so the
+// next start does not have to scan the registry again. New results are
+// written out in one go by Flush(), on suspend and on teardown.
+class CapabilityCache {
+public:
+  // Queried once, the firmware does not change while running and the IPC
+  // must not be made under |mutex_|.
+  CapabilityCache()
+    : firmware_version_(DeviceIdentification::GetFirmwareVersion()) {
+  }
+
+  template <typename C>
+  bool HasElementForCodec(C codec) {
+    const std::string name = CodecName(codec);
+    const guint32 cookie = gst_registry_get_feature_list_cookie(gst_registry_get());
+    std::string key;
+    if (!IsValid(cookie))
+      key = ComputeRegistryKey();
+
+    ::starboard::ScopedLock lock(mutex_);
+    Validate(cookie, key);
+    auto it = entries_.find(name);
+    if (it != entries_.end())
+      return it->second;
+    bool result = GstRegistryHasElementForCodecImpl(codec);
+    entries_[name] = result;
+    is_dirty_ = true;
+    return result;
+  }
+
+  void Flush() {
+    std::string content;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      if (!is_dirty_)
+        return;
+      is_dirty_ = false;
+      content = registry_key_ + '\n';
+      for (const auto& it : entries_)
+        content += it.first + '=' + (it.second ? '1' : '0') + '\n';
+    }
+    Save(content);
+  }
+
+private:
+  static std::string CodecName(SbMediaVideoCodec codec) {
+    return "video/" + std::to_string(static_cast<int>(codec));
+  }
+  static std::string CodecName(SbMediaAudioCodec codec) {
+    return "audio/" + std::to_string(static_cast<int>(codec));
+  }
+
+  static std::string GetFilePath() {
+    char path[kSbFileMaxPath];
+    if (!SbSystemGetPath(kSbSystemPathCacheDirectory, path, kSbFileMaxPath))
+      return std::string();
+    return std::string(path) + "/" + kCapabilityCacheFileName;
+  }
+
+  std::string ComputeRegistryKey() const {
+    std::string plugins_desc;
+    GList* plugins = gst_registry_get_plugin_list(gst_registry_get());
+    for (GList* iter = plugins; iter; iter = iter->next) {
+      GstPlugin* plugin = static_cast<GstPlugin*>(iter->data);
+      const gchar* filename = gst_plugin_get_filename(plugin);
+      plugins_desc += gst_plugin_get_name(plugin);
+      plugins_desc += ':';
+      plugins_desc += gst_plugin_get_version(plugin);
+      plugins_desc += ':';
+      plugins_desc += filename ? filename : "";
+      plugins_desc += ';';
+    }
+    gst_plugin_list_free(plugins);
+
+    std::ostringstream key;
+    key << firmware_version_ << '/' << std::hex << HashString(plugins_desc);
+    return key.str();
+  }
+
+  bool IsValid(guint32 cookie) {
+    ::starboard::ScopedLock lock(mutex_);
+    return is_valid_ && cookie == registry_cookie_;
+  }
+
+  // Drops the entries when the registry changed since they were computed.
+  // The saved entries are loaded once, on first use. |key| is only computed
+  // when |cookie| was seen to change; it is empty when another thread already
+  // moved on to a newer cookie, then the current entries are kept.
+  void Validate(guint32 cookie, const std::string& key) {
+    if (key.empty() || (is_valid_ && cookie == registry_cookie_))
+      return;
+
+    if (is_valid_) {
+      if (key == registry_key_) {
+        registry_cookie_ = cookie;
+        return;
+      }
+      SB_LOG(INFO) << "GStreamer registry changed, dropping media capabilities";
+      entries_.clear();
+      is_dirty_ = true;
+    } else {
+      Load(key);
+    }
+    registry_key_ = key;
+    registry_cookie_ = cookie;
+    is_valid_ = true;
+  }
+
+  void Load(const std::string& key) {
+    std::string path = GetFilePath();
+    if (path.empty())
+      return;
+
+    ::starboard::ScopedFile file(path.c_str(), kSbFileOpenOnly | kSbFileRead);
+    if (!file.IsValid())
+      return;
+
+    int64_t size = file.GetSize();
+    if (size <= 0 || size > kSbInt32Max)
+      return;
+    std::string content(static_cast<size_t>(size), '\0');
+    if (file.ReadAll(&content[0], static_cast<int>(size)) != size)
+      return;
+
+    std::istringstream stream(content);
+    std::string line;
+    if (!std::getline(stream, line) || line != key) {
+      SB_LOG(INFO) << "Ignoring stale media capabilities from '" << path << "'";
+      return;
+    }
+    while (std::getline(stream, line)) {
+      std::string::size_type pos = line.find('=');
+      if (pos == std::string::npos)
+        continue;
+      entries_[line.substr(0, pos)] = line.compare(pos + 1, std::string::npos, "1") == 0;
+    }
+    SB_LOG(INFO) << "Loaded " << entries_.size() << " media capabilities from '" << path << "'";
+  }
+
+  static void Save(const std::string& content) {
+    std::string path = GetFilePath();
+    if (path.empty())
+      return;
+
+    std::string tmp_path = path + ".tmp";
+    {
+      ::starboard::ScopedFile file(tmp_path.c_str(), kSbFileCreateAlways | kSbFileWrite);
+      if (!file.IsValid() ||
+          file.WriteAll(content.data(), static_cast<int>(content.size())) != static_cast<int>(content.size())) {
+        SB_LOG(WARNING) << "Failed to save media capabilities to '" << tmp_path << "'";
+        return;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0)
+      SB_LOG(WARNING) << "Failed to save media capabilities to '" << path << "'";
+  }
+
+  const std::string firmware_version_;
+  ::starboard::Mutex mutex_;
+  std::map<std::string, bool> entries_;
+  std::string registry_key_;
+  guint32 registry_cookie_ { 0 };
+  bool is_valid_ { false };
+  bool is_dirty_ { false };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(CapabilityCache, GetCapabilityCache);
+
 template <typename C>
 bool GstRegistryHasElementForCodec(C codec) {
-  static std::map<C, bool> cache;
-  auto it = cache.find(codec);
-  if (it != cache.end())
-    return it->second;
-  bool r = GstRegistryHasElementForCodecImpl(codec);
-  cache[codec] = r;
-  return r;
+  return GetCapabilityCache()->HasElementForCodec(codec);
 }
 
 }  // namespace
 
+void SaveMediaCapabilities() {
+  GetCapabilityCache()->Flush();
+}
+
 bool GstRegistryHasElementForMediaType(SbMediaVideoCodec codec) {
   if (kSbMediaVideoCodecVp9 == codec && !kSbHasMediaWebmVp9Support)
     return false;
@@ -230,6 +419,33 @@ std::vector<std::string> CodecToGstCaps(SbMediaAudioCodec codec,
   }
 }
 
+int GetVideoCapability(const char* capabilities, const char* key) {
+  if (!capabilities)
+    return 0;
+  const size_t key_length = strlen(key);
+  for (const char* p = strstr(capabilities, key); p; p = strstr(p + 1, key)) {
+    bool at_start = (p == capabilities) || p[-1] == ' ' || p[-1] == ';';
+    if (at_start && p[key_length] == '=')
+      return atoi(p + key_length + 1);
+  }
+  return 0;
+}
+
+bool IsLowLatencyVideoCapabilities(const char* capabilities) {
+  static const bool forced = !!getenv("COBALT_LOW_LATENCY_PLAYBACK");
+  return forced || GetVideoCapability(capabilities, "lowlatency") > 0;
+}
+
+bool IsLimitedVideoCapabilities(const char* capabilities) {
+  if (!capabilities || !*capabilities)
+    return false;
+  // A bare low latency hint is not a preview.
+  if (GetVideoCapability(capabilities, "lowlatency") > 0)
+    return GetVideoCapability(capabilities, "width") > 0 ||
+           GetVideoCapability(capabilities, "height") > 0;
+  return true;
+}
+
 }  // namespace media
 }  // namespace shared
 }  // namespace rdk
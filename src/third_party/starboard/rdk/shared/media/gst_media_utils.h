@@ -34,6 +34,16 @@ std::vector<std::string> CodecToGstCaps(
     SbMediaAudioCodec codec,
     const SbMediaAudioSampleInfo* info = nullptr);
 std::vector<std::string> CodecToGstCaps(SbMediaVideoCodec codec);
+// Writes out codec support found since start, if any.
+void SaveMediaCapabilities();
+
+// Reads "<key>=<value>" out of a max video capabilities string such as
+// 'video/webm; codecs="vp9"; width=640; height=360', 0 when missing.
+int GetVideoCapability(const char* capabilities, const char* key);
+// Players asking for "lowlatency=1" use the low latency live profile.
+bool IsLowLatencyVideoCapabilities(const char* capabilities);
+// Any other capability limits the player to a secondary, preview decoder.
+bool IsLimitedVideoCapabilities(const char* capabilities);
 
 }  // namespace media
 }  // namespace shared
@@ -0,0 +1,320 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "third_party/starboard/rdk/shared/media/media_buffer_storage.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <linux/magic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "starboard/once.h"
+#include "starboard/common/mutex.h"
+#include "third_party/starboard/rdk/shared/memory_profile.h"
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+namespace {
+
+const size_t kMegabyte = 1024 * 1024;
+
+// Enough for the appsrc queues of two players plus the samples kept for
+// delayed seeks.
+const size_t kDefaultFileSize = 64 * kMegabyte;
+
+const size_t kAlignment = 64;
+
+// How far past the playback position samples are read back ahead of the
+// decoder.
+const GstClockTime kReadAheadWindow = GST_SECOND;
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t AlignDown(size_t value, size_t alignment) {
+  return value / alignment * alignment;
+}
+
+struct Chunk {
+  size_t offset;
+  size_t size;
+  const void* owner;
+  GstClockTime timestamp;
+};
+
+// Chunks by owner and timestamp, for the read-ahead. Live chunks never
+// share an offset.
+struct ChunkOrder {
+  bool operator()(const Chunk* a, const Chunk* b) const {
+    return std::tie(a->owner, a->timestamp, a->offset) < std::tie(b->owner, b->timestamp, b->offset);
+  }
+};
+
+class Storage {
+public:
+  Storage()
+    : page_size_(static_cast<size_t>(sysconf(_SC_PAGESIZE))) {
+    if (!MemoryProfile::UseFileMediaBufferStorage())
+      return;
+    size_t size = kDefaultFileSize;
+    if (const char* value = getenv("COBALT_MEDIA_BUFFER_FILE_SIZE_MB"))
+      size = std::max(1, atoi(value)) * kMegabyte;
+    if (!Open(size))
+      SB_LOG(WARNING) << "Falling back to memory for media buffers";
+  }
+
+  GstBuffer* Allocate(const void* owner, size_t size, GstClockTime timestamp) {
+    if (!base_ || size == 0)
+      return gst_buffer_new_allocate(nullptr, size, nullptr);
+
+    Chunk* chunk = new Chunk { 0, AlignUp(size, kAlignment), owner, timestamp };
+    if (!Reserve(chunk)) {
+      delete chunk;
+      return gst_buffer_new_allocate(nullptr, size, nullptr);
+    }
+
+    GstMemory* memory = gst_memory_new_wrapped(
+      static_cast<GstMemoryFlags>(0), base_ + chunk->offset, chunk->size,
+      0, size, chunk, &Storage::OnMemoryFreed);
+    GstBuffer* buffer = gst_buffer_new();
+    gst_buffer_append_memory(buffer, memory);
+    return buffer;
+  }
+
+  void ReadAhead(const void* owner, GstClockTime position) {
+    if (!base_ || !GST_CLOCK_TIME_IS_VALID(position))
+      return;
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      ReadAheadState& state = read_ahead_[owner];
+      // After a seek back the samples up to |until| are new ones.
+      if (position < state.position)
+        state.until = 0;
+      state.position = position;
+      GstClockTime end = position + kReadAheadWindow;
+      if (state.until >= end)
+        return;
+      Chunk key { 0, 0, owner, std::max(position, state.until) };
+      state.until = end;
+      for (auto it = chunks_.lower_bound(&key);
+           it != chunks_.end() && (*it)->owner == owner && (*it)->timestamp < end; ++it) {
+        size_t start = AlignDown((*it)->offset, page_size_);
+        size_t stop = AlignUp((*it)->offset + (*it)->size, page_size_);
+        if (!ranges.empty() && start <= ranges.back().second && stop >= ranges.back().first) {
+          ranges.back().first = std::min(ranges.back().first, start);
+          ranges.back().second = std::max(ranges.back().second, stop);
+        } else {
+          ranges.emplace_back(start, stop);
+        }
+      }
+    }
+
+    // A range freed meanwhile is only a hole in the file, advising it is
+    // harmless.
+    for (const auto& range : ranges)
+      madvise(base_ + range.first, range.second - range.first, MADV_WILLNEED);
+  }
+
+  void Release(const void* owner) {
+    ::starboard::ScopedLock lock(mutex_);
+    read_ahead_.erase(owner);
+  }
+
+private:
+  static void OnMemoryFreed(gpointer data);
+
+  bool Open(size_t size) {
+    const char* dir = getenv("COBALT_MEDIA_BUFFER_DIR");
+    if (dir == nullptr || *dir == '\0') {
+      SB_LOG(WARNING) << "File media buffers need COBALT_MEDIA_BUFFER_DIR";
+      return false;
+    }
+
+    struct statfs fs;
+    if (statfs(dir, &fs) == 0 && fs.f_type == TMPFS_MAGIC) {
+      SB_LOG(WARNING) << "Media buffer directory " << dir << " is on tmpfs, it would save no memory";
+      return false;
+    }
+
+    std::string path = std::string(dir) + "/media_buffers_XXXXXX";
+    fd_ = mkostemp(&path[0], O_CLOEXEC);
+    if (fd_ < 0) {
+      SB_LOG(ERROR) << "Failed to create " << path << ": " << strerror(errno);
+      return false;
+    }
+    // Nothing to clean up after a crash, the mapping keeps the file alive.
+    unlink(path.c_str());
+
+    // Sparse, blocks get allocated as samples are written.
+    if (ftruncate(fd_, size) != 0) {
+      SB_LOG(ERROR) << "Failed to size " << path << ": " << strerror(errno);
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (base == MAP_FAILED) {
+      SB_LOG(ERROR) << "Failed to map " << path << ": " << strerror(errno);
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+
+    // Samples are written and consumed in order, let readahead follow.
+    madvise(base, size, MADV_SEQUENTIAL);
+
+    base_ = static_cast<uint8_t*>(base);
+    free_[0] = size;
+    SB_LOG(INFO) << "Media buffers are stored in " << path
+                 << " (" << size / kMegabyte << "MB)";
+    return true;
+  }
+
+  // Next fit from where the last sample went, so that consecutive samples
+  // stay next to each other in the file.
+  bool Reserve(Chunk* chunk) {
+    const size_t size = chunk->size;
+    size_t& out_offset = chunk->offset;
+    ::starboard::ScopedLock lock(mutex_);
+    auto it = free_.lower_bound(next_);
+    for (size_t pass = 0; pass < 2; ++pass) {
+      for (; it != free_.end(); ++it) {
+        if (it->second < size)
+          continue;
+        out_offset = it->first;
+        size_t remaining = it->second - size;
+        free_.erase(it);
+        if (remaining)
+          free_[out_offset + size] = remaining;
+        next_ = out_offset + size;
+        used_ += size;
+        full_ = false;
+        chunks_.insert(chunk);
+        return true;
+      }
+      it = free_.begin();
+    }
+    if (!full_) {
+      SB_LOG(WARNING) << "Media buffer file is full (" << used_ / kMegabyte << "MB used)";
+      full_ = true;
+    }
+    return false;
+  }
+
+  void Free(Chunk& chunk) {
+    ::starboard::ScopedLock lock(mutex_);
+    chunks_.erase(&chunk);
+    size_t start = chunk.offset;
+    size_t end = chunk.offset + chunk.size;
+
+    auto next = free_.lower_bound(start);
+    if (next != free_.end() && next->first == end) {
+      end += next->second;
+      next = free_.erase(next);
+    }
+    if (next != free_.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == start) {
+        start = prev->first;
+        free_.erase(prev);
+      }
+    }
+    free_[start] = end - start;
+    used_ -= chunk.size;
+
+    // Give back the pages the chunk touched that are now entirely free. This
+    // has to happen under the lock, the range could be handed out again.
+    size_t hole_start = std::max(AlignUp(start, page_size_), AlignDown(chunk.offset, page_size_));
+    size_t hole_end = std::min(AlignDown(end, page_size_), AlignUp(chunk.offset + chunk.size, page_size_));
+    if (punch_holes_ && hole_start < hole_end &&
+        fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, hole_start, hole_end - hole_start) != 0) {
+      SB_LOG(WARNING) << "Can't punch holes in the media buffer file: " << strerror(errno);
+      punch_holes_ = false;
+    }
+  }
+
+  const size_t page_size_;
+  int fd_ { -1 };
+  uint8_t* base_ { nullptr };
+
+  ::starboard::Mutex mutex_;
+  // Free ranges by offset, adjacent ones are always merged.
+  std::map<size_t, size_t> free_;
+  size_t next_ { 0 };
+  size_t used_ { 0 };
+  bool full_ { false };
+  bool punch_holes_ { true };
+
+  struct ReadAheadState {
+    GstClockTime position { 0 };
+    GstClockTime until { 0 };
+  };
+  std::set<Chunk*, ChunkOrder> chunks_;
+  std::map<const void*, ReadAheadState> read_ahead_;
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(Storage, GetStorage);
+
+// static
+void Storage::OnMemoryFreed(gpointer data) {
+  Chunk* chunk = static_cast<Chunk*>(data);
+  GetStorage()->Free(*chunk);
+  delete chunk;
+}
+
+}  // namespace
+
+// static
+GstBuffer* MediaBufferStorage::AllocateBuffer(const void* owner, size_t size, GstClockTime timestamp) {
+  return GetStorage()->Allocate(owner, size, timestamp);
+}
+
+// static
+void MediaBufferStorage::ReadAhead(const void* owner, GstClockTime position) {
+  GetStorage()->ReadAhead(owner, position);
+}
+
+// static
+void MediaBufferStorage::Release(const void* owner) {
+  GetStorage()->Release(owner);
+}
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
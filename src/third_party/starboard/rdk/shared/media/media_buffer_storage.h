@@ -0,0 +1,61 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_BUFFER_STORAGE_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_BUFFER_STORAGE_H_
+
+#include <gst/gst.h>
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+
+// Where the samples queued in the pipeline are kept. In file mode they are
+// carved out of a sparse, unlinked file that is mapped once, so the pages
+// stay out of the anonymous memory of the process and the kernel can write
+// them back and drop them under pressure. Freed ranges are punched out of
+// the file. The file goes to COBALT_MEDIA_BUFFER_DIR, which must be on a
+// disk backed filesystem: tmpfs pages can't be dropped without swap and
+// are charged to the cgroup like anonymous memory, so tmpfs is refused.
+// The file is sized with COBALT_MEDIA_BUFFER_FILE_SIZE_MB. The mode comes
+// from the memory profile, see MemoryProfile::UseFileMediaBufferStorage().
+//
+// Only the copies the port makes in WriteSample are stored this way, the
+// MSE source buffers stay in Cobalt's memory.
+class MediaBufferStorage {
+public:
+  // Returns a buffer of |size| bytes for the sample of |owner| due at
+  // |timestamp|. Falls back to regular memory when the file is full or
+  // could not be set up.
+  static GstBuffer* AllocateBuffer(const void* owner, size_t size, GstClockTime timestamp);
+
+  // Asks the kernel to bring back the samples of |owner| due shortly after
+  // |position|, ahead of the decoder reading them.
+  static void ReadAhead(const void* owner, GstClockTime position);
+
+  // Forgets |owner|, its buffers may outlive it.
+  static void Release(const void* owner);
+};
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_BUFFER_STORAGE_H_
@@ -0,0 +1,135 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "third_party/starboard/rdk/shared/media/media_event_loop_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "starboard/once.h"
+#include "starboard/thread.h"
+#include "starboard/common/mutex.h"
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+namespace {
+
+// Two loops keep a playing video and a preloading or prefetching player from
+// delaying each other's callbacks.
+const int kDefaultLoopCount = 2;
+const int kMaxLoopCount = 8;
+
+struct EventLoop {
+  GMainContext* context { nullptr };
+  GMainLoop* loop { nullptr };
+  SbThread thread { kSbThreadInvalid };
+  int users { 0 };
+};
+
+class Pool {
+public:
+  Pool() {
+    int count = kDefaultLoopCount;
+    if (const char* value = getenv("COBALT_MEDIA_EVENT_LOOP_THREADS"))
+      count = std::max(1, std::min(kMaxLoopCount, atoi(value)));
+    loops_.resize(count);
+  }
+
+  GMainContext* Acquire() {
+    ::starboard::ScopedLock lock(mutex_);
+    auto it = std::min_element(loops_.begin(), loops_.end(),
+      [](const EventLoop& lhs, const EventLoop& rhs) {
+        return lhs.users < rhs.users;
+      });
+    EventLoop& loop = *it;
+    if (!loop.context && !Start(loop, it - loops_.begin()))
+      return nullptr;
+    ++loop.users;
+    return g_main_context_ref(loop.context);
+  }
+
+  void Release(GMainContext* context) {
+    if (!context)
+      return;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      for (auto& loop : loops_) {
+        if (loop.context == context) {
+          SB_DCHECK(loop.users > 0);
+          --loop.users;
+          break;
+        }
+      }
+    }
+    g_main_context_unref(context);
+  }
+
+private:
+  static void* ThreadEntryPoint(void* context) {
+    EventLoop* loop = static_cast<EventLoop*>(context);
+    g_main_context_push_thread_default(loop->context);
+    g_main_loop_run(loop->loop);
+    g_main_context_pop_thread_default(loop->context);
+    return nullptr;
+  }
+
+  // Loops are never stopped, idle ones just sleep in poll().
+  bool Start(EventLoop& loop, int index) {
+    loop.context = g_main_context_new();
+    loop.loop = g_main_loop_new(loop.context, FALSE);
+    loop.thread =
+        SbThreadCreate(0, kSbThreadPriorityRealTime, kSbThreadNoAffinity, true,
+                       "media_loop", &Pool::ThreadEntryPoint, &loop);
+    if (!SbThreadIsValid(loop.thread)) {
+      SB_LOG(ERROR) << "Failed to start media event loop " << index;
+      g_main_loop_unref(loop.loop);
+      g_main_context_unref(loop.context);
+      loop = EventLoop();
+      return false;
+    }
+    SB_LOG(INFO) << "Started media event loop " << index << " of " << loops_.size();
+    return true;
+  }
+
+  ::starboard::Mutex mutex_;
+  // Sized once, the threads keep pointers to the elements.
+  std::vector<EventLoop> loops_;
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(Pool, GetPool);
+
+}  // namespace
+
+// static
+GMainContext* MediaEventLoopPool::Acquire() {
+  return GetPool()->Acquire();
+}
+
+// static
+void MediaEventLoopPool::Release(GMainContext* context) {
+  GetPool()->Release(context);
+}
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
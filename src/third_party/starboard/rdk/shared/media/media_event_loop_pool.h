@@ -0,0 +1,51 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_EVENT_LOOP_POOL_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_EVENT_LOOP_POOL_H_
+
+#include <glib.h>
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+
+// A fixed set of "media_loop" threads, each running a GMainLoop on its own
+// GMainContext, shared by the players and audio sinks instead of a thread
+// per instance. Instances keep their own sources (bus watch, tasks, hang
+// monitor) on the context they were given, so they stay isolated from each
+// other apart from sharing the dispatching thread. That thread is why
+// callbacks must not block: anything slow (joining streaming threads on a
+// state change down, file I/O) goes to a thread of its own. The threads
+// are started on first use; COBALT_MEDIA_EVENT_LOOP_THREADS sets their
+// number.
+class MediaEventLoopPool {
+public:
+  // Returns the context of the least loaded loop, with a reference held for
+  // the caller until Release().
+  static GMainContext* Acquire();
+  static void Release(GMainContext* context);
+};
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_EVENT_LOOP_POOL_H_
@@ -32,9 +32,16 @@
 #include "starboard/media.h"
 
 #include "starboard/common/log.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+using third_party::starboard::rdk::shared::media::MediaMemoryGovernor;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity1080p;
 
 #if SB_API_VERSION >= 10
 int SbMediaGetAudioBufferBudget() {
-  return 5 * 1024 * 1024;
+  // Audio buffers are sized against the 1080p capacity as they do not depend
+  // on the video resolution.
+  return MediaMemoryGovernor::AdjustBudget(5 * 1024 * 1024,
+                                           kStockMaxBufferCapacity1080p);
 }
 #endif  // SB_API_VERSION >= 10
@@ -32,9 +32,13 @@
 #include "starboard/media.h"
 
 #include "starboard/common/log.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+using third_party::starboard::rdk::shared::media::MediaMemoryGovernor;
 
 #if SB_API_VERSION >= 10
 SbTime SbMediaGetBufferGarbageCollectionDurationThreshold() {
-  return 170 * kSbTimeSecond;
+  return MediaMemoryGovernor::AdjustGarbageCollectionThreshold(
+      170 * kSbTimeSecond);
 }
 #endif  // SB_API_VERSION >= 10
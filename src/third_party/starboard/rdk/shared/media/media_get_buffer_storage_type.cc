@@ -35,6 +35,8 @@
 
 #if SB_API_VERSION >= 10
 SbMediaBufferStorageType SbMediaGetBufferStorageType() {
+  // Cobalt keeps the MSE source buffers in memory. The file backed storage
+  // of the port only holds its own copies of the samples.
   return kSbMediaBufferStorageTypeMemory;
 }
 #endif  // SB_API_VERSION >= 10
@@ -16,9 +16,15 @@
 #include "starboard/media.h"
 
 #include "starboard/common/log.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+using third_party::starboard::rdk::shared::media::MediaMemoryGovernor;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity1080p;
 
 #if SB_API_VERSION >= 10
 int SbMediaGetInitialBufferCapacity() {
-  return 21 * 1024 * 1024;
+  // Scaled like the max capacity so it never exceeds it.
+  return MediaMemoryGovernor::AdjustBudget(21 * 1024 * 1024,
+                                           kStockMaxBufferCapacity1080p);
 }
 #endif  // SB_API_VERSION >= 10
@@ -16,6 +16,13 @@
 #include "starboard/media.h"
 
 #include "starboard/common/log.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+using third_party::starboard::rdk::shared::media::MediaMemoryGovernor;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity1080p;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity4k;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity4kHdr;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity8k;
 
 #if SB_API_VERSION >= 10
 int SbMediaGetMaxBufferCapacity(SbMediaVideoCodec codec,
@@ -29,7 +36,8 @@ int SbMediaGetMaxBufferCapacity(SbMediaVideoCodec codec,
     // The maximum amount of memory that will be used to store media buffers
     // when video resolution is 1080p. If 0, then memory can grow without bound.
     // This must be larger than sum of 1080p video budget and non-video budget.
-    return 50 * 1024 * 1024;
+    return MediaMemoryGovernor::AdjustBudget(kStockMaxBufferCapacity1080p,
+                                             kStockMaxBufferCapacity1080p);
   }
 
   if (resolution_width <= 3840 && resolution_height <= 2160) {
@@ -38,19 +46,22 @@ int SbMediaGetMaxBufferCapacity(SbMediaVideoCodec codec,
       // when video resolution is 4k and bit per pixel is lower than 8. If 0,
       // then memory can grow without bound. This must be larger than sum of 4k
       // video budget and non-video budget.
-      return 140 * 1024 * 1024;
+      return MediaMemoryGovernor::AdjustBudget(kStockMaxBufferCapacity4k,
+                                               kStockMaxBufferCapacity4k);
     } else {
       // The maximum amount of memory that will be used to store media buffers
       // when video resolution is 4k and bit per pixel is greater than 8. If 0,
       // then memory can grow without bound. This must be larger than sum of 4k
       // video budget and non-video budget.
-      return 210 * 1024 * 1024;
+      return MediaMemoryGovernor::AdjustBudget(kStockMaxBufferCapacity4kHdr,
+                                               kStockMaxBufferCapacity4kHdr);
     }
   }
 
   // The maximum amount of memory that will be used to store media buffers when
   // video resolution is 8k. If 0, then memory can grow without bound. This
   // must be larger than sum of 8k video budget and non-video budget.
-  return 360 * 1024 * 1024;
+  return MediaMemoryGovernor::AdjustBudget(kStockMaxBufferCapacity8k,
+                                           kStockMaxBufferCapacity8k);
 }
 #endif  // SB_API_VERSION >= 10
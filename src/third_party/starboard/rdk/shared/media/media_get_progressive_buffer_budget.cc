@@ -17,6 +17,10 @@
 #include "starboard/media.h"
 
 #include "starboard/common/log.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+using third_party::starboard::rdk::shared::media::MediaMemoryGovernor;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity1080p;
 
 #if SB_API_VERSION >= 10
 int SbMediaGetProgressiveBufferBudget(SbMediaVideoCodec codec,
@@ -27,6 +31,7 @@ int SbMediaGetProgressiveBufferBudget(SbMediaVideoCodec codec,
   SB_UNREFERENCED_PARAMETER(resolution_width);
   SB_UNREFERENCED_PARAMETER(resolution_height);
   SB_UNREFERENCED_PARAMETER(bits_per_pixel);
-  return 12 * 1024 * 1024;
+  return MediaMemoryGovernor::AdjustBudget(12 * 1024 * 1024,
+                                           kStockMaxBufferCapacity1080p);
 }
 #endif  // SB_API_VERSION >= 10
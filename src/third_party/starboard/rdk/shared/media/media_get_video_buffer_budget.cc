@@ -15,6 +15,13 @@
 #include "starboard/media.h"
 
 #include "starboard/common/log.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+using third_party::starboard::rdk::shared::media::MediaMemoryGovernor;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity1080p;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity4k;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity4kHdr;
+using third_party::starboard::rdk::shared::media::kStockMaxBufferCapacity8k;
 
 #if SB_API_VERSION >= 10
 int SbMediaGetVideoBufferBudget(SbMediaVideoCodec codec,
@@ -28,7 +35,8 @@ int SbMediaGetVideoBufferBudget(SbMediaVideoCodec codec,
     // Specifies the maximum amount of memory used by video buffers of media
     // source before triggering a garbage collection when the video resolution
     // is lower than 1080p (1920x1080).
-    return 30 * 1024 * 1024;
+    return MediaMemoryGovernor::AdjustBudget(30 * 1024 * 1024,
+                                             kStockMaxBufferCapacity1080p);
   }
 
   if (resolution_width <= 3840 && resolution_height <= 2160) {
@@ -36,18 +44,21 @@ int SbMediaGetVideoBufferBudget(SbMediaVideoCodec codec,
       // Specifies the maximum amount of memory used by video buffers of media
       // source before triggering a garbage collection when the video resolution
       // is lower than 4k (3840x2160) and bit per pixel is lower than 8.
-      return 100 * 1024 * 1024;
+      return MediaMemoryGovernor::AdjustBudget(100 * 1024 * 1024,
+                                               kStockMaxBufferCapacity4k);
     } else {
       // Specifies the maximum amount of memory used by video buffers of media
       // source before triggering a garbage collection when video resolution is
       // lower than 4k (3840x2160) and bit per pixel is greater than 8.
-      return 160 * 1024 * 1024;
+      return MediaMemoryGovernor::AdjustBudget(160 * 1024 * 1024,
+                                               kStockMaxBufferCapacity4kHdr);
     }
   }
 
   // Specifies the maximum amount of memory used by video buffers of media
   // source before triggering a garbage collection when the video resolution is
   // lower than 8k (7680x4320).
-  return 300 * 1024 * 1024;
+  return MediaMemoryGovernor::AdjustBudget(300 * 1024 * 1024,
+                                           kStockMaxBufferCapacity8k);
 }
 #endif  // SB_API_VERSION >= 10
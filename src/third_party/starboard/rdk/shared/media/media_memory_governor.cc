@@ -0,0 +1,155 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "starboard/once.h"
+#include "starboard/common/mutex.h"
+#include "third_party/starboard/rdk/shared/memory_profile.h"
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+namespace {
+
+const int64_t kMegabyte = 1024 * 1024;
+
+// Share of the available memory the media buffers of all players may take.
+const double kMediaMemoryShare = 0.5;
+
+const double kMinScale = 0.25;
+const double kMaxScale = 1.0;
+const double kMaxScaleHighTier = 2.0;
+
+// Memory pressure is entered below max(64MB, 10% of the total memory) and
+// left once twice that much is available again.
+const int64_t kMinPressureThreshold = 64 * kMegabyte;
+const SbTime kPressureCheckInterval = kSbTimeSecond;
+
+const SbTime kMinGarbageCollectionThreshold = 30 * kSbTimeSecond;
+
+class Governor {
+public:
+  Governor()
+    : disabled_(!!getenv("COBALT_DISABLE_MEDIA_MEMORY_GOVERNOR")) {
+    if (disabled_)
+      SB_LOG(INFO) << "Media memory governor is disabled";
+  }
+
+  void SetActivePlayerCount(int count) {
+    if (disabled_)
+      return;
+    ::starboard::ScopedLock lock(mutex_);
+    if (active_players_ == count)
+      return;
+    active_players_ = count;
+    Update(true);
+  }
+
+  double GetScale(int stock_capacity) {
+    if (disabled_ || stock_capacity <= 0)
+      return 1.0;
+    ::starboard::ScopedLock lock(mutex_);
+    Update(false);
+    if (allowance_ <= 0)
+      return 1.0;
+    double max_scale = MemoryProfile::GetTier() == MemoryProfile::kTierHigh ? kMaxScaleHighTier : kMaxScale;
+    return std::min(max_scale, std::max(kMinScale, double(allowance_) / stock_capacity));
+  }
+
+  bool IsUnderPressure() {
+    if (disabled_)
+      return false;
+    ::starboard::ScopedLock lock(mutex_);
+    Update(false);
+    return under_pressure_;
+  }
+
+private:
+  // Takes a new allowance snapshot when |reset| is set (player count changed)
+  // or none was taken yet, otherwise only re-checks memory pressure.
+  void Update(bool reset) {
+    SbTimeMonotonic now = SbTimeGetMonotonicNow();
+    bool has_snapshot = last_check_ != 0;
+    if (!reset && has_snapshot && (now - last_check_) < kPressureCheckInterval)
+      return;
+    last_check_ = now;
+
+    int64_t available = MemoryProfile::GetAvailableMemoryInBytes();
+    if (available <= 0) {
+      allowance_ = base_allowance_ = 0;
+      return;
+    }
+
+    int64_t threshold = std::max(kMinPressureThreshold, MemoryProfile::GetTotalMemoryInBytes() / 10);
+    bool under_pressure = under_pressure_ ? (available < 2 * threshold) : (available < threshold);
+
+    if (reset || !has_snapshot || base_allowance_ <= 0)
+      base_allowance_ = int64_t(available * kMediaMemoryShare) / std::max(active_players_, 1);
+
+    int64_t allowance = under_pressure ? base_allowance_ / 2 : base_allowance_;
+    if (allowance != allowance_ || under_pressure != under_pressure_) {
+      SB_LOG(INFO) << "Media memory allowance: " << allowance / kMegabyte << "MB"
+                   << " (available: " << available / kMegabyte << "MB"
+                   << ", players: " << active_players_
+                   << ", pressure: " << (under_pressure ? "yes" : "no") << ')';
+    }
+    allowance_ = allowance;
+    under_pressure_ = under_pressure;
+  }
+
+  const bool disabled_;
+  ::starboard::Mutex mutex_;
+  int active_players_ { 0 };
+  int64_t base_allowance_ { 0 };
+  int64_t allowance_ { 0 };
+  bool under_pressure_ { false };
+  SbTimeMonotonic last_check_ { 0 };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(Governor, GetGovernor);
+
+}  // namespace
+
+// static
+void MediaMemoryGovernor::SetActivePlayerCount(int count) {
+  GetGovernor()->SetActivePlayerCount(count);
+}
+
+// static
+int MediaMemoryGovernor::AdjustBudget(int stock_budget, int stock_capacity) {
+  return static_cast<int>(stock_budget * GetGovernor()->GetScale(stock_capacity));
+}
+
+// static
+SbTime MediaMemoryGovernor::AdjustGarbageCollectionThreshold(SbTime stock_threshold) {
+  double scale = std::min(1.0, GetGovernor()->GetScale(kStockMaxBufferCapacity1080p));
+  if (GetGovernor()->IsUnderPressure())
+    scale /= 2;
+  return std::max(kMinGarbageCollectionThreshold, static_cast<SbTime>(stock_threshold * scale));
+}
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
@@ -0,0 +1,54 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_MEMORY_GOVERNOR_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_MEMORY_GOVERNOR_H_
+
+#include "starboard/time.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace media {
+
+// Stock max buffer capacities the media budgets were tuned against.
+const int kStockMaxBufferCapacity1080p = 50 * 1024 * 1024;
+const int kStockMaxBufferCapacity4k = 140 * 1024 * 1024;
+const int kStockMaxBufferCapacity4kHdr = 210 * 1024 * 1024;
+const int kStockMaxBufferCapacity8k = 360 * 1024 * 1024;
+
+// Scales the stock media buffer budgets to the memory the device can spare
+// and to the number of players sharing it. The allowance is evaluated when
+// players come and go, and is cut down while the system is under memory
+// pressure. Set COBALT_DISABLE_MEDIA_MEMORY_GOVERNOR to use the stock values.
+class MediaMemoryGovernor {
+public:
+  static void SetActivePlayerCount(int count);
+
+  // Returns |stock_budget| scaled by how the current allowance compares to
+  // |stock_capacity|, the max buffer capacity the budget belongs to.
+  static int AdjustBudget(int stock_budget, int stock_capacity);
+  static SbTime AdjustGarbageCollectionThreshold(SbTime stock_threshold);
+};
+
+}  // namespace media
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_MEDIA_MEDIA_MEMORY_GOVERNOR_H_
@@ -0,0 +1,433 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "third_party/starboard/rdk/shared/memory_profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <core/JSON.h>
+
+#include "starboard/configuration.h"
+#include "starboard/once.h"
+#include "starboard/common/mutex.h"
+
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+using namespace WPEFramework;
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+namespace {
+
+const int64_t kMegabyte = 1024 * 1024;
+
+// Devices with less than this are treated as low tier, above the medium
+// bound as high tier.
+const int64_t kLowTierMaxMemory = 1280 * kMegabyte;
+const int64_t kMediumTierMaxMemory = 2560 * kMegabyte;
+
+// Cgroup v1 reports "no limit" as a huge page aligned number.
+const int64_t kCgroupUnlimited = int64_t(1) << 60;
+
+#ifndef SB_RDK_MEMORY_PROFILE_HINT_MB
+#define SB_RDK_MEMORY_PROFILE_HINT_MB 0
+#endif
+
+// Indexed by MemoryProfile::CacheType. Medium tier keeps Cobalt defaults.
+const int kLowTierCacheSizes[] = {
+  2 * kMegabyte,   // kSkiaCache
+  2 * kMegabyte,   // kOffscreenTargetCache
+  1 * kMegabyte,   // kEncodedImageCache
+  16 * kMegabyte,  // kImageCache
+  4 * kMegabyte,   // kLocalTypefaceCache
+  2 * kMegabyte,   // kRemoteTypefaceCache
+  1 * kMegabyte,   // kMeshCache
+  4 * kMegabyte,   // kSoftwareSurfaceCache
+  4 * kMegabyte,   // kJsGarbageCollectionThreshold
+};
+
+const int kHighTierCacheSizes[] = {
+  8 * kMegabyte,   // kSkiaCache
+  -1,              // kOffscreenTargetCache, let Cobalt decide
+  4 * kMegabyte,   // kEncodedImageCache
+  48 * kMegabyte,  // kImageCache
+  16 * kMegabyte,  // kLocalTypefaceCache
+  8 * kMegabyte,   // kRemoteTypefaceCache
+  2 * kMegabyte,   // kMeshCache
+  8 * kMegabyte,   // kSoftwareSurfaceCache
+  16 * kMegabyte,  // kJsGarbageCollectionThreshold
+};
+
+const char* TierToString(MemoryProfile::Tier tier) {
+  switch (tier) {
+    case MemoryProfile::kTierLow:
+      return "low";
+    case MemoryProfile::kTierMedium:
+      return "medium";
+    case MemoryProfile::kTierHigh:
+      return "high";
+  }
+  return "unknown";
+}
+
+// Returns the value of |field| from /proc/meminfo in bytes, or 0.
+int64_t ReadMemInfo(const char* field) {
+  FILE* meminfo = fopen("/proc/meminfo", "r");
+  if (!meminfo)
+    return 0;
+
+  int64_t result = 0;
+  char* buffer = nullptr;
+  size_t size = 0;
+  size_t field_len = strlen(field);
+
+  while (getline(&buffer, &size, meminfo) != -1) {
+    if (strncmp(buffer, field, field_len) != 0 || buffer[field_len] != ':')
+      continue;
+    long long kb = 0;
+    if (sscanf(buffer + field_len + 1, " %lld kB", &kb) == 1)
+      result = kb * 1024;
+    break;
+  }
+
+  free(buffer);
+  fclose(meminfo);
+
+  return result;
+}
+
+// Returns 0 if the file is missing or reports no limit.
+int64_t ReadCgroupLimitFile(const std::string& file_name) {
+  FILE* file = fopen(file_name.c_str(), "r");
+  if (!file)
+    return 0;
+
+  int64_t result = 0;
+  char buffer[64] = { 0 };
+  if (fgets(buffer, sizeof(buffer), file) != nullptr && strncmp(buffer, "max", 3) != 0) {
+    long long value = strtoll(buffer, nullptr, 10);
+    if (value > 0 && value < kCgroupUnlimited)
+      result = value;
+  }
+
+  fclose(file);
+  return result;
+}
+
+// Limits of parent groups apply too, so walk up to the mount root and take
+// the smallest one.
+int64_t ReadCgroupLimitAlongPath(const std::string& mount, std::string path, const char* file_name) {
+  int64_t result = 0;
+  while (true) {
+    int64_t limit = ReadCgroupLimitFile(mount + path + "/" + file_name);
+    if (limit > 0)
+      result = (result > 0) ? std::min(result, limit) : limit;
+    if (path.empty() || path == "/")
+      break;
+    size_t pos = path.find_last_of('/');
+    path = (pos == std::string::npos || pos == 0) ? std::string() : path.substr(0, pos);
+  }
+  return result;
+}
+
+struct CgroupMemory {
+  std::string mount;
+  std::string path;
+  const char* limit_file { nullptr };
+  const char* usage_file { nullptr };
+
+  bool IsValid() const { return limit_file != nullptr; }
+
+  int64_t ReadLimit() const {
+    return IsValid() ? ReadCgroupLimitAlongPath(mount, path, limit_file) : 0;
+  }
+
+  int64_t ReadUsage() const {
+    return IsValid() ? ReadCgroupLimitFile(mount + path + "/" + usage_file) : 0;
+  }
+};
+
+CgroupMemory FindCgroupMemory() {
+  CgroupMemory result;
+  FILE* cgroup = fopen("/proc/self/cgroup", "r");
+  if (!cgroup)
+    return result;
+
+  std::string v1_path, v2_path;
+  bool has_v1 = false, has_v2 = false;
+  char* buffer = nullptr;
+  size_t size = 0;
+
+  // Each line is "hierarchy-ID:controller-list:cgroup-path".
+  while (getline(&buffer, &size, cgroup) != -1) {
+    std::string line(buffer);
+    line.erase(line.find_last_not_of("\r\n") + 1);
+    size_t first = line.find(':');
+    size_t second = (first == std::string::npos) ? first : line.find(':', first + 1);
+    if (second == std::string::npos)
+      continue;
+    std::string id = line.substr(0, first);
+    std::string controllers = "," + line.substr(first + 1, second - first - 1) + ",";
+    std::string path = line.substr(second + 1);
+    if (id == "0" && controllers == ",,") {
+      v2_path = path;
+      has_v2 = true;
+    } else if (controllers.find(",memory,") != std::string::npos) {
+      v1_path = path;
+      has_v1 = true;
+    }
+  }
+
+  free(buffer);
+  fclose(cgroup);
+
+  if (has_v1) {
+    result.mount = "/sys/fs/cgroup/memory";
+    result.path = v1_path;
+    result.limit_file = "memory.limit_in_bytes";
+    result.usage_file = "memory.usage_in_bytes";
+  } else if (has_v2) {
+    result.mount = "/sys/fs/cgroup";
+    result.path = v2_path;
+    result.limit_file = "memory.max";
+    result.usage_file = "memory.current";
+  }
+  return result;
+}
+
+struct MemoryProfileImpl {
+  struct MemoryProfileData : public Core::JSON::Container {
+    MemoryProfileData()
+      : Core::JSON::Container() {
+      Add(_T("tier"), &Tier);
+      Add(_T("totalmemory"), &TotalMemory);
+      Add(_T("skiacache"), &SkiaCache);
+      Add(_T("offscreentargetcache"), &OffscreenTargetCache);
+      Add(_T("encodedimagecache"), &EncodedImageCache);
+      Add(_T("imagecache"), &ImageCache);
+      Add(_T("localtypefacecache"), &LocalTypefaceCache);
+      Add(_T("remotetypefacecache"), &RemoteTypefaceCache);
+      Add(_T("meshcache"), &MeshCache);
+      Add(_T("softwaresurfacecache"), &SoftwareSurfaceCache);
+      Add(_T("jsgcthreshold"), &JsGcThreshold);
+      Add(_T("mediabufferstorage"), &MediaBufferStorage);
+    }
+    MemoryProfileData(const MemoryProfileData&) = delete;
+    MemoryProfileData& operator=(const MemoryProfileData&) = delete;
+
+    const Core::JSON::DecSInt32& CacheSize(MemoryProfile::CacheType type) const {
+      switch (type) {
+        case MemoryProfile::kSkiaCache:                    return SkiaCache;
+        case MemoryProfile::kOffscreenTargetCache:         return OffscreenTargetCache;
+        case MemoryProfile::kEncodedImageCache:            return EncodedImageCache;
+        case MemoryProfile::kImageCache:                   return ImageCache;
+        case MemoryProfile::kLocalTypefaceCache:           return LocalTypefaceCache;
+        case MemoryProfile::kRemoteTypefaceCache:          return RemoteTypefaceCache;
+        case MemoryProfile::kMeshCache:                    return MeshCache;
+        case MemoryProfile::kSoftwareSurfaceCache:         return SoftwareSurfaceCache;
+        case MemoryProfile::kJsGarbageCollectionThreshold: return JsGcThreshold;
+      }
+      return SkiaCache;
+    }
+
+    Core::JSON::String Tier;              // "low", "medium" or "high"
+    Core::JSON::DecUInt32 TotalMemory;    // in megabytes
+    Core::JSON::DecSInt32 SkiaCache;      // cache sizes in bytes
+    Core::JSON::DecSInt32 OffscreenTargetCache;
+    Core::JSON::DecSInt32 EncodedImageCache;
+    Core::JSON::DecSInt32 ImageCache;
+    Core::JSON::DecSInt32 LocalTypefaceCache;
+    Core::JSON::DecSInt32 RemoteTypefaceCache;
+    Core::JSON::DecSInt32 MeshCache;
+    Core::JSON::DecSInt32 SoftwareSurfaceCache;
+    Core::JSON::DecSInt32 JsGcThreshold;
+    Core::JSON::String MediaBufferStorage;  // "memory" or "file"
+  };
+
+  MemoryProfileImpl()
+    : cgroup_(FindCgroupMemory()) {
+    int64_t meminfo = ReadMemInfo("MemTotal");
+    int64_t cgroup = cgroup_.ReadLimit();
+    int64_t hint = int64_t(SB_RDK_MEMORY_PROFILE_HINT_MB) * kMegabyte;
+
+    for (int64_t limit : { meminfo, cgroup, hint }) {
+      if (limit > 0)
+        detected_total_ = (detected_total_ > 0) ? std::min(detected_total_, limit) : limit;
+    }
+
+    SB_LOG(INFO) << "Memory profile: total " << detected_total_ / kMegabyte << "MB"
+                 << " (meminfo: " << meminfo / kMegabyte << "MB"
+                 << ", cgroup: " << cgroup / kMegabyte << "MB"
+                 << ", hint: " << hint / kMegabyte << "MB)"
+                 << ", tier: " << TierToString(GetTier());
+  }
+
+  void SetSettings(const std::string& json) {
+    ::starboard::ScopedLock lock(mutex_);
+    Core::OptionalType<Core::JSON::Error> error;
+    if ( !overrides_.FromString(json, error) ) {
+      overrides_.Clear();
+      SB_LOG(ERROR) << "Failed to parse memoryprofile settings, error: "
+                    << (error.IsSet() ? Core::JSON::ErrorDisplayMessage(error.Value()): "Unknown");
+      return;
+    }
+    SB_LOG(INFO) << "Memory profile override: " << json << ", tier: " << TierToString(GetTierLocked());
+  }
+
+  bool GetSettings(std::string& out_json) const {
+    ::starboard::ScopedLock lock(mutex_);
+    MemoryProfileData effective;
+    std::string overrides;
+    if ( overrides_.ToString(overrides) )
+      effective.FromString(overrides);
+    effective.Tier = std::string(TierToString(GetTierLocked()));
+    effective.MediaBufferStorage = std::string(UseFileMediaBufferStorageLocked() ? "file" : "memory");
+    effective.TotalMemory = static_cast<uint32_t>(GetTotalMemoryLocked() / kMegabyte);
+    return effective.ToString(out_json);
+  }
+
+  int64_t GetTotalMemory() const {
+    ::starboard::ScopedLock lock(mutex_);
+    return GetTotalMemoryLocked();
+  }
+
+  MemoryProfile::Tier GetTier() const {
+    ::starboard::ScopedLock lock(mutex_);
+    return GetTierLocked();
+  }
+
+  int64_t GetAvailableMemory() const {
+    int64_t available = ReadMemInfo("MemAvailable");
+    int64_t limit = cgroup_.ReadLimit();
+    if (limit > 0) {
+      int64_t cgroup_available = std::max<int64_t>(limit - cgroup_.ReadUsage(), 0);
+      available = (available > 0) ? std::min(available, cgroup_available) : cgroup_available;
+    }
+    // A profile override caps what we are allowed to use as well.
+    ::starboard::ScopedLock lock(mutex_);
+    if ( overrides_.TotalMemory.IsSet() && overrides_.TotalMemory.Value() > 0 )
+      available = std::min<int64_t>(available, GetTotalMemoryLocked());
+    return available;
+  }
+
+  int GetCacheSize(MemoryProfile::CacheType type, int default_value) const {
+    ::starboard::ScopedLock lock(mutex_);
+    const Core::JSON::DecSInt32& cache_override = overrides_.CacheSize(type);
+    if ( cache_override.IsSet() )
+      return cache_override.Value();
+
+    switch (GetTierLocked()) {
+      case MemoryProfile::kTierLow:
+        return kLowTierCacheSizes[type];
+      case MemoryProfile::kTierHigh:
+        return kHighTierCacheSizes[type];
+      default:
+        break;
+    }
+    return default_value;
+  }
+
+  bool UseFileMediaBufferStorage() const {
+    ::starboard::ScopedLock lock(mutex_);
+    return UseFileMediaBufferStorageLocked();
+  }
+
+private:
+  int64_t GetTotalMemoryLocked() const {
+    if ( overrides_.TotalMemory.IsSet() && overrides_.TotalMemory.Value() > 0 )
+      return int64_t(overrides_.TotalMemory.Value()) * kMegabyte;
+    return detected_total_;
+  }
+
+  bool UseFileMediaBufferStorageLocked() const {
+    if ( overrides_.MediaBufferStorage.IsSet() )
+      return overrides_.MediaBufferStorage.Value() == "file";
+    // Only where a directory for the file was set up.
+    const char* dir = getenv("COBALT_MEDIA_BUFFER_DIR");
+    return GetTierLocked() == MemoryProfile::kTierLow && dir && *dir;
+  }
+
+  MemoryProfile::Tier GetTierLocked() const {
+    if ( overrides_.Tier.IsSet() ) {
+      const std::string& tier = overrides_.Tier.Value();
+      if ( tier == "low" )
+        return MemoryProfile::kTierLow;
+      if ( tier == "medium" )
+        return MemoryProfile::kTierMedium;
+      if ( tier == "high" )
+        return MemoryProfile::kTierHigh;
+      SB_LOG(WARNING) << "Unknown memory profile tier '" << tier << "', ignoring";
+    }
+
+    int64_t total = GetTotalMemoryLocked();
+    if ( total <= 0 )
+      return MemoryProfile::kTierMedium;
+    if ( total < kLowTierMaxMemory )
+      return MemoryProfile::kTierLow;
+    if ( total < kMediumTierMaxMemory )
+      return MemoryProfile::kTierMedium;
+    return MemoryProfile::kTierHigh;
+  }
+
+  ::starboard::Mutex mutex_;
+  const CgroupMemory cgroup_;
+  int64_t detected_total_ { 0 };
+  MemoryProfileData overrides_;
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(MemoryProfileImpl, GetMemoryProfile);
+
+}  // namespace
+
+MemoryProfile::Tier MemoryProfile::GetTier() {
+  return GetMemoryProfile()->GetTier();
+}
+
+int64_t MemoryProfile::GetTotalMemoryInBytes() {
+  return GetMemoryProfile()->GetTotalMemory();
+}
+
+int64_t MemoryProfile::GetAvailableMemoryInBytes() {
+  return GetMemoryProfile()->GetAvailableMemory();
+}
+
+int MemoryProfile::GetCacheSizeInBytes(CacheType type, int default_value) {
+  return GetMemoryProfile()->GetCacheSize(type, default_value);
+}
+
+bool MemoryProfile::UseFileMediaBufferStorage() {
+  return GetMemoryProfile()->UseFileMediaBufferStorage();
+}
+
+void MemoryProfile::SetSettings(const std::string& json) {
+  GetMemoryProfile()->SetSettings(json);
+}
+
+bool MemoryProfile::GetSettings(std::string& out_json) {
+  return GetMemoryProfile()->GetSettings(out_json);
+}
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
@@ -0,0 +1,76 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_MEMORY_PROFILE_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_MEMORY_PROFILE_H_
+
+#include <string>
+
+#include "starboard/types.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+// Describes how much memory the device can afford to give to Cobalt. The
+// profile is built once from /proc/meminfo, the cgroup memory limit of the
+// process and the platform hint (SB_RDK_MEMORY_PROFILE_HINT_MB), and can be
+// overridden with SbRdkSetSetting("memoryprofile", json) before start.
+class MemoryProfile {
+public:
+  enum Tier {
+    kTierLow,
+    kTierMedium,
+    kTierHigh,
+  };
+
+  enum CacheType {
+    kSkiaCache,
+    kOffscreenTargetCache,
+    kEncodedImageCache,
+    kImageCache,
+    kLocalTypefaceCache,
+    kRemoteTypefaceCache,
+    kMeshCache,
+    kSoftwareSurfaceCache,
+    kJsGarbageCollectionThreshold,
+  };
+
+  static Tier GetTier();
+  static int64_t GetTotalMemoryInBytes();
+  // Memory that can still be allocated right now, i.e. MemAvailable bounded
+  // by what is left under the cgroup limit. Reads procfs on every call.
+  static int64_t GetAvailableMemoryInBytes();
+  // Returns the size for |type|, or |default_value| when the profile has no
+  // preference (i.e. on medium tier devices without an explicit override).
+  static int GetCacheSizeInBytes(CacheType type, int default_value);
+  // Whether media buffers held by the port should live in a file mapping
+  // rather than anonymous memory. On for low tier devices with
+  // COBALT_MEDIA_BUFFER_DIR set, unless the profile says otherwise.
+  static bool UseFileMediaBufferStorage();
+
+  static void SetSettings(const std::string& json);
+  static bool GetSettings(std::string& out_json);
+};
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_MEMORY_PROFILE_H_
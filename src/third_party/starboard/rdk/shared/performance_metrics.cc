@@ -0,0 +1,384 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "third_party/starboard/rdk/shared/performance_metrics.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <core/JSON.h>
+
+#include "starboard/once.h"
+#include "starboard/common/mutex.h"
+
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+using namespace WPEFramework;
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+namespace {
+
+// Frame rate is averaged over this window and reported as 0 once no frame
+// was rendered for two windows in a row (e.g. while suspended).
+const SbTime kFpsWindow = kSbTimeSecond;
+
+const int kDefaultRefreshRate = 60;
+
+// Cobalt doesn't redraw unchanged frames, longer gaps are the UI being idle
+// rather than frames coming late.
+const SbTime kIdleGap = 250 * kSbTimeMillisecond;
+
+// Frames shown for longer than this are visible as a stall.
+const SbTime kLongFrame = 50 * kSbTimeMillisecond;
+
+// Frames shown for 1, 2, 3, 4-7 and 8 or more vsyncs.
+const int kHistogramBuckets = 5;
+
+// The swap interval is raised when more than this share of the vsyncs in a
+// window was missed, and retried at 1 after kAdaptiveHold.
+const int kAdaptiveMissedPercent = 20;
+const SbTime kAdaptiveHold = 10 * kSbTimeSecond;
+
+// Too few frames in a window to tell jank from a mostly idle UI.
+const uint32_t kAdaptiveMinFrames = 10;
+
+struct TransitionStats {
+  uint32_t count { 0 };
+  SbTime last { 0 };
+  SbTime max { 0 };
+  SbTime total { 0 };
+};
+
+class Metrics {
+public:
+  struct TransitionData : public Core::JSON::Container {
+    TransitionData()
+      : Core::JSON::Container() {
+      Add(_T("count"), &Count);
+      Add(_T("last"), &Last);
+      Add(_T("max"), &Max);
+      Add(_T("average"), &Average);
+    }
+    TransitionData(const TransitionData&) = delete;
+    TransitionData& operator=(const TransitionData&) = delete;
+
+    void Set(const TransitionStats& stats) {
+      Count = stats.count;
+      Last = static_cast<uint32_t>(stats.last / kSbTimeMillisecond);
+      Max = static_cast<uint32_t>(stats.max / kSbTimeMillisecond);
+      Average = stats.count ? static_cast<uint32_t>(stats.total / stats.count / kSbTimeMillisecond) : 0;
+    }
+
+    Core::JSON::DecUInt32 Count;
+    Core::JSON::DecUInt32 Last;
+    Core::JSON::DecUInt32 Max;
+    Core::JSON::DecUInt32 Average;
+  };
+
+  struct LaunchData : public Core::JSON::Container {
+    LaunchData()
+      : Core::JSON::Container() {
+      Add(_T("warm"), &Warm);
+      Add(_T("firstframe"), &FirstFrame);
+    }
+    LaunchData(const LaunchData&) = delete;
+    LaunchData& operator=(const LaunchData&) = delete;
+
+    Core::JSON::Boolean Warm;
+    Core::JSON::DecUInt32 FirstFrame;
+  };
+
+  struct PacingData : public Core::JSON::Container {
+    PacingData()
+      : Core::JSON::Container() {
+      Add(_T("refreshrate"), &RefreshRate);
+      Add(_T("swapinterval"), &SwapInterval);
+      Add(_T("adaptive"), &Adaptive);
+      Add(_T("histogram"), &Histogram);
+      Add(_T("missedvsyncs"), &MissedVsyncs);
+      Add(_T("longframes"), &LongFrames);
+    }
+    PacingData(const PacingData&) = delete;
+    PacingData& operator=(const PacingData&) = delete;
+
+    Core::JSON::DecUInt32 RefreshRate;
+    Core::JSON::DecUInt32 SwapInterval;
+    Core::JSON::Boolean Adaptive;
+    Core::JSON::ArrayType<Core::JSON::DecUInt64> Histogram;
+    Core::JSON::DecUInt64 MissedVsyncs;
+    Core::JSON::DecUInt64 LongFrames;
+  };
+
+  struct MetricsData : public Core::JSON::Container {
+    MetricsData()
+      : Core::JSON::Container() {
+      Add(_T("fps"), &Fps);
+      Add(_T("frames"), &Frames);
+      Add(_T("pacing"), &Pacing);
+      Add(_T("launch"), &Launch);
+      Add(_T("suspend"), &Suspend);
+      Add(_T("resume"), &Resume);
+      Add(_T("pause"), &Pause);
+      Add(_T("unpause"), &Unpause);
+    }
+    MetricsData(const MetricsData&) = delete;
+    MetricsData& operator=(const MetricsData&) = delete;
+
+    Core::JSON::DecUInt32 Fps;
+    Core::JSON::DecUInt64 Frames;
+    PacingData Pacing;
+    LaunchData Launch;
+    TransitionData Suspend;
+    TransitionData Resume;
+    TransitionData Pause;
+    TransitionData Unpause;
+  };
+
+  Metrics()
+    : adaptive_enabled_(!!getenv("COBALT_ADAPTIVE_SWAP_INTERVAL")) {
+    int refresh_rate = kDefaultRefreshRate;
+    if (const char* value = getenv("COBALT_DISPLAY_REFRESH_RATE"))
+      refresh_rate = std::max(1, atoi(value));
+    refresh_rate_ = refresh_rate;
+    vsync_period_ = kSbTimeSecond / refresh_rate;
+  }
+
+  void OnLaunchRequested() {
+    ::starboard::ScopedLock lock(mutex_);
+    launch_request_time_ = SbTimeGetMonotonicNow();
+  }
+
+  void OnLaunch(bool warm) {
+    ::starboard::ScopedLock lock(mutex_);
+    launch_time_ = launch_request_time_ != 0 ? launch_request_time_ : SbTimeGetMonotonicNow();
+    launch_request_time_ = 0;
+    launch_warm_ = warm;
+    first_frame_ = 0;
+  }
+
+  void OnFrameRendered() {
+    SbTimeMonotonic now = SbTimeGetMonotonicNow();
+    ::starboard::ScopedLock lock(mutex_);
+    ++total_frames_;
+    if (last_frame_time_ != 0)
+      RecordIntervalLocked(now - last_frame_time_);
+    last_frame_time_ = now;
+    if (launch_time_ != 0 && first_frame_ == 0) {
+      first_frame_ = now - launch_time_;
+      SB_LOG(INFO) << (launch_warm_ ? "Warm" : "Cold") << " launch to first frame took "
+                   << first_frame_ / kSbTimeMillisecond << "ms";
+    }
+    if (window_start_ == 0) {
+      window_start_ = now;
+      window_frames_ = 0;
+      return;
+    }
+    ++window_frames_;
+    SbTime elapsed = now - window_start_;
+    if (elapsed >= kFpsWindow) {
+      fps_ = static_cast<uint32_t>((window_frames_ * kSbTimeSecond + elapsed / 2) / elapsed);
+      UpdateAdaptiveLocked(now);
+      window_start_ = now;
+      window_frames_ = 0;
+      window_paced_frames_ = 0;
+      window_missed_ = 0;
+    }
+  }
+
+  void SetActivePlayerCount(int count) {
+    ::starboard::ScopedLock lock(mutex_);
+    active_players_ = count;
+  }
+
+  int OnSwapIntervalRequested(int interval) {
+    ::starboard::ScopedLock lock(mutex_);
+    app_swap_interval_ = interval;
+    if (adaptive_raised_ && interval != 1) {
+      adaptive_raised_ = false;
+      pending_swap_interval_ = -1;
+    }
+    swap_interval_ = adaptive_raised_ ? 2 : interval;
+    return swap_interval_;
+  }
+
+  bool TakeSwapIntervalChange(int& out_interval) {
+    ::starboard::ScopedLock lock(mutex_);
+    if (pending_swap_interval_ < 0)
+      return false;
+    out_interval = swap_interval_ = pending_swap_interval_;
+    pending_swap_interval_ = -1;
+    return true;
+  }
+
+  void RecordTransition(PerformanceMetrics::Transition transition, SbTime duration) {
+    ::starboard::ScopedLock lock(mutex_);
+    TransitionStats& stats = transitions_[transition];
+    ++stats.count;
+    stats.last = duration;
+    stats.max = std::max(stats.max, duration);
+    stats.total += duration;
+    // The render loop stops while suspended, restart the frame rate window.
+    window_start_ = 0;
+  }
+
+  bool GetMetrics(std::string& out_json) {
+    MetricsData data;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      bool stale = (SbTimeGetMonotonicNow() - last_frame_time_) > 2 * kFpsWindow;
+      data.Fps = stale ? 0 : fps_;
+      data.Frames = total_frames_;
+      data.Pacing.RefreshRate = static_cast<uint32_t>(refresh_rate_);
+      data.Pacing.SwapInterval = static_cast<uint32_t>(swap_interval_);
+      data.Pacing.Adaptive = adaptive_raised_;
+      for (int i = 0; i < kHistogramBuckets; ++i)
+        data.Pacing.Histogram.Add() = histogram_[i];
+      data.Pacing.MissedVsyncs = missed_vsyncs_;
+      data.Pacing.LongFrames = long_frames_;
+      if (first_frame_ != 0) {
+        data.Launch.Warm = launch_warm_;
+        data.Launch.FirstFrame = static_cast<uint32_t>(first_frame_ / kSbTimeMillisecond);
+      }
+      data.Suspend.Set(transitions_[PerformanceMetrics::kSuspend]);
+      data.Resume.Set(transitions_[PerformanceMetrics::kResume]);
+      data.Pause.Set(transitions_[PerformanceMetrics::kPause]);
+      data.Unpause.Set(transitions_[PerformanceMetrics::kUnpause]);
+    }
+    return data.ToString(out_json);
+  }
+
+private:
+  void RecordIntervalLocked(SbTime interval) {
+    if (interval > kIdleGap)
+      return;
+    int vsyncs = static_cast<int>(std::max<SbTime>(1, (interval + vsync_period_ / 2) / vsync_period_));
+    int bucket = vsyncs <= 3 ? vsyncs - 1 : (vsyncs < 8 ? 3 : 4);
+    ++histogram_[bucket];
+    int expected = std::max(1, swap_interval_);
+    if (vsyncs > expected) {
+      missed_vsyncs_ += vsyncs - expected;
+      window_missed_ += vsyncs - expected;
+    }
+    if (interval > kLongFrame)
+      ++long_frames_;
+    ++window_paced_frames_;
+  }
+
+  void UpdateAdaptiveLocked(SbTimeMonotonic now) {
+    if (!adaptive_enabled_)
+      return;
+    if (!adaptive_raised_) {
+      if (active_players_ == 0 || app_swap_interval_ != 1 || window_paced_frames_ < kAdaptiveMinFrames)
+        return;
+      uint64_t vsyncs = window_paced_frames_ + window_missed_;
+      if (window_missed_ * 100 <= vsyncs * kAdaptiveMissedPercent)
+        return;
+      SB_LOG(INFO) << "Missed " << window_missed_ << " of " << vsyncs
+                   << " vsyncs during playback, raising swap interval to 2";
+      adaptive_raised_ = true;
+      adaptive_since_ = now;
+      pending_swap_interval_ = 2;
+    } else if (active_players_ == 0 || now - adaptive_since_ > kAdaptiveHold) {
+      SB_LOG(INFO) << "Restoring swap interval " << app_swap_interval_;
+      adaptive_raised_ = false;
+      pending_swap_interval_ = app_swap_interval_;
+    }
+  }
+
+  ::starboard::Mutex mutex_;
+  uint64_t total_frames_ { 0 };
+  uint64_t window_frames_ { 0 };
+  SbTimeMonotonic window_start_ { 0 };
+  SbTimeMonotonic last_frame_time_ { 0 };
+  uint32_t fps_ { 0 };
+  SbTimeMonotonic launch_request_time_ { 0 };
+  SbTimeMonotonic launch_time_ { 0 };
+  SbTime first_frame_ { 0 };
+  bool launch_warm_ { false };
+  TransitionStats transitions_[PerformanceMetrics::kTransitionCount];
+
+  int refresh_rate_ { kDefaultRefreshRate };
+  SbTime vsync_period_ { kSbTimeSecond / kDefaultRefreshRate };
+  uint64_t histogram_[kHistogramBuckets] { };
+  uint64_t missed_vsyncs_ { 0 };
+  uint64_t long_frames_ { 0 };
+  uint32_t window_paced_frames_ { 0 };
+  uint64_t window_missed_ { 0 };
+
+  const bool adaptive_enabled_;
+  int active_players_ { 0 };
+  int app_swap_interval_ { 1 };
+  int swap_interval_ { 1 };
+  int pending_swap_interval_ { -1 };
+  bool adaptive_raised_ { false };
+  SbTimeMonotonic adaptive_since_ { 0 };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(Metrics, GetMetricsInstance);
+
+}  // namespace
+
+// static
+void PerformanceMetrics::OnLaunchRequested() {
+  GetMetricsInstance()->OnLaunchRequested();
+}
+
+// static
+void PerformanceMetrics::OnLaunch(bool warm) {
+  GetMetricsInstance()->OnLaunch(warm);
+}
+
+// static
+void PerformanceMetrics::OnFrameRendered() {
+  GetMetricsInstance()->OnFrameRendered();
+}
+
+// static
+void PerformanceMetrics::SetActivePlayerCount(int count) {
+  GetMetricsInstance()->SetActivePlayerCount(count);
+}
+
+// static
+int PerformanceMetrics::OnSwapIntervalRequested(int interval) {
+  return GetMetricsInstance()->OnSwapIntervalRequested(interval);
+}
+
+// static
+bool PerformanceMetrics::TakeSwapIntervalChange(int& out_interval) {
+  return GetMetricsInstance()->TakeSwapIntervalChange(out_interval);
+}
+
+// static
+void PerformanceMetrics::RecordTransition(Transition transition, SbTime duration) {
+  static const char* kNames[kTransitionCount] = { "Suspend", "Resume", "Pause", "Unpause" };
+  SB_LOG(INFO) << kNames[transition] << " took " << duration / kSbTimeMillisecond << "ms";
+  GetMetricsInstance()->RecordTransition(transition, duration);
+}
+
+// static
+bool PerformanceMetrics::GetMetrics(std::string& out_json) {
+  return GetMetricsInstance()->GetMetrics(out_json);
+}
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
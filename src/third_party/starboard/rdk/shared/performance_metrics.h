@@ -0,0 +1,71 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_PERFORMANCE_METRICS_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_PERFORMANCE_METRICS_H_
+
+#include <string>
+
+#include "starboard/time.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+// Runtime figures only the starboard layer can see: the rendered frame rate
+// and frame pacing (counted on eglSwapBuffers), the time from launch to the
+// first frame and how long lifecycle transitions took.
+// Exposed through SbRdkGetSetting("performance", json).
+//
+// With COBALT_ADAPTIVE_SWAP_INTERVAL set, the swap interval is raised to 2
+// while a video plays and the UI keeps missing vsyncs, trading 60fps with
+// judder for a steady 30fps. COBALT_DISPLAY_REFRESH_RATE overrides the
+// assumed 60Hz.
+class PerformanceMetrics {
+public:
+  enum Transition {
+    kSuspend,
+    kResume,
+    kPause,
+    kUnpause,
+    kTransitionCount,
+  };
+
+  // The host asked for the app to be launched. Launch latency is measured
+  // from here, or from OnLaunch() if the host doesn't report it.
+  static void OnLaunchRequested();
+  // |warm| tells whether the platform layer was warmed up before launch.
+  static void OnLaunch(bool warm);
+  static void OnFrameRendered();
+  static void SetActivePlayerCount(int count);
+
+  // The app asked for |interval|, returns the one to apply.
+  static int OnSwapIntervalRequested(int interval);
+  // Returns true when the swap interval should change to |out_interval|.
+  static bool TakeSwapIntervalChange(int& out_interval);
+  static void RecordTransition(Transition transition, SbTime duration);
+
+  static bool GetMetrics(std::string& out_json);
+};
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_PERFORMANCE_METRICS_H_
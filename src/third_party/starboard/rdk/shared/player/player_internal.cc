@@ -15,9 +15,12 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 #include "third_party/starboard/rdk/shared/player/player_internal.h"
+#include "third_party/starboard/rdk/shared/player/sample_recorder.h"
 
 #include <inttypes.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
 
 #include <glib.h>
 #include <gst/app/gstappsrc.h>
@@ -28,6 +31,8 @@
 #include <gst/video/video.h>
 #include <gst/base/gstbasetransform.h>
 
+#include <core/JSON.h>
+
 #include <map>
 #include <string>
 #include <vector>
@@ -37,12 +42,21 @@
 #include "starboard/once.h"
 #include "starboard/common/mutex.h"
 #include "starboard/common/condition_variable.h"
+#include "starboard/common/semaphore.h"
 #include "starboard/thread.h"
 #include "starboard/time.h"
 #include "starboard/memory.h"
 #include "starboard/drm.h"
+#include "third_party/starboard/rdk/shared/media/decoder_arbiter.h"
 #include "third_party/starboard/rdk/shared/media/gst_media_utils.h"
+#include "third_party/starboard/rdk/shared/media/media_buffer_storage.h"
+#include "third_party/starboard/rdk/shared/media/media_event_loop_pool.h"
+#include "third_party/starboard/rdk/shared/media/media_memory_governor.h"
 #include "third_party/starboard/rdk/shared/hang_detector.h"
+#include "third_party/starboard/rdk/shared/performance_metrics.h"
+#include "third_party/starboard/rdk/shared/thread_priority.h"
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
+#include "third_party/starboard/rdk/shared/drm/drm_system_ocdm.h"
 #include "third_party/starboard/rdk/shared/drm/gst_decryptor_ocdm.h"
 
 namespace third_party {
@@ -55,6 +69,107 @@ static constexpr int kMaxNumberOfSamplesPerWrite = 1;
 static const char kCustomInstantRateChangeEventName[] = "custom-instant-rate-change";
 static const char kDidReceiveFirstSegmentMsgName[] = "did-receive-first-segment";
 
+// Above this rate only key frames are decoded and audio is muted. Decoders
+// keep up with 2x and fast forward is offered from 4x, override with
+// COBALT_TRICK_MODE_MIN_RATE, 0 disables trick play.
+static constexpr double kDefaultTrickModeMinRate = 4.0;
+
+static double GetTrickModeMinRate() {
+  static const double min_rate = [] {
+    const char* value = getenv("COBALT_TRICK_MODE_MIN_RATE");
+    return value ? atof(value) : kDefaultTrickModeMinRate;
+  }();
+  return min_rate;
+}
+
+// When the video sink keeps reporting frames late, H.264/HEVC frames no
+// other frame depends on are dropped as they leave the appsrc queue for the
+// decoder, rather than when written seconds ahead of playback. VP9/AV1 can't
+// tell those apart, they drop everything up to the next key frame, and only
+// once the sink is far behind. Skipping stops once the sink was on time for
+// a while. COBALT_DISABLE_QOS_SKIP turns this off.
+static constexpr SbTime kQosSkipMinLate = 50 * kSbTimeMillisecond;
+static constexpr int kQosSkipLateMessages = 5;
+static constexpr SbTime kQosSkipKeyFrameLate = 500 * kSbTimeMillisecond;
+static constexpr SbTime kQosSkipRecoveryTime = kSbTimeSecond;
+
+// Playback pauses to rebuffer once it gets this close to the end of the
+// written samples.
+static constexpr SbTime kBufferingMargin = 350 * kSbTimeMillisecond;
+static constexpr SbTime kLowLatencyBufferingMargin = 100 * kSbTimeMillisecond;
+
+// The low latency profile keeps the written samples ahead of the position
+// between these bounds by playing slightly faster or slower.
+static constexpr SbTime kLiveMinAhead = 300 * kSbTimeMillisecond;
+static constexpr SbTime kLiveMaxAhead = 1500 * kSbTimeMillisecond;
+static constexpr SbTime kLiveTargetAhead = 800 * kSbTimeMillisecond;
+static constexpr double kLiveRateAdjustment = 0.03;
+// Samples are not requested further than this ahead of the position, the
+// appsrc byte limits only bound memory.
+static constexpr SbTime kLiveMaxBuffered = 2 * kSbTimeSecond;
+
+static bool IsQosSkipEnabled() {
+  static const bool enabled = !getenv("COBALT_DISABLE_QOS_SKIP");
+  return enabled;
+}
+
+// Looks at the first slice of an Annex B H.264/HEVC access unit. HEVC
+// sub-layer non-reference pictures can still be referenced from higher
+// sub-layers, so they only count on the highest one, |hevc_max_temporal_id|
+// (-1 when not known yet). Other codecs need a full parse and are never
+// treated as non-reference.
+static bool IsNonReferenceFrame(SbMediaVideoCodec codec, const uint8_t* data, size_t size,
+                                int hevc_max_temporal_id) {
+  if (codec != kSbMediaVideoCodecH264 && codec != kSbMediaVideoCodecH265)
+    return false;
+  for (size_t i = 0; i + 3 < size; ++i) {
+    if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+      continue;
+    uint8_t header = data[i + 3];
+    if (codec == kSbMediaVideoCodecH264) {
+      int type = header & 0x1f;
+      // Non-IDR slice with nal_ref_idc == 0.
+      if (type == 1 || type == 5)
+        return type == 1 && (header & 0x60) == 0;
+    } else {
+      int type = (header >> 1) & 0x3f;
+      // Sub-layer non-reference pictures have even types up to RSV_VCL_N14.
+      if (type < 32) {
+        if (type > 14 || (type % 2) != 0 || i + 4 >= size)
+          return false;
+        int temporal_id = (data[i + 4] & 0x07) - 1;
+        return temporal_id >= 0 && temporal_id == hevc_max_temporal_id;
+      }
+    }
+    i += 2;
+  }
+  return false;
+}
+
+// Returns sps_max_sub_layers_minus1 of the first HEVC SPS in an Annex B
+// access unit, or -1 if there is none.
+static int GetHevcMaxTemporalId(const uint8_t* data, size_t size) {
+  for (size_t i = 0; i + 5 < size; ++i) {
+    if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+      continue;
+    int type = (data[i + 3] >> 1) & 0x3f;
+    if (type == 33)
+      return (data[i + 5] >> 1) & 0x07;
+    // Slices come after the parameter sets.
+    if (type < 32)
+      return -1;
+    i += 2;
+  }
+  return -1;
+}
+
+static SbTime GetProcessCpuTime() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+    return 0;
+  return ts.tv_sec * kSbTimeSecond + ts.tv_nsec / kSbTimeNanosecondsPerMicrosecond;
+}
+
 // static
 int Player::MaxNumberOfSamplesPerWrite() {
   return kMaxNumberOfSamplesPerWrite;
@@ -62,6 +177,8 @@ int Player::MaxNumberOfSamplesPerWrite() {
 
 using third_party::starboard::rdk::shared::drm::CreateDecryptorElement;
 using third_party::starboard::rdk::shared::media::CodecToGstCaps;
+using third_party::starboard::rdk::shared::media::IsLimitedVideoCapabilities;
+using third_party::starboard::rdk::shared::media::IsLowLatencyVideoCapabilities;
 
 // **************************** GST/GLIB Helpers **************************** //
 
@@ -78,6 +195,7 @@ GST_DEBUG_CATEGORY(cobalt_gst_player_debug);
 
 static void PrintGstCaps(GstCaps* caps);
 static GstElement* CreatePayloader();
+static void RegisterCobaltSrc();
 
 static GSourceFuncs SourceFunctions = {
     // prepare
@@ -146,6 +264,8 @@ struct _GstCobaltSrcPrivate {
   gboolean async_start;
   gboolean async_done;
   GstFlowCombiner* flow_combiner;
+  // Last result of the combiner, read without the object lock.
+  gint combined_flow;
 };
 
 enum { PROP_0, PROP_LOCATION };
@@ -174,6 +294,7 @@ static void gst_cobalt_src_init(GstCobaltSrc* src) {
   src->priv->async_start = FALSE;
   src->priv->async_done = FALSE;
   src->priv->flow_combiner = gst_flow_combiner_new();
+  src->priv->combined_flow = GST_FLOW_OK;
   g_object_set(GST_BIN(src), "message-forward", TRUE, NULL);
 }
 
@@ -303,12 +424,23 @@ static gboolean gst_cobalt_src_query_with_parent(GstPad* pad,
   return result;
 }
 
-static GstFlowReturn gst_cobalt_src_chain_with_parent(GstPad* pad, GstObject* parent, GstBuffer* buffer) {
-  GstCobaltSrc* src = GST_COBALT_SRC(gst_object_get_parent(parent));
-  GstFlowReturn ret = gst_proxy_pad_chain_default(pad, GST_OBJECT(src), buffer);
-  if (ret != GST_FLOW_FLUSHING)
-    ret = gst_flow_combiner_update_pad_flow(src->priv->flow_combiner, pad, ret);
-  gst_object_unref(src);
+// The element is passed as chain data, it outlives the streaming on its pads.
+static GstFlowReturn gst_cobalt_src_chain(GstPad* pad, GstObject* parent, GstBuffer* buffer) {
+  GstCobaltSrc* src = GST_COBALT_SRC(GST_PAD_CHAINDATA(pad));
+  RDK_TRACE_INSTANT("CobaltSrcChain");
+  GstFlowReturn ret = gst_proxy_pad_chain_default(pad, parent, buffer);
+  if (ret == GST_FLOW_FLUSHING)
+    return ret;
+  // Steady state, nothing for the combiner to change. A fatal flow of the
+  // other pad still goes through it to be returned upstream.
+  if (G_LIKELY(ret == GST_FLOW_OK && GST_PAD_LAST_FLOW_RETURN(pad) == GST_FLOW_OK &&
+               g_atomic_int_get(&src->priv->combined_flow) == GST_FLOW_OK))
+    return ret;
+  // Both streaming threads get here, the combiner is not thread safe.
+  GST_OBJECT_LOCK(src);
+  ret = gst_flow_combiner_update_pad_flow(src->priv->flow_combiner, pad, ret);
+  g_atomic_int_set(&src->priv->combined_flow, ret);
+  GST_OBJECT_UNLOCK(src);
   return ret;
 }
 
@@ -362,7 +494,8 @@ void gst_cobalt_src_setup_and_add_app_src(SbMediaType media_type,
                                           GstCaps* caps,
                                           GstAppSrcCallbacks* callbacks,
                                           gpointer user_data,
-                                          gboolean inject_decryptor) {
+                                          gboolean inject_decryptor,
+                                          gboolean low_latency) {
   if (caps) {
     PrintGstCaps(caps);
     gst_app_src_set_caps(GST_APP_SRC(appsrc), caps);
@@ -370,13 +503,21 @@ void gst_cobalt_src_setup_and_add_app_src(SbMediaType media_type,
 
   const uint32_t kAudioMaxBytes = 256 * 1024;
   const uint32_t kVideoMaxBytes = 8 * 1024 * 1024;
-
-  uint32_t max_bytes = (media_type == kSbMediaTypeVideo) ? kVideoMaxBytes : kAudioMaxBytes;
+  // The low latency queues are bounded by time, see kLiveMaxBuffered. The
+  // byte limits leave room for that at 4K.
+  const uint32_t kLowLatencyAudioMaxBytes = 64 * 1024;
+  const uint32_t kLowLatencyVideoMaxBytes = 8 * 1024 * 1024;
+
+  uint32_t max_bytes;
+  if (low_latency)
+    max_bytes = (media_type == kSbMediaTypeVideo) ? kLowLatencyVideoMaxBytes : kLowLatencyAudioMaxBytes;
+  else
+    max_bytes = (media_type == kSbMediaTypeVideo) ? kVideoMaxBytes : kAudioMaxBytes;
 
   g_object_set(appsrc,
                "block", FALSE,
                "format", GST_FORMAT_TIME,
-               "min-percent", 50,
+               "min-percent", low_latency ? 25 : 50,
                nullptr);
   gst_app_src_set_stream_type(GST_APP_SRC(appsrc), GST_APP_STREAM_TYPE_SEEKABLE);
   gst_app_src_set_emit_signals(GST_APP_SRC(appsrc), FALSE);
@@ -414,7 +555,12 @@ void gst_cobalt_src_setup_and_add_app_src(SbMediaType media_type,
     src_elem = payloader;
   }
 
-  if (decryptor || payloader) {
+  // The queue decouples decryption from decoders that block in their chain
+  // function. COBALT_DISABLE_DECRYPT_QUEUE hands decrypted samples to the
+  // decoder on the appsrc streaming thread instead, saving a thread handoff
+  // per sample where the decoder doesn't block.
+  static const bool use_decrypt_queue = !getenv("COBALT_DISABLE_DECRYPT_QUEUE");
+  if ((decryptor || payloader) && use_decrypt_queue) {
     GstElement* queue = gst_element_factory_make("queue", nullptr);
     g_object_set (
       G_OBJECT (queue),
@@ -453,8 +599,11 @@ void gst_cobalt_src_setup_and_add_app_src(SbMediaType media_type,
     }, msg, [](gpointer data) { gst_message_unref(GST_MESSAGE(data)); });
 
   auto proxypad = GST_PAD(gst_proxy_pad_get_internal(GST_PROXY_PAD(pad)));
+  GST_OBJECT_LOCK(src);
   gst_flow_combiner_add_pad(src->priv->flow_combiner, proxypad);
-  gst_pad_set_chain_function(proxypad, static_cast<GstPadChainFunction>(gst_cobalt_src_chain_with_parent));
+  GST_OBJECT_UNLOCK(src);
+  GST_PAD_LAST_FLOW_RETURN(proxypad) = GST_FLOW_OK;
+  gst_pad_set_chain_function_full(proxypad, static_cast<GstPadChainFunction>(gst_cobalt_src_chain), src, nullptr);
   gst_object_unref(proxypad);
 
   gst_pad_set_query_function(pad, gst_cobalt_src_query_with_parent);
@@ -840,7 +989,7 @@ static void PrintGstCaps(GstCaps* caps) {
 #endif
 }
 
-static GstElement* CreatePayloader() {
+static GstElementFactory* GetPayloaderFactory() {
   static GstElementFactory* factory = nullptr;
   static volatile gsize init = 0;
 
@@ -849,6 +998,11 @@ static GstElement* CreatePayloader() {
     g_once_init_leave (&init, 1);
   }
 
+  return factory;
+}
+
+static GstElement* CreatePayloader() {
+  GstElementFactory* factory = GetPayloaderFactory();
   if (!factory) {
     GST_WARNING("svppay not found");
     return nullptr;
@@ -857,6 +1011,55 @@ static GstElement* CreatePayloader() {
   return gst_element_factory_create(factory, nullptr);
 }
 
+static void RegisterCobaltSrc() {
+  static volatile gsize init = 0;
+
+  if (g_once_init_enter (&init)) {
+    GstElementFactory* src_factory = gst_element_factory_find("cobaltsrc");
+    if (!src_factory) {
+      gst_element_register(0, "cobaltsrc", GST_RANK_PRIMARY + 100,
+                           GST_COBALT_TYPE_SRC);
+    } else {
+      gst_object_unref(src_factory);
+    }
+    g_once_init_leave (&init, 1);
+  }
+}
+
+// Loads the plugin of the best ranked element of |type| accepting one of
+// |caps|, optionally creating and dropping an instance of it.
+static void PrewarmElement(GstElementFactoryListType type,
+                           const std::vector<std::string>& caps,
+                           bool instantiate) {
+  GList* factories = gst_element_factory_list_get_elements(type, GST_RANK_MARGINAL);
+  factories = g_list_sort(factories, gst_plugin_feature_rank_compare_func);
+  for (const auto& single_caps : caps) {
+    GstCaps* gst_caps = gst_caps_from_string(single_caps.c_str());
+    GList* candidates = gst_element_factory_list_filter(factories, gst_caps, GST_PAD_SINK, FALSE);
+    gst_caps_unref(gst_caps);
+    if (!candidates)
+      continue;
+    GstElementFactory* factory = GST_ELEMENT_FACTORY(candidates->data);
+    if (instantiate) {
+      GstElement* element = gst_element_factory_create(factory, nullptr);
+      if (element) {
+        gst_object_ref_sink(element);
+        gst_object_unref(element);
+      }
+    } else {
+      GstPluginFeature* loaded = gst_plugin_feature_load(GST_PLUGIN_FEATURE(factory));
+      if (loaded)
+        gst_object_unref(loaded);
+    }
+    GST_INFO("Prewarmed '%s' for '%s'",
+             gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)),
+             single_caps.c_str());
+    gst_plugin_feature_list_free(candidates);
+    break;
+  }
+  gst_plugin_feature_list_free(factories);
+}
+
 }  // namespace
 
 // ********************************* Player ******************************** //
@@ -935,16 +1138,16 @@ class PlayerDestroyedTask : public PlayerStatusTask {
                       SbPlayer player,
                       int ticket,
                       void* ctx,
-                      GMainLoop* loop)
+                      ::starboard::Semaphore* done)
       : PlayerStatusTask(func, player, ticket, ctx, kSbPlayerStateDestroyed) {
-    this->loop_ = loop;
+    this->done_ = done;
   }
 
   ~PlayerDestroyedTask() override {}
 
   void Do() override {
     PlayerStatusTask::Do();
-    g_main_loop_quit(loop_);
+    done_->Put();
   }
 
   void PrintInfo() override {
@@ -954,7 +1157,7 @@ class PlayerDestroyedTask : public PlayerStatusTask {
   }
 
  private:
-  GMainLoop* loop_;
+  ::starboard::Semaphore* done_;
 };
 
 class DecoderStatusTask : public Task {
@@ -1033,6 +1236,7 @@ class PlayerImpl : public Player {
              SbDrmSystem drm_system,
              const SbMediaAudioSampleInfo& audio_sample_info,
              const char* max_video_capabilities,
+             media::DecoderArbiter::Decoder decoder,
              SbPlayerDeallocateSampleFunc sample_deallocate_func,
              SbPlayerDecoderStatusFunc decoder_status_func,
              SbPlayerStatusFunc player_status_func,
@@ -1052,9 +1256,19 @@ class PlayerImpl : public Player {
   bool SetRate(double rate) override;
   void GetInfo(SbPlayerInfo2* info) override;
   void SetBounds(int zindex, int x, int y, int w, int h) override;
+  void GetStats(PlayerStats* stats) override;
 
   GstElement* GetPipeline() const { return pipeline_;  }
-  bool IsValid() const { return SbThreadIsValid(playback_thread_); }
+  bool IsValid() const { return main_loop_context_ != nullptr; }
+  SbPlayer GetHandle() const { return player_; }
+  // Stops feeding the video decoder while nothing is visible. Video comes
+  // back from the next key frame.
+  void SetAudioOnly(bool audio_only);
+  // The arbiter took the video decoder away, stops the pipeline and reports
+  // a decode error.
+  void OnDecoderPreempted();
+  // DecoderArbiter::PreemptFunc, the owner is the SbPlayer.
+  static void PreemptDecoder(void* owner);
 
  private:
   enum class State {
@@ -1093,11 +1307,19 @@ class PlayerImpl : public Player {
 
   class PendingSample {
    public:
-    PendingSample() = delete;
+    PendingSample()
+        : type_(kSbMediaTypeAudio),
+          buffer_(nullptr),
+          serial_(0),
+          timestamp_(GST_CLOCK_TIME_NONE) {}
     PendingSample& operator=(const PendingSample&) = delete;
     PendingSample(const PendingSample&) = delete;
 
     PendingSample& operator=(PendingSample&& other) {
+      if (this == &other)
+        return *this;
+      if (buffer_)
+        gst_buffer_unref(buffer_);
       type_ = other.type_;
       buffer_ = other.buffer_;
       other.buffer_ = nullptr;
@@ -1108,7 +1330,7 @@ class PlayerImpl : public Player {
       return *this;
     }
 
-    PendingSample(PendingSample&& other) { operator=(std::move(other)); }
+    PendingSample(PendingSample&& other) : PendingSample() { operator=(std::move(other)); }
 
     PendingSample(SbMediaType type,
                   GstBuffer* buffer,
@@ -1127,7 +1349,9 @@ class PlayerImpl : public Player {
 
     SbMediaType Type() const { return type_; }
     GstClockTime Timestamp() const { return timestamp_; }
-    GstBuffer* CopyBuffer() const { return gst_buffer_copy_deep(buffer_); }
+    // Elements writing to the buffer (e.g. the decryptor) copy on write, so
+    // the stored sample stays intact while a reference is in the pipeline.
+    GstBuffer* RefBuffer() const { return gst_buffer_ref(buffer_); }
     GstBuffer* TakeBuffer() { GstBuffer* res = buffer_; buffer_ = nullptr; return res; }
     uint64_t SerialID() const { return serial_; }
 
@@ -1149,14 +1373,62 @@ class PlayerImpl : public Player {
     int h;
   };
 
-  using PendingSamples = std::vector<PendingSample>;
-  using SamplesPendingKey = std::map<std::string, PendingSamples>;
+  // FIFO of the samples kept while a seek is delayed. Slots are allocated
+  // once, it only grows if a stream writes more samples than that before
+  // the pipeline prerolls.
+  class PendingSampleRing {
+   public:
+    explicit PendingSampleRing(size_t capacity) : slots_(capacity) {}
+
+    bool IsEmpty() const { return size_ == 0; }
+    bool IsFull() const { return size_ == slots_.size(); }
+    size_t Size() const { return size_; }
+    size_t Capacity() const { return slots_.size(); }
+
+    PendingSample& At(size_t index) {
+      SB_DCHECK(index < size_);
+      return slots_[(head_ + index) % slots_.size()];
+    }
+    PendingSample& Back() { return At(size_ - 1); }
+
+    void PushBack(PendingSample&& sample) {
+      SB_DCHECK(!IsFull());
+      slots_[(head_ + size_) % slots_.size()] = std::move(sample);
+      ++size_;
+    }
+
+    void PopFront() {
+      SB_DCHECK(size_ > 0);
+      slots_[head_] = PendingSample();
+      head_ = (head_ + 1) % slots_.size();
+      --size_;
+    }
+
+    void Clear() {
+      while (size_ > 0)
+        PopFront();
+      head_ = 0;
+    }
+
+   private:
+    std::vector<PendingSample> slots_;
+    size_t head_ { 0 };
+    size_t size_ { 0 };
+  };
+
+  // Fixed, no more samples are requested once the ring is almost full.
+  static constexpr size_t kPendingSamplesCapacity = 256;
 
   static gboolean BusMessageCallback(GstBus* bus,
                                      GstMessage* message,
                                      gpointer user_data);
-  static void* ThreadEntryPoint(void* context);
+  static GstBusSyncReply BusSyncHandler(GstBus* bus,
+                                        GstMessage* message,
+                                        gpointer user_data);
   static gboolean WorkerTask(gpointer user_data);
+  static GstPadProbeReturn VideoBufferProbe(GstPad* pad,
+                                            GstPadProbeInfo* info,
+                                            gpointer user_data);
   static gboolean FinishSourceSetup(gpointer user_data);
   static void AppSrcNeedData(GstAppSrc* src, guint length, gpointer user_data);
   static void AppSrcEnoughData(GstAppSrc* src, gpointer user_data);
@@ -1169,8 +1441,11 @@ class PlayerImpl : public Player {
   static void SetupElement(GstElement* pipeline,
                            GstElement* element,
                            PlayerImpl* self);
+  // Whether the streaming thread of |owner| runs audio or decryption.
+  bool IsAudioOrDecryptThread(GstElement* owner) const;
   bool ChangePipelineState(GstState state) const;
   void DispatchOnWorkerThread(Task* task) const;
+  void AttachTask(Task* task) const;
   gint64 GetPosition() const;
   bool WriteSample(SbMediaType sample_type,
                    GstBuffer* buffer,
@@ -1189,16 +1464,49 @@ class PlayerImpl : public Player {
       GST_LOG("Stream(%d) already ended, ignoring needs data request", need_data);
       return;
     }
+    if (media == MediaType::kVideo && IsVideoParked()) {
+      GST_LOG("Video parked, holding needs data request");
+      video_request_parked_ = true;
+      return;
+    }
+    // Leaves a slot for a request of each stream already sent.
+    if (media != MediaType::kNone &&
+        pending_samples_.Size() + kMediaNumber > pending_samples_.Capacity()) {
+      GST_LOG("Pending samples full, holding needs data request");
+      pending_samples_held_data_ |= need_data;
+      return;
+    }
     decoder_state_data_ |= need_data;
     DispatchOnWorkerThread(new DecoderStatusTask(
       decoder_status_func_, player_, ticket_, context_,
       kSbPlayerDecoderStateNeedsData, media));
   }
 
+  // A video only player has nothing to play in audio only mode. Rather than
+  // reading and dropping video as fast as the app writes it, reading stops
+  // while presenting and playback pauses once the queued samples ran out.
+  bool IsVideoParked() const {
+    return audio_only_ && audio_codec_ == kSbMediaAudioCodecNone && state_ == State::kPresenting;
+  }
+
   void HandleApplicationMessage(GstBus* bus, GstMessage* message);
   void WritePendingSamples();
   void CheckBuffering(gint64 position);
+  void AdjustLiveRate(gint64 position);
+  bool HoldLiveData(::starboard::ScopedLock&, MediaType media);
+  void ReleaseLiveData(gint64 position);
+  bool SendRateChange(double rate);
   void ConfigureLimitedVideo();
+  void ConfigureSecondaryVideoSink();
+  void HandleQosMessage(GstMessage* message);
+  void LogStats();
+  void UpdateTrickMode(double rate);
+  bool SkipForTrickMode(bool is_key_frame);
+  void UpdateQosSkip(::starboard::ScopedLock&, SbTime late);
+  bool IsDroppableForQos(const SbPlayerSampleInfo& sample_info);
+  bool SkipForQos(GstBuffer* buffer);
+  bool SkipForAudioOnly(const SbPlayerSampleInfo& sample_info);
+  void StartRateSegment(::starboard::ScopedLock&, double rate);
 
   SbPlayer player_;
   SbWindow window_;
@@ -1214,15 +1522,18 @@ class PlayerImpl : public Player {
   void* context_{nullptr};
   SbPlayerOutputMode output_mode_;
   SbDecodeTargetGraphicsContextProvider* provider_{nullptr};
-  GMainLoop* main_loop_{nullptr};
+  // Shared with other players, see MediaEventLoopPool. Callbacks on it must
+  // not block, the force stop state change runs on |force_stop_thread_|.
   GMainContext* main_loop_context_{nullptr};
+  mutable ::starboard::Mutex tasks_mutex_;
+  mutable bool tasks_closed_{false};
+  SbThread force_stop_thread_{kSbThreadInvalid};
   GstElement* source_{nullptr};
   GstElement* video_appsrc_{nullptr};
   GstElement* audio_appsrc_{nullptr};
   GstElement* pipeline_{nullptr};
   int source_setup_id_{-1};
   int bus_watch_id_{-1};
-  SbThread playback_thread_;
   ::starboard::Mutex mutex_;
   ::starboard::Mutex source_setup_mutex_;
   ::starboard::Mutex seek_mutex_;
@@ -1242,7 +1553,9 @@ class PlayerImpl : public Player {
   int frame_width_{0};
   int frame_height_{0};
   State state_{State::kNull};
-  PendingSamples pending_samples_;
+  PendingSampleRing pending_samples_ { kPendingSamplesCapacity };
+  // Requests held until the pending samples are written.
+  mutable int pending_samples_held_data_ { static_cast<int>(MediaType::kNone) };
   mutable gint64 cached_position_ns_{GST_CLOCK_TIME_NONE};
   PendingBounds pending_bounds_;
   SbMediaColorMetadata color_metadata_{};
@@ -1257,26 +1570,89 @@ class PlayerImpl : public Player {
   GstCaps* audio_caps_ { nullptr };
   GstCaps* video_caps_ { nullptr };
   SbTime buf_target_min_ts_ { kSbTimeMax };
+  // Guarded by mutex_, set from the SetRate and the GetInfo threads.
   bool need_instant_rate_change_ { false };
   int need_first_segment_ack_ { static_cast<int>(MediaType::kBoth) };
+  std::unique_ptr<SampleRecorder> recorder_;
+  PlayerStats stats_;
+  SbTimeMonotonic create_time_ { SbTimeGetMonotonicNow() };
+  SbTimeMonotonic seek_start_time_ { 0 };
+  SbTimeMonotonic rebuffer_start_time_ { 0 };
+  bool trick_mode_ { false };
+  bool muted_before_trick_mode_ { false };
+  bool skip_delta_frames_ { false };
+
+  enum class QosSkip {
+    kNone,
+    kNonReference,
+    kUntilKeyFrame,
+  };
+  QosSkip qos_skip_ { QosSkip::kNone };
+  int qos_late_messages_ { 0 };
+  SbTimeMonotonic qos_last_late_time_ { 0 };
+  // From the last HEVC SPS, written on the sample writing thread only.
+  int hevc_max_temporal_id_ { -1 };
+  // Since the last seek, reported apart from the frames the sink dropped.
+  int qos_skipped_video_frames_ { 0 };
+
+  // Shallow queues and a playback rate kept close to the live edge.
+  bool low_latency_ { false };
+  double live_rate_ { 1.0 };
+  // Position at the last GetInfo and the streams whose requests were held
+  // for being kLiveMaxBuffered ahead of it.
+  gint64 live_position_ { static_cast<gint64>(GST_CLOCK_TIME_NONE) };
+  int live_held_data_ { static_cast<int>(MediaType::kNone) };
+
+  bool audio_only_ { false };
+  bool resume_video_at_key_frame_ { false };
+  mutable bool video_request_parked_ { false };
+  // Video dropped in audio only mode is read in step with audio, the next
+  // sample is requested once audio got past this one.
+  SbTime parked_video_timestamp_ { kSbTimeMax };
+  SbTime last_audio_timestamp_ { 0 };
+  SbTimeMonotonic audio_only_start_time_ { 0 };
+  SbTime audio_only_start_cpu_time_ { 0 };
+  int audio_only_skipped_frames_ { 0 };
+
+  // Playback at a single rate, reported when the rate changes.
+  struct RateSegment {
+    double rate { 1.0 };
+    SbTimeMonotonic start_time { 0 };
+    SbTime start_cpu_time { 0 };
+    uint64_t start_frames_processed { 0 };
+    int frames_written { 0 };
+    int frames_skipped { 0 };
+  };
+  RateSegment rate_segment_;
 };
 
+// Lock order: the registry mutex is taken before a player's mutex_ (and its
+// tasks mutex), which keeps the players alive while they are called. A
+// player must not call into the registry with its own mutex_ held.
 struct PlayerRegistry
 {
   ::starboard::Mutex mutex_;
   std::vector<PlayerImpl*> players_;
 
+  bool audio_only_ { false };
+
   void Add(PlayerImpl *p) {
     ::starboard::ScopedLock lock(mutex_);
     auto it = std::find(players_.begin(), players_.end(), p);
     if (it == players_.end()) {
       players_.push_back(p);
+      if (audio_only_)
+        p->SetAudioOnly(true);
     }
+    media::MediaMemoryGovernor::SetActivePlayerCount(players_.size());
+    PerformanceMetrics::SetActivePlayerCount(players_.size());
   }
 
   void Remove(PlayerImpl *p) {
     ::starboard::ScopedLock lock(mutex_);
     players_.erase(std::remove(players_.begin(), players_.end(), p), players_.end());
+    media::MediaMemoryGovernor::SetActivePlayerCount(players_.size());
+    PerformanceMetrics::SetActivePlayerCount(players_.size());
   }
 
   void ForceStop() {
@@ -1297,9 +1673,142 @@ struct PlayerRegistry
       gst_object_unref(pipeline);
     }
   }
+
+  void SetAudioOnly(bool audio_only) {
+    ::starboard::ScopedLock lock(mutex_);
+    audio_only_ = audio_only;
+    for (const auto& p: players_)
+      p->SetAudioOnly(audio_only);
+  }
+
+  // The player may be getting destroyed, it is only called while still
+  // registered. ~PlayerImpl() unregisters before anything else.
+  void PreemptDecoder(SbPlayer player) {
+    ::starboard::ScopedLock lock(mutex_);
+    for (const auto& p: players_) {
+      if (p->GetHandle() == player)
+        p->OnDecoderPreempted();
+    }
+  }
+
+  std::vector<PlayerStats> GetStats() {
+    ::starboard::ScopedLock lock(mutex_);
+    std::vector<PlayerStats> stats(players_.size());
+    for (size_t i = 0; i < players_.size(); ++i)
+      players_[i]->GetStats(&stats[i]);
+    return stats;
+  }
 };
 SB_ONCE_INITIALIZE_FUNCTION(PlayerRegistry, GetPlayerRegistry);
 
+// JSON layout of PlayerStats, times in ms except for the jitter (us).
+struct PlayerStatsData : public WPEFramework::Core::JSON::Container {
+  PlayerStatsData()
+    : WPEFramework::Core::JSON::Container() {
+    Init();
+  }
+  PlayerStatsData(const PlayerStatsData& other)
+    : WPEFramework::Core::JSON::Container() {
+    Init();
+    *this = other;
+  }
+  PlayerStatsData& operator=(const PlayerStatsData& other) {
+    VideoFramesProcessed = other.VideoFramesProcessed;
+    VideoFramesDropped = other.VideoFramesDropped;
+    AudioBuffersDropped = other.AudioBuffersDropped;
+    LateVideoFrames = other.LateVideoFrames;
+    LateVideoAverageJitter = other.LateVideoAverageJitter;
+    LateVideoMaxJitter = other.LateVideoMaxJitter;
+    LateAudioBuffers = other.LateAudioBuffers;
+    LateAudioAverageJitter = other.LateAudioAverageJitter;
+    LateAudioMaxJitter = other.LateAudioMaxJitter;
+    Rebuffers = other.Rebuffers;
+    RebufferTime = other.RebufferTime;
+    InitialPreroll = other.InitialPreroll;
+    Seeks = other.Seeks;
+    MaxSeekTime = other.MaxSeekTime;
+    MaxVideoLevel = other.MaxVideoLevel;
+    MaxAudioLevel = other.MaxAudioLevel;
+    TrickModeSkippedFrames = other.TrickModeSkippedFrames;
+    QosSkippedFrames = other.QosSkippedFrames;
+    AudioOnlySkippedFrames = other.AudioOnlySkippedFrames;
+    LiveAhead = other.LiveAhead;
+    LiveRateChanges = other.LiveRateChanges;
+    return *this;
+  }
+
+  void Set(const PlayerStats& stats) {
+    VideoFramesProcessed = stats.video_frames_processed;
+    VideoFramesDropped = stats.video_frames_dropped;
+    AudioBuffersDropped = stats.audio_buffers_dropped;
+    LateVideoFrames = stats.late_video.count;
+    LateVideoAverageJitter = stats.late_video.count ? stats.late_video.total_jitter / stats.late_video.count : 0;
+    LateVideoMaxJitter = stats.late_video.max_jitter;
+    LateAudioBuffers = stats.late_audio.count;
+    LateAudioAverageJitter = stats.late_audio.count ? stats.late_audio.total_jitter / stats.late_audio.count : 0;
+    LateAudioMaxJitter = stats.late_audio.max_jitter;
+    Rebuffers = stats.rebuffer_count;
+    RebufferTime = stats.rebuffer_time / kSbTimeMillisecond;
+    InitialPreroll = stats.initial_preroll_time / kSbTimeMillisecond;
+    Seeks = stats.seek_count;
+    MaxSeekTime = stats.max_seek_time / kSbTimeMillisecond;
+    MaxVideoLevel = stats.max_video_appsrc_level_bytes;
+    MaxAudioLevel = stats.max_audio_appsrc_level_bytes;
+    TrickModeSkippedFrames = stats.trick_mode_skipped_frames;
+    QosSkippedFrames = stats.qos_skipped_frames;
+    AudioOnlySkippedFrames = stats.audio_only_skipped_frames;
+    LiveAhead = stats.live_ahead / kSbTimeMillisecond;
+    LiveRateChanges = stats.live_rate_changes;
+  }
+
+  WPEFramework::Core::JSON::DecUInt64 VideoFramesProcessed;
+  WPEFramework::Core::JSON::DecUInt64 VideoFramesDropped;
+  WPEFramework::Core::JSON::DecUInt64 AudioBuffersDropped;
+  WPEFramework::Core::JSON::DecUInt32 LateVideoFrames;
+  WPEFramework::Core::JSON::DecSInt64 LateVideoAverageJitter;
+  WPEFramework::Core::JSON::DecSInt64 LateVideoMaxJitter;
+  WPEFramework::Core::JSON::DecUInt32 LateAudioBuffers;
+  WPEFramework::Core::JSON::DecSInt64 LateAudioAverageJitter;
+  WPEFramework::Core::JSON::DecSInt64 LateAudioMaxJitter;
+  WPEFramework::Core::JSON::DecUInt32 Rebuffers;
+  WPEFramework::Core::JSON::DecSInt64 RebufferTime;
+  WPEFramework::Core::JSON::DecSInt64 InitialPreroll;
+  WPEFramework::Core::JSON::DecUInt32 Seeks;
+  WPEFramework::Core::JSON::DecSInt64 MaxSeekTime;
+  WPEFramework::Core::JSON::DecUInt64 MaxVideoLevel;
+  WPEFramework::Core::JSON::DecUInt64 MaxAudioLevel;
+  WPEFramework::Core::JSON::DecUInt64 TrickModeSkippedFrames;
+  WPEFramework::Core::JSON::DecUInt64 QosSkippedFrames;
+  WPEFramework::Core::JSON::DecUInt64 AudioOnlySkippedFrames;
+  WPEFramework::Core::JSON::DecSInt64 LiveAhead;
+  WPEFramework::Core::JSON::DecUInt32 LiveRateChanges;
+
+private:
+  void Init() {
+    Add(_T("videoframesprocessed"), &VideoFramesProcessed);
+    Add(_T("videoframesdropped"), &VideoFramesDropped);
+    Add(_T("audiobuffersdropped"), &AudioBuffersDropped);
+    Add(_T("latevideoframes"), &LateVideoFrames);
+    Add(_T("latevideoaveragejitter"), &LateVideoAverageJitter);
+    Add(_T("latevideomaxjitter"), &LateVideoMaxJitter);
+    Add(_T("lateaudiobuffers"), &LateAudioBuffers);
+    Add(_T("lateaudioaveragejitter"), &LateAudioAverageJitter);
+    Add(_T("lateaudiomaxjitter"), &LateAudioMaxJitter);
+    Add(_T("rebuffers"), &Rebuffers);
+    Add(_T("rebuffertime"), &RebufferTime);
+    Add(_T("initialpreroll"), &InitialPreroll);
+    Add(_T("seeks"), &Seeks);
+    Add(_T("maxseektime"), &MaxSeekTime);
+    Add(_T("maxvideolevel"), &MaxVideoLevel);
+    Add(_T("maxaudiolevel"), &MaxAudioLevel);
+    Add(_T("trickmodeskippedframes"), &TrickModeSkippedFrames);
+    Add(_T("qosskippedframes"), &QosSkippedFrames);
+    Add(_T("audioonlyskippedframes"), &AudioOnlySkippedFrames);
+    Add(_T("liveahead"), &LiveAhead);
+    Add(_T("liveratechanges"), &LiveRateChanges);
+  }
+};
+
 PlayerImpl::PlayerImpl(SbPlayer player,
                        SbWindow window,
                        SbMediaVideoCodec video_codec,
@@ -1307,6 +1816,7 @@ PlayerImpl::PlayerImpl(SbPlayer player,
                        SbDrmSystem drm_system,
                        const SbMediaAudioSampleInfo& audio_sample_info,
                        const char* max_video_capabilities,
+                       media::DecoderArbiter::Decoder decoder,
                        SbPlayerDeallocateSampleFunc sample_deallocate_func,
                        SbPlayerDecoderStatusFunc decoder_status_func,
                        SbPlayerStatusFunc player_status_func,
@@ -1333,9 +1843,12 @@ PlayerImpl::PlayerImpl(SbPlayer player,
   if (disable_audio)
     audio_codec_ = kSbMediaAudioCodecNone;
 
-  main_loop_context_ = g_main_context_new ();
+  recorder_ = SampleRecorder::Create(video_codec, audio_codec, audio_sample_info);
+
+  main_loop_context_ = media::MediaEventLoopPool::Acquire();
+  if (!main_loop_context_)
+    return;
   g_main_context_push_thread_default(main_loop_context_);
-  main_loop_ = g_main_loop_new(main_loop_context_, FALSE);
 
   GSource* src = g_timeout_source_new(hang_monitor_.GetResetInterval() / kSbTimeMillisecond);
   g_source_set_callback(src, [] (gpointer data) ->gboolean {
@@ -1348,6 +1861,7 @@ PlayerImpl::PlayerImpl(SbPlayer player,
              gst_element_state_get_name(pending),
              gst_element_state_change_return_get_name(result),
              GST_TIME_ARGS(position));
+    RDK_TRACE_COUNTER("PlayerPositionMs", position / GST_MSECOND);
     player.hang_monitor_.Reset();
     return G_SOURCE_CONTINUE;
   }, this, nullptr);
@@ -1357,13 +1871,7 @@ PlayerImpl::PlayerImpl(SbPlayer player,
   GST_INFO("Creating player with max capabilities: %s",
            max_video_capabilities);
 
-  GstElementFactory* src_factory = gst_element_factory_find("cobaltsrc");
-  if (!src_factory) {
-    gst_element_register(0, "cobaltsrc", GST_RANK_PRIMARY + 100,
-                         GST_COBALT_TYPE_SRC);
-  } else {
-    gst_object_unref(src_factory);
-  }
+  RegisterCobaltSrc();
 
   pipeline_ = gst_element_factory_make("playbin", "media_pipeline");
 
@@ -1383,10 +1891,29 @@ PlayerImpl::PlayerImpl(SbPlayer player,
                    G_CALLBACK(&PlayerImpl::SetupElement), this);
   g_object_set(pipeline_, "uri", "cobalt://", nullptr);
 
+  // Used by the replay tool to time the pipeline without a display.
+  static bool fake_sinks = !!getenv("COBALT_PLAYER_FAKE_SINKS");
+  if (fake_sinks) {
+    GstElement* video_sink = gst_element_factory_make("fakesink", "vsink");
+    GstElement* audio_sink = gst_element_factory_make("fakesink", "asink");
+    g_object_set(video_sink, "sync", TRUE, nullptr);
+    g_object_set(audio_sink, "sync", TRUE, nullptr);
+    g_object_set(pipeline_, "video-sink", video_sink, "audio-sink", audio_sink, nullptr);
+  }
+
   if (max_video_capabilities && *max_video_capabilities) {
     max_video_capabilities_ = max_video_capabilities;
-    ConfigureLimitedVideo();
+    if (IsLimitedVideoCapabilities(max_video_capabilities))
+      ConfigureLimitedVideo();
+  }
+  if (decoder == media::DecoderArbiter::kSecondary &&
+      !IsLimitedVideoCapabilities(max_video_capabilities)) {
+    GST_WARNING_OBJECT(pipeline_, "Downgraded to a secondary video decoder");
+    ConfigureSecondaryVideoSink();
   }
+  low_latency_ = IsLowLatencyVideoCapabilities(max_video_capabilities);
+  if (low_latency_)
+    GST_INFO_OBJECT(pipeline_, "Using the low latency profile");
 
   if (audio_codec_ == kSbMediaAudioCodecNone) {
     has_enough_data_ &= ~static_cast<int>(MediaType::kAudio);
@@ -1409,11 +1936,18 @@ PlayerImpl::PlayerImpl(SbPlayer player,
 
   GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
   bus_watch_id_ = gst_bus_add_watch(bus, &PlayerImpl::BusMessageCallback, this);
+  gst_bus_set_sync_handler(bus, &PlayerImpl::BusSyncHandler, this, nullptr);
   gst_object_unref(bus);
 
   video_appsrc_ = gst_element_factory_make("appsrc", "vidsrc");
   audio_appsrc_ = gst_element_factory_make("appsrc", "audsrc");
 
+  if (video_codec_ != kSbMediaVideoCodecNone && IsQosSkipEnabled()) {
+    GstPad* video_src_pad = gst_element_get_static_pad(video_appsrc_, "src");
+    gst_pad_add_probe(video_src_pad, GST_PAD_PROBE_TYPE_BUFFER, &PlayerImpl::VideoBufferProbe, this, nullptr);
+    gst_object_unref(video_src_pad);
+  }
+
   GstElement* playsink = (gst_bin_get_by_name(GST_BIN(pipeline_), "playsink"));
   if (playsink) {
     g_object_set(G_OBJECT(playsink), "send-event-mode", 0, nullptr);
@@ -1433,18 +1967,24 @@ PlayerImpl::PlayerImpl(SbPlayer player,
   ChangePipelineState(GST_STATE_READY);
   g_main_context_pop_thread_default(main_loop_context_);
 
-  playback_thread_ =
-      SbThreadCreate(0, kSbThreadPriorityRealTime, kSbThreadNoAffinity, true,
-                     "playback_thread", &PlayerImpl::ThreadEntryPoint, this);
-  if (SbThreadIsValid(playback_thread_)) {
-    while(!g_main_loop_is_running(main_loop_))
-      g_usleep(1);
-  }
+  // The hang monitor is armed by its timeout source, from the loop thread.
+  state_ = State::kInitial;
+  DispatchOnWorkerThread(new PlayerStatusTask(
+      player_status_func_, player_, ticket_, context_,
+      kSbPlayerStateInitialized));
   GetPlayerRegistry()->Add(this);
 }
 
 PlayerImpl::~PlayerImpl() {
+  if (!main_loop_context_)
+    return;
   GetPlayerRegistry()->Remove(this);
+  media::MediaBufferStorage::Release(this);
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    StartRateSegment(lock, .0);
+  }
+  LogStats();
 
   GST_INFO_OBJECT(pipeline_, "Destroying player");
   {
@@ -1467,23 +2007,75 @@ PlayerImpl::~PlayerImpl() {
   GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
   gst_bus_set_sync_handler(bus, nullptr, nullptr, nullptr);
   gst_object_unref(bus);
-  if (SbThreadIsValid(playback_thread_)) {
-    DispatchOnWorkerThread(new PlayerDestroyedTask(
-      player_status_func_, player_, ticket_, context_, main_loop_));
-    SbThreadJoin(playback_thread_, nullptr);
+  {
+    // Tasks still queued for this player run before the destroyed status,
+    // sources of the same priority dispatch in the order they were
+    // attached. Tasks dispatched from now on are dropped. Other players
+    // keep using the loop.
+    ::starboard::Semaphore done;
+    {
+      ::starboard::ScopedLock lock(tasks_mutex_);
+      tasks_closed_ = true;
+      AttachTask(new PlayerDestroyedTask(
+        player_status_func_, player_, ticket_, context_, &done));
+    }
+    done.Take();
   }
+  // No bus callback can start it anymore once the loop got past this
+  // player's sources.
+  if (SbThreadIsValid(force_stop_thread_))
+    SbThreadJoin(force_stop_thread_, nullptr);
   if (audio_caps_) {
     gst_caps_unref(audio_caps_);
   }
   if (video_caps_) {
     gst_caps_unref(video_caps_);
   }
-  g_main_loop_unref(main_loop_);
-  g_main_context_unref(main_loop_context_);
+  media::MediaEventLoopPool::Release(main_loop_context_);
   g_object_unref(pipeline_);
   GST_INFO("BYE BYE player");
 }
 
+// static
+GstBusSyncReply PlayerImpl::BusSyncHandler(GstBus* bus,
+                                           GstMessage* message,
+                                           gpointer user_data) {
+  SB_UNREFERENCED_PARAMETER(bus);
+  PlayerImpl* self = static_cast<PlayerImpl*>(user_data);
+
+  // Posted from the streaming thread itself when it starts, this is the only
+  // place to set its priority. Streaming threads come from a pool and may
+  // have run an audio task before, the others are set back to normal.
+  if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_STREAM_STATUS) {
+    GstStreamStatusType type;
+    GstElement* owner = nullptr;
+    gst_message_parse_stream_status(message, &type, &owner);
+    if (type == GST_STREAM_STATUS_TYPE_ENTER) {
+      ThreadPriority::Apply(self->IsAudioOrDecryptThread(owner)
+                                ? kSbThreadPriorityHigh
+                                : kSbThreadPriorityNormal);
+    }
+  }
+  return GST_BUS_PASS;
+}
+
+bool PlayerImpl::IsAudioOrDecryptThread(GstElement* owner) const {
+  if (!owner)
+    return false;
+  // The appsrc threads run the decryptors and whatever is chained after
+  // them up to the next queue.
+  if (owner == audio_appsrc_ || (owner == video_appsrc_ && drm_system_))
+    return true;
+  const gchar* klass = gst_element_class_get_metadata(
+      GST_ELEMENT_GET_CLASS(owner), GST_ELEMENT_METADATA_KLASS);
+  if (!klass)
+    return false;
+  if (g_strrstr(klass, "Decryptor"))
+    return true;
+  return g_strrstr(klass, "Audio") &&
+         (g_strrstr(klass, "Sink") || g_strrstr(klass, "Decoder"));
+}
+
 // static
 gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
                                         GstMessage* message,
@@ -1492,6 +2084,7 @@ gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
 
   PlayerImpl* self = static_cast<PlayerImpl*>(user_data);
   GST_TRACE("%d", SbThreadGetId());
+  RDK_TRACE_SCOPE(GST_MESSAGE_TYPE_NAME(message));
 
   switch (GST_MESSAGE_TYPE(message)) {
     case GST_MESSAGE_APPLICATION: {
@@ -1560,6 +2153,14 @@ gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
                                           GST_DEBUG_GRAPH_SHOW_ALL,
                                           file_name.c_str());
 
+        if (new_state == GST_STATE_PLAYING) {
+          ::starboard::ScopedLock lock(self->mutex_);
+          if (self->rebuffer_start_time_) {
+            self->stats_.rebuffer_time += SbTimeGetMonotonicNow() - self->rebuffer_start_time_;
+            self->rebuffer_start_time_ = 0;
+          }
+        }
+
         if (GST_STATE(self->pipeline_) >= GST_STATE_PAUSED) {
           int ticket = 0;
           bool is_seek_pending = false;
@@ -1616,7 +2217,7 @@ gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
             self->state_ == State::kInitialPreroll) {
 
           bool is_seek_pending = self->is_seek_pending_;
-          bool has_pending_samples = (self->pending_samples_.empty() == false) || self->has_oob_write_pending_;
+          bool has_pending_samples = (self->pending_samples_.IsEmpty() == false) || self->has_oob_write_pending_;
 
           if (!is_seek_pending && has_pending_samples) {
 
@@ -1635,6 +2236,17 @@ gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
           }
           GST_INFO("===> Asuming preroll done");
 
+          SbTimeMonotonic now = SbTimeGetMonotonicNow();
+          if (self->state_ == State::kInitialPreroll) {
+            self->stats_.initial_preroll_time = now - self->create_time_;
+          } else if (self->seek_start_time_) {
+            SbTime seek_time = now - self->seek_start_time_;
+            ++self->stats_.seek_count;
+            self->stats_.total_seek_time += seek_time;
+            self->stats_.max_seek_time = std::max(self->stats_.max_seek_time, seek_time);
+          }
+          self->seek_start_time_ = 0;
+
           // The below code is good but on BRCM the decoder reports old
           // position for some time which makes some YTLB 2020 test failing.
           // self->seek_position_ = kSbTimeMax;
@@ -1655,28 +2267,17 @@ gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
       gst_bin_recalculate_latency(GST_BIN(self->pipeline_));
       break;
 
-    case GST_MESSAGE_QOS: {
-      const gchar *klass;
-      klass = gst_element_class_get_metadata (
-          GST_ELEMENT_GET_CLASS (GST_MESSAGE_SRC(message)),
-          GST_ELEMENT_METADATA_KLASS);
-      if (g_strrstr(klass, "Video")) {
-        GstFormat format;
-        guint64 dropped = 0, processed = 0;
-        GstDebugLevel log_level = GST_LEVEL_DEBUG;
-        gst_message_parse_qos_stats(message, &format, &processed, &dropped);
-        if (format == GST_FORMAT_BUFFERS) {
-          ::starboard::ScopedLock lock(self->mutex_);
-          if (self->dropped_video_frames_ != static_cast<int>(dropped)) {
-            log_level = GST_LEVEL_INFO;
-            self->dropped_video_frames_ = static_cast<int>(dropped);
-          }
-        }
-        GST_CAT_LEVEL_LOG (
-          GST_CAT_DEFAULT, log_level, NULL,
-          "QOS written = %d, processed = %" G_GUINT64_FORMAT ", dropped = %" G_GUINT64_FORMAT,
-          self->total_video_frames_, processed, dropped);
-      }
+    case GST_MESSAGE_QOS:
+      self->HandleQosMessage(message);
+      break;
+
+    case GST_MESSAGE_BUFFERING: {
+      gint percent = 0;
+      gst_message_parse_buffering(message, &percent);
+      GST_DEBUG_OBJECT(GST_MESSAGE_SRC(message), "Buffering %d%%", percent);
+      ::starboard::ScopedLock lock(self->mutex_);
+      ++self->stats_.buffering_messages;
+      self->stats_.min_buffering_percent = std::min(self->stats_.min_buffering_percent, percent);
     } break;
 
     default:
@@ -1688,27 +2289,19 @@ gboolean PlayerImpl::BusMessageCallback(GstBus* bus,
   return TRUE;
 }
 
-// static
-void* PlayerImpl::ThreadEntryPoint(void* context) {
-  SB_DCHECK(context);
-  GST_TRACE("%d", SbThreadGetId());
-
-  PlayerImpl* self = reinterpret_cast<PlayerImpl*>(context);
-  self->state_ = State::kInitial;
-
-  g_main_context_push_thread_default(self->main_loop_context_);
-
-  self->hang_monitor_.Reset();
-
-  self->DispatchOnWorkerThread(new PlayerStatusTask(
-      self->player_status_func_, self->player_, self->ticket_, self->context_,
-      kSbPlayerStateInitialized));
-  g_main_loop_run(self->main_loop_);
-
-  return nullptr;
+void PlayerImpl::DispatchOnWorkerThread(Task* task) const {
+  ::starboard::ScopedLock lock(tasks_mutex_);
+  if (tasks_closed_) {
+    // The destroyed status is queued already, nothing may follow it.
+    GST_DEBUG_OBJECT(pipeline_, "Dropping task of a destroyed player");
+    task->PrintInfo();
+    delete task;
+    return;
+  }
+  AttachTask(task);
 }
 
-void PlayerImpl::DispatchOnWorkerThread(Task* task) const {
+void PlayerImpl::AttachTask(Task* task) const {
   GSource* src = g_source_new(&SourceFunctions, sizeof(GSource));
   g_source_set_ready_time(src, 0);
   DispatchData* data = new DispatchData(task, src);
@@ -1741,12 +2334,12 @@ gboolean PlayerImpl::FinishSourceSetup(gpointer user_data) {
   if (self->audio_codec_ != kSbMediaAudioCodecNone) {
     gst_cobalt_src_setup_and_add_app_src(kSbMediaTypeAudio,
         source, self->audio_appsrc_, self->audio_caps_,
-        &callbacks, self, has_drm_system);
+        &callbacks, self, has_drm_system, self->low_latency_);
   }
   if (self->video_codec_ != kSbMediaVideoCodecNone) {
     gst_cobalt_src_setup_and_add_app_src(kSbMediaTypeVideo,
         source, self->video_appsrc_, self->video_caps_,
-        &callbacks, self, has_drm_system);
+        &callbacks, self, has_drm_system, self->low_latency_);
   }
   gst_cobalt_src_all_app_srcs_added(self->source_);
   self->source_setup_id_ = -1;
@@ -1761,6 +2354,7 @@ void PlayerImpl::AppSrcNeedData(GstAppSrc* src,
   PlayerImpl* self = static_cast<PlayerImpl*>(user_data);
 
   GST_LOG_OBJECT(src, "===> Gimme more data");
+  RDK_TRACE_INSTANT(src == GST_APP_SRC(self->video_appsrc_) ? "VideoNeedData" : "AudioNeedData");
 
   ::starboard::ScopedLock lock(self->mutex_);
   int need_data = static_cast<int>(MediaType::kNone);
@@ -1791,6 +2385,7 @@ void PlayerImpl::AppSrcNeedData(GstAppSrc* src,
 // static
 void PlayerImpl::AppSrcEnoughData(GstAppSrc* src, gpointer user_data) {
   PlayerImpl* self = static_cast<PlayerImpl*>(user_data);
+  RDK_TRACE_INSTANT(src == GST_APP_SRC(self->video_appsrc_) ? "VideoEnoughData" : "AudioEnoughData");
 
   ::starboard::ScopedLock lock(self->mutex_);
 
@@ -1861,6 +2456,9 @@ void PlayerImpl::SetupElement(GstElement* pipeline,
 }
 
 void PlayerImpl::MarkEOS(SbMediaType stream_type) {
+  if (recorder_)
+    recorder_->RecordEndOfStream(stream_type);
+
   GstElement* src = nullptr;
   if (stream_type == kSbMediaTypeVideo) {
     src = video_appsrc_;
@@ -1932,6 +2530,9 @@ bool PlayerImpl::WriteSample(SbMediaType sample_type, GstBuffer* buffer, uint64_
       (buf_target_min_ts_ != kSbTimeMax &&
        min_sample_timestamp_origin_ == media);
 
+  if (!has_enough && low_latency_ && buf_target_min_ts_ == kSbTimeMax)
+    has_enough = HoldLiveData(lock, media);
+
   if (!has_enough || force_buf) {
     GST_LOG_OBJECT(src, "Asking for more (forced buffering? %s)", force_buf ? "yes" : "no");
     DecoderNeedsData(lock, media);
@@ -1949,6 +2550,9 @@ void PlayerImpl::WriteSample(SbMediaType sample_type,
                 "Adjust impl. to handle more samples after changing samples"
                 "count");
   SB_DCHECK(number_of_sample_infos == kMaxNumberOfSamplesPerWrite);
+  RDK_TRACE_SCOPE(sample_type == kSbMediaTypeVideo ? "WriteVideoSample" : "WriteAudioSample");
+  if (recorder_)
+    recorder_->RecordSample(sample_type, sample_infos[0]);
   // For debuggin purposes it could be usefull to disable audio or video
   // in this case just drop the sample
   if (audio_codec_ == kSbMediaAudioCodecNone && sample_type == kSbMediaTypeAudio) {
@@ -1959,9 +2563,19 @@ void PlayerImpl::WriteSample(SbMediaType sample_type,
       sample_deallocate_func_(player_, context_, sample_infos[0].buffer);
       return;
   }
+  if (sample_type == kSbMediaTypeVideo &&
+      SkipForTrickMode(sample_infos[0].video_sample_info.is_key_frame)) {
+      sample_deallocate_func_(player_, context_, sample_infos[0].buffer);
+      return;
+  }
+  if (sample_type == kSbMediaTypeVideo && SkipForAudioOnly(sample_infos[0])) {
+      sample_deallocate_func_(player_, context_, sample_infos[0].buffer);
+      return;
+  }
+  const bool droppable = sample_type == kSbMediaTypeVideo && IsDroppableForQos(sample_infos[0]);
   GstClockTime timestamp = sample_infos[0].timestamp * kSbTimeNanosecondsPerMicrosecond;
   GstBuffer* buffer =
-      gst_buffer_new_allocate(nullptr, sample_infos[0].buffer_size, nullptr);
+      media::MediaBufferStorage::AllocateBuffer(this, sample_infos[0].buffer_size, timestamp);
   gsize sz = gst_buffer_fill(buffer, 0, sample_infos[0].buffer, sample_infos[0].buffer_size);
   SB_DCHECK(sz == sample_infos[0].buffer_size);
   GST_BUFFER_TIMESTAMP(buffer) = timestamp;
@@ -1988,6 +2602,9 @@ void PlayerImpl::WriteSample(SbMediaType sample_type,
     if (!info.is_key_frame) {
       GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
     }
+    if (droppable) {
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DROPPABLE);
+    }
   }
 
   RecordTimestamp(sample_type, timestamp);
@@ -2092,8 +2709,16 @@ void PlayerImpl::WriteSample(SbMediaType sample_type,
     ::starboard::ScopedLock lock(mutex_);
     keep_samples = is_seek_pending_;
     serial = samples_serial_[ (sample_type == kSbMediaTypeVideo ? kVideoIndex : kAudioIndex) ]++;
-    if (sample_type == kSbMediaTypeVideo)
+    if (sample_type == kSbMediaTypeVideo) {
       ++total_video_frames_;
+      ++rate_segment_.frames_written;
+    } else {
+      last_audio_timestamp_ = sample_infos[0].timestamp;
+      if (parked_video_timestamp_ <= last_audio_timestamp_) {
+        parked_video_timestamp_ = kSbTimeMax;
+        DecoderNeedsData(lock, MediaType::kVideo);
+      }
+    }
     if (seek_position_ != kSbTimeMax)
         seek_pos_ns =  seek_position_ * kSbTimeNanosecondsPerMicrosecond;
   }
@@ -2108,10 +2733,15 @@ void PlayerImpl::WriteSample(SbMediaType sample_type,
     GST_INFO("Pending flushing operation. Storing sample");
     GST_INFO("SampleType:%d %" GST_TIME_FORMAT " id:%llu b:%" GST_PTR_FORMAT,
              sample_type, GST_TIME_ARGS(GST_BUFFER_TIMESTAMP(buffer)), serial, buffer);
-    PendingSample sample(sample_type, buffer, serial);
-    buffer= nullptr;
     ::starboard::ScopedLock lock(mutex_);
-    pending_samples_.emplace_back(std::move(sample));
+    if (pending_samples_.IsFull()) {
+      GST_ERROR("No room for pending sample id:%llu, writing it now", serial);
+      keep_samples = false;
+    } else {
+      PendingSample sample(sample_type, buffer, serial);
+      buffer= nullptr;
+      pending_samples_.PushBack(std::move(sample));
+    }
   }
 
   {
@@ -2128,35 +2758,28 @@ void PlayerImpl::WriteSample(SbMediaType sample_type,
   }
 
   if (keep_samples) {
-    PendingSamples local_samples;
+    GstBuffer* buffer_ref = nullptr;
     {
       ::starboard::ScopedLock lock(mutex_);
-      local_samples.swap(pending_samples_);
-    }
-
-    if(local_samples.empty()) {
-      GST_WARNING("No pending samples");
-      return;
-    }
-
-    auto& sample = local_samples.back();
+      if (pending_samples_.IsEmpty()) {
+        GST_WARNING("No pending samples");
+        return;
+      }
 
-    SB_CHECK(sample.Type() == sample_type);
+      const PendingSample& sample = pending_samples_.Back();
 
-    if (serial != sample.SerialID()) {
-      GST_WARNING("Detected out-of-order sample. Expected serial: %llu, sample serial: %llu",
-                  serial, sample.SerialID());
-    }
+      SB_CHECK(sample.Type() == sample_type);
 
-    GstBuffer* buffer_copy = sample.CopyBuffer();
-    if (!WriteSample(sample.Type(), buffer_copy, sample.SerialID())) {
-      gst_buffer_unref(buffer_copy);
+      if (serial != sample.SerialID()) {
+        GST_WARNING("Detected out-of-order sample. Expected serial: %llu, sample serial: %llu",
+                    serial, sample.SerialID());
+        serial = sample.SerialID();
+      }
+      buffer_ref = sample.RefBuffer();
     }
 
-    {
-      ::starboard::ScopedLock lock(mutex_);
-      std::move(local_samples.begin(), local_samples.end(),
-                std::back_inserter(pending_samples_));
+    if (!WriteSample(sample_type, buffer_ref, serial)) {
+      gst_buffer_unref(buffer_ref);
     }
   } else {
     if (!WriteSample(sample_type, buffer, serial)) {
@@ -2174,7 +2797,10 @@ void PlayerImpl::SetVolume(double volume) {
 }
 
 void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
+  RDK_TRACE_SCOPE("Seek");
   ::starboard::ScopedLock lock(seek_mutex_);
+  if (recorder_)
+    recorder_->RecordSeek(seek_to_timestamp, ticket);
   gint64 current_pos_ns = GetPosition();
   GST_INFO_OBJECT(pipeline_, "===> time %" PRId64 " (target=%" GST_TIME_FORMAT ", curr=%" GST_TIME_FORMAT ") TID: %d state %d, ticket = %d",
                    seek_to_timestamp,
@@ -2184,6 +2810,7 @@ void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
                    static_cast<int>(state_),
                    ticket);
   double rate = 1.;
+  bool trick_mode = false;
   {
     ::starboard::ScopedLock lock(mutex_);
     if (ticket_ > ticket) {
@@ -2192,7 +2819,8 @@ void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
     }
 
     if (ticket_ != ticket) {
-      pending_samples_.clear();
+      pending_samples_.Clear();
+      pending_samples_held_data_ = static_cast<int>(MediaType::kNone);
       max_sample_timestamps_[kVideoIndex] = 0;
       max_sample_timestamps_[kAudioIndex] = 0;
       min_sample_timestamp_ = kSbTimeMax;
@@ -2201,12 +2829,24 @@ void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
       buf_target_min_ts_ = kSbTimeMax;
       dropped_video_frames_ = 0;
       total_video_frames_ = 0;
+      qos_skip_ = QosSkip::kNone;
+      qos_late_messages_ = 0;
+      qos_skipped_video_frames_ = 0;
+      parked_video_timestamp_ = kSbTimeMax;
+      last_audio_timestamp_ = 0;
     }
 
     ticket_ = ticket;
     seek_position_ = seek_to_timestamp;
     decoder_state_data_ = 0;
     eos_data_ = 0;
+    rebuffer_start_time_ = 0;
+    // The seek applies rate_ and the requests start over.
+    live_rate_ = 1.0;
+    live_position_ = GST_CLOCK_TIME_NONE;
+    live_held_data_ = static_cast<int>(MediaType::kNone);
+    if (state_ != State::kInitial && !seek_start_time_)
+      seek_start_time_ = SbTimeGetMonotonicNow();
 
     if (state_ == State::kInitial) {
       SB_DCHECK(seek_position_ == .0);
@@ -2242,6 +2882,7 @@ void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
 
     is_seek_pending_ = false;
     rate = rate_;
+    trick_mode = trick_mode_;
     state_ = State::kPrerollAfterSeek;
   }
 
@@ -2249,9 +2890,13 @@ void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
   DispatchOnWorkerThread(new PlayerStatusTask(player_status_func_, player_,
                                               ticket_, context_,
                                               kSbPlayerStatePrerolling));
+  int seek_flags = GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE;
+  if (trick_mode) {
+    seek_flags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS |
+                  GST_SEEK_FLAG_TRICKMODE_NO_AUDIO;
+  }
   if (!gst_element_seek(pipeline_, !rate ? 1.0 : rate, GST_FORMAT_TIME,
-                        static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH |
-                                                  GST_SEEK_FLAG_ACCURATE),
+                        static_cast<GstSeekFlags>(seek_flags),
                         GST_SEEK_TYPE_SET,
                         seek_to_timestamp * kSbTimeNanosecondsPerMicrosecond,
                         GST_SEEK_TYPE_NONE, 0)) {
@@ -2267,23 +2912,34 @@ void PlayerImpl::Seek(SbTime seek_to_timestamp, int ticket) {
 }
 
 bool PlayerImpl::SetRate(double rate) {
+  RDK_TRACE_SCOPE("SetRate");
+  if (recorder_)
+    recorder_->RecordRate(rate);
+
   GST_DEBUG_OBJECT(pipeline_, "===> rate %lf (rate_ %lf), TID: %d", rate, rate_,
                    SbThreadGetId());
 
   bool success = true;
+  bool need_instant_rate_change;
   {
     ::starboard::ScopedLock lock(mutex_);
     decoder_state_data_ = 0;
     eos_data_ = 0;
+    if (rate != rate_segment_.rate || rate_segment_.start_time == 0)
+      StartRateSegment(lock, rate);
+    need_instant_rate_change = need_instant_rate_change_;
   }
 
+  if (rate != .0)
+    UpdateTrickMode(rate);
+
   if (rate == .0) {
     ChangePipelineState(GST_STATE_PAUSED);
   } else {
     ChangePipelineState(GST_STATE_PLAYING);
   }
 
-  if (rate != .0 && (rate != 1. || need_instant_rate_change_)) {
+  if (rate != .0 && (rate != 1. || need_instant_rate_change)) {
     {
       ::starboard::ScopedLock lock(mutex_);
       if (is_seek_pending_) {
@@ -2299,36 +2955,13 @@ bool PlayerImpl::SetRate(double rate) {
       pending_rate_ = .0;
     }
 
-    // TODO: remove special handling of amlhalasink
-    GstElement* sink = nullptr;
-    g_object_get(pipeline_, "audio-sink", &sink, nullptr);
-    if (sink && g_str_has_prefix(GST_ELEMENT_NAME(sink), "amlhalasink")) {
-      GstSegment* segment = gst_segment_new();
-      gst_segment_init(segment, GST_FORMAT_TIME);
-      segment->rate = rate;
-      segment->start = GST_CLOCK_TIME_NONE;
-      segment->position = GST_CLOCK_TIME_NONE;
-      GST_DEBUG_OBJECT(pipeline_, "===> Sending new segment %" GST_SEGMENT_FORMAT, segment);
-      success = gst_pad_send_event (GST_BASE_SINK_PAD(sink), gst_event_new_segment(segment));
-      GST_DEBUG_OBJECT(pipeline_, "===> Sent new segment, success = %s", success ? "true" : "false");
-      gst_segment_free(segment);
-    }
-    else {
-      GstStructure* s = gst_structure_new(
-        kCustomInstantRateChangeEventName, "rate", G_TYPE_DOUBLE, rate, NULL);
-      success = gst_element_send_event(
-        pipeline_, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM_OOB, s));
-    }
-
-    if (sink)
-      g_object_unref(sink);
-
-    need_instant_rate_change_ = ( rate != 1. );
+    success = SendRateChange(rate);
   }
 
   if (success) {
     ::starboard::ScopedLock lock(mutex_);
     rate_ = rate;
+    live_rate_ = 1.0;
   } else {
     GST_ERROR_OBJECT(pipeline_, "Set rate failed");
   }
@@ -2336,6 +2969,37 @@ bool PlayerImpl::SetRate(double rate) {
   return success;
 }
 
+bool PlayerImpl::SendRateChange(double rate) {
+  bool success = true;
+  // TODO: remove special handling of amlhalasink
+  GstElement* sink = nullptr;
+  g_object_get(pipeline_, "audio-sink", &sink, nullptr);
+  if (sink && g_str_has_prefix(GST_ELEMENT_NAME(sink), "amlhalasink")) {
+    GstSegment* segment = gst_segment_new();
+    gst_segment_init(segment, GST_FORMAT_TIME);
+    segment->rate = rate;
+    segment->start = GST_CLOCK_TIME_NONE;
+    segment->position = GST_CLOCK_TIME_NONE;
+    GST_DEBUG_OBJECT(pipeline_, "===> Sending new segment %" GST_SEGMENT_FORMAT, segment);
+    success = gst_pad_send_event (GST_BASE_SINK_PAD(sink), gst_event_new_segment(segment));
+    GST_DEBUG_OBJECT(pipeline_, "===> Sent new segment, success = %s", success ? "true" : "false");
+    gst_segment_free(segment);
+  }
+  else {
+    GstStructure* s = gst_structure_new(
+      kCustomInstantRateChangeEventName, "rate", G_TYPE_DOUBLE, rate, NULL);
+    success = gst_element_send_event(
+      pipeline_, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM_OOB, s));
+  }
+
+  if (sink)
+    g_object_unref(sink);
+
+  ::starboard::ScopedLock lock(mutex_);
+  need_instant_rate_change_ = ( rate != 1. );
+  return success;
+}
+
 void PlayerImpl::GetInfo(SbPlayerInfo2* out_player_info) {
   gint64 duration = 0;
   if (gst_element_query_duration(pipeline_, GST_FORMAT_TIME, &duration) &&
@@ -2348,6 +3012,11 @@ void PlayerImpl::GetInfo(SbPlayerInfo2* out_player_info) {
   gint64 position = GetPosition();
 
   CheckBuffering(position);
+  media::MediaBufferStorage::ReadAhead(this, position);
+  if (low_latency_) {
+    ReleaseLiveData(position);
+    AdjustLiveRate(position);
+  }
 
   GST_TRACE("Position: %" GST_TIME_FORMAT " (Seek to: %" GST_TIME_FORMAT
             ") Duration: %" GST_TIME_FORMAT,
@@ -2368,19 +3037,32 @@ void PlayerImpl::GetInfo(SbPlayerInfo2* out_player_info) {
   out_player_info->total_video_frames = total_video_frames_;
   out_player_info->corrupted_video_frames = 0;
 
+  guint64 video_level = video_appsrc_ ? gst_app_src_get_current_level_bytes(GST_APP_SRC(video_appsrc_)) : 0;
+  guint64 audio_level = audio_appsrc_ ? gst_app_src_get_current_level_bytes(GST_APP_SRC(audio_appsrc_)) : 0;
+
+  int skipped_video_frames = 0;
   {
     ::starboard::ScopedLock lock(mutex_);
+    skipped_video_frames = qos_skipped_video_frames_;
+    // Only what the sink dropped, the frames skipped before decoding are in
+    // the player stats.
     out_player_info->dropped_video_frames = dropped_video_frames_;
+    stats_.video_appsrc_level_bytes = video_level;
+    stats_.audio_appsrc_level_bytes = audio_level;
+    stats_.max_video_appsrc_level_bytes = std::max<uint64_t>(stats_.max_video_appsrc_level_bytes, video_level);
+    stats_.max_audio_appsrc_level_bytes = std::max<uint64_t>(stats_.max_audio_appsrc_level_bytes, audio_level);
   }
 
-  GST_LOG("Frames dropped: %d, Frames corrupted: %d",
+  GST_LOG("Frames dropped: %d (skipped: %d), Frames corrupted: %d",
           out_player_info->dropped_video_frames,
+          skipped_video_frames,
           out_player_info->corrupted_video_frames);
   out_player_info->playback_rate = rate_;
 }
 
 void PlayerImpl::SetBounds(int zindex, int x, int y, int w, int h) {
   GST_TRACE("Set Bounds: %d %d %d %d %d", zindex, x, y, w, h);
+  media::DecoderArbiter::SetVisible(player_, w > 0 && h > 0);
   GstElement* vid_sink = nullptr;
   g_object_get(pipeline_, "video-sink", &vid_sink, nullptr);
   if (vid_sink && g_object_class_find_property(G_OBJECT_GET_CLASS(vid_sink),
@@ -2395,6 +3077,316 @@ void PlayerImpl::SetBounds(int zindex, int x, int y, int w, int h) {
     gst_object_unref(GST_OBJECT(vid_sink));
 }
 
+void PlayerImpl::GetStats(PlayerStats* stats) {
+  ::starboard::ScopedLock lock(mutex_);
+  *stats = stats_;
+}
+
+void PlayerImpl::HandleQosMessage(GstMessage* message) {
+  const gchar* klass = gst_element_class_get_metadata(
+      GST_ELEMENT_GET_CLASS(GST_MESSAGE_SRC(message)),
+      GST_ELEMENT_METADATA_KLASS);
+  bool is_video = g_strrstr(klass, "Video") != nullptr;
+
+  GstFormat format;
+  guint64 dropped = 0, processed = 0;
+  gint64 jitter = 0;
+  gst_message_parse_qos_stats(message, &format, &processed, &dropped);
+  gst_message_parse_qos_values(message, &jitter, nullptr, nullptr);
+
+  GstDebugLevel log_level = GST_LEVEL_DEBUG;
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    SbTime late = jitter / kSbTimeNanosecondsPerMicrosecond;
+    if (late > 0) {
+      PlayerStats::Late& late_stats = is_video ? stats_.late_video : stats_.late_audio;
+      ++late_stats.count;
+      late_stats.total_jitter += late;
+      late_stats.max_jitter = std::max(late_stats.max_jitter, late);
+    }
+    if (is_video)
+      UpdateQosSkip(lock, late);
+    if (is_video) {
+      // Frames, whichever of the two the sink reports in.
+      if (format == GST_FORMAT_BUFFERS || format == GST_FORMAT_DEFAULT) {
+        if (dropped_video_frames_ != static_cast<int>(dropped)) {
+          log_level = GST_LEVEL_INFO;
+          dropped_video_frames_ = static_cast<int>(dropped);
+        }
+        stats_.video_frames_processed = processed;
+        stats_.video_frames_dropped = dropped;
+      }
+    } else if (format == GST_FORMAT_BUFFERS) {
+      stats_.audio_buffers_dropped = dropped;
+    } else if (dropped > 0 && (format == GST_FORMAT_DEFAULT || format == GST_FORMAT_TIME)) {
+      ++stats_.audio_buffers_dropped;
+    }
+  }
+
+  if (is_video) {
+    GST_CAT_LEVEL_LOG (
+      GST_CAT_DEFAULT, log_level, NULL,
+      "QOS written = %d, processed = %" G_GUINT64_FORMAT ", dropped = %" G_GUINT64_FORMAT
+      ", jitter = %" G_GINT64_FORMAT,
+      total_video_frames_, processed, dropped, jitter);
+  }
+}
+
+void PlayerImpl::LogStats() {
+  PlayerStats stats;
+  GetStats(&stats);
+  GST_INFO("Player stats:"
+           " video processed/dropped: %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT
+           ", audio dropped: %" G_GUINT64_FORMAT
+           ", late video/audio: %d/%d (avg %" PRId64 "/%" PRId64 "us, max %" PRId64 "/%" PRId64 "us)"
+           ", rebuffers: %d (%" PRId64 "ms)"
+           ", buffering msgs: %d (min %d%%)"
+           ", max appsrc level video/audio: %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT " bytes"
+           ", initial preroll: %" PRId64 "ms"
+           ", seeks: %d (avg %" PRId64 "ms, max %" PRId64 "ms)"
+           ", trick play skipped frames: %" G_GUINT64_FORMAT
+           ", qos skipped frames: %" G_GUINT64_FORMAT
+           ", audio only skipped frames: %" G_GUINT64_FORMAT
+           ", live ahead: %" PRId64 "ms (rate changes: %d)",
+           stats.video_frames_processed, stats.video_frames_dropped,
+           stats.audio_buffers_dropped,
+           stats.late_video.count, stats.late_audio.count,
+           stats.late_video.count ? stats.late_video.total_jitter / stats.late_video.count : 0,
+           stats.late_audio.count ? stats.late_audio.total_jitter / stats.late_audio.count : 0,
+           stats.late_video.max_jitter, stats.late_audio.max_jitter,
+           stats.rebuffer_count, stats.rebuffer_time / kSbTimeMillisecond,
+           stats.buffering_messages, stats.min_buffering_percent,
+           stats.max_video_appsrc_level_bytes, stats.max_audio_appsrc_level_bytes,
+           stats.initial_preroll_time / kSbTimeMillisecond,
+           stats.seek_count,
+           stats.seek_count ? stats.total_seek_time / stats.seek_count / kSbTimeMillisecond : 0,
+           stats.max_seek_time / kSbTimeMillisecond,
+           stats.trick_mode_skipped_frames,
+           stats.qos_skipped_frames,
+           stats.audio_only_skipped_frames,
+           stats.live_ahead / kSbTimeMillisecond, stats.live_rate_changes);
+}
+
+void PlayerImpl::UpdateTrickMode(double rate) {
+  double min_rate = GetTrickModeMinRate();
+  bool enable = min_rate > .0 && rate > min_rate;
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    if (enable == trick_mode_)
+      return;
+    trick_mode_ = enable;
+    if (enable)
+      skip_delta_frames_ = true;
+  }
+  GST_INFO_OBJECT(pipeline_, "%s key frame only playback at rate %lf",
+                  enable ? "Starting" : "Stopping", rate);
+  // Leave the mute state as the app had it once trick play ends.
+  GstStreamVolume* volume = GST_STREAM_VOLUME(pipeline_);
+  if (enable) {
+    muted_before_trick_mode_ = gst_stream_volume_get_mute(volume);
+    if (!muted_before_trick_mode_)
+      gst_stream_volume_set_mute(volume, TRUE);
+  } else if (!muted_before_trick_mode_) {
+    gst_stream_volume_set_mute(volume, FALSE);
+  }
+}
+
+bool PlayerImpl::SkipForTrickMode(bool is_key_frame) {
+  ::starboard::ScopedLock lock(mutex_);
+  if (!skip_delta_frames_)
+    return false;
+  if (is_key_frame) {
+    // After trick play decoding resumes from the next key frame.
+    if (!trick_mode_)
+      skip_delta_frames_ = false;
+    return false;
+  }
+  ++stats_.trick_mode_skipped_frames;
+  ++rate_segment_.frames_skipped;
+  // Nothing reached appsrc, so ask for the next sample right away.
+  decoder_state_data_ &= ~static_cast<int>(MediaType::kVideo);
+  DecoderNeedsData(lock, MediaType::kVideo);
+  return true;
+}
+
+void PlayerImpl::UpdateQosSkip(::starboard::ScopedLock&, SbTime late) {
+  if (!IsQosSkipEnabled())
+    return;
+  // The sink's jitter is how far behind the clock the frame was shown, one
+  // late frame now and then is not worth skipping for.
+  if (late < kQosSkipMinLate) {
+    qos_late_messages_ = 0;
+    return;
+  }
+  ++qos_late_messages_;
+  qos_last_late_time_ = SbTimeGetMonotonicNow();
+  if (qos_skip_ != QosSkip::kNone || qos_late_messages_ < kQosSkipLateMessages)
+    return;
+
+  QosSkip skip = QosSkip::kNone;
+  if (video_codec_ == kSbMediaVideoCodecH264 || video_codec_ == kSbMediaVideoCodecH265)
+    skip = QosSkip::kNonReference;
+  else if ((video_codec_ == kSbMediaVideoCodecVp9 || video_codec_ == kSbMediaVideoCodecAv1) &&
+           late >= kQosSkipKeyFrameLate)
+    skip = QosSkip::kUntilKeyFrame;
+  if (skip == QosSkip::kNone)
+    return;
+
+  GST_INFO_OBJECT(pipeline_, "Video %" PRId64 "ms late, skipping %s",
+                  late / kSbTimeMillisecond,
+                  skip == QosSkip::kUntilKeyFrame ? "until the next key frame" : "non-reference frames");
+  qos_skip_ = skip;
+}
+
+bool PlayerImpl::IsDroppableForQos(const SbPlayerSampleInfo& sample_info) {
+  if (!IsQosSkipEnabled())
+    return false;
+  // Only clear bytes can be parsed, the first subsample covers the headers.
+  size_t size = sample_info.buffer_size;
+  if (sample_info.drm_info) {
+    size = sample_info.drm_info->subsample_count
+      ? std::min<size_t>(size, sample_info.drm_info->subsample_mapping[0].clear_byte_count)
+      : 0;
+  }
+  const uint8_t* data = static_cast<const uint8_t*>(sample_info.buffer);
+  if (sample_info.video_sample_info.is_key_frame) {
+    if (video_codec_ == kSbMediaVideoCodecH265) {
+      int max_temporal_id = GetHevcMaxTemporalId(data, size);
+      if (max_temporal_id >= 0)
+        hevc_max_temporal_id_ = max_temporal_id;
+    }
+    return false;
+  }
+  return IsNonReferenceFrame(video_codec_, data, size, hevc_max_temporal_id_);
+}
+
+// static
+GstPadProbeReturn PlayerImpl::VideoBufferProbe(GstPad* pad,
+                                               GstPadProbeInfo* info,
+                                               gpointer user_data) {
+  PlayerImpl* self = static_cast<PlayerImpl*>(user_data);
+  return self->SkipForQos(GST_PAD_PROBE_INFO_BUFFER(info)) ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+}
+
+// Runs on the video appsrc streaming thread, as the sample heads for the
+// decoder.
+bool PlayerImpl::SkipForQos(GstBuffer* buffer) {
+  ::starboard::ScopedLock lock(mutex_);
+  if (qos_skip_ == QosSkip::kNone || trick_mode_)
+    return false;
+
+  if (qos_skip_ == QosSkip::kUntilKeyFrame) {
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+      // Give the decoder a chance to catch up from here.
+      GST_INFO_OBJECT(pipeline_, "Resuming video at a key frame");
+      qos_skip_ = QosSkip::kNone;
+      qos_late_messages_ = 0;
+      return false;
+    }
+  } else {
+    if (SbTimeGetMonotonicNow() - qos_last_late_time_ > kQosSkipRecoveryTime) {
+      GST_INFO_OBJECT(pipeline_, "Video back on time, stop skipping");
+      qos_skip_ = QosSkip::kNone;
+      qos_late_messages_ = 0;
+      return false;
+    }
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DROPPABLE))
+      return false;
+  }
+
+  ++stats_.qos_skipped_frames;
+  ++qos_skipped_video_frames_;
+  return true;
+}
+
+void PlayerImpl::SetAudioOnly(bool audio_only) {
+  if (video_codec_ == kSbMediaVideoCodecNone)
+    return;
+  ::starboard::ScopedLock lock(mutex_);
+  if (audio_only == audio_only_)
+    return;
+  audio_only_ = audio_only;
+  SbTimeMonotonic now = SbTimeGetMonotonicNow();
+  SbTime cpu_time = GetProcessCpuTime();
+  if (audio_only) {
+    audio_only_start_time_ = now;
+    audio_only_start_cpu_time_ = cpu_time;
+    audio_only_skipped_frames_ = 0;
+    GST_INFO_OBJECT(pipeline_, "Switching to audio only");
+    return;
+  }
+
+  SbTime elapsed = now - audio_only_start_time_;
+  GST_INFO_OBJECT(pipeline_, "Leaving audio only after %" PRId64 "ms: cpu %.1lf%%, video skipped: %d",
+                  elapsed / kSbTimeMillisecond,
+                  elapsed > 0 ? 100. * (cpu_time - audio_only_start_cpu_time_) / elapsed : .0,
+                  audio_only_skipped_frames_);
+  // Video only players stopped reading instead of dropping.
+  resume_video_at_key_frame_ = audio_codec_ != kSbMediaAudioCodecNone;
+  if (video_request_parked_) {
+    video_request_parked_ = false;
+    DecoderNeedsData(lock, MediaType::kVideo);
+  }
+  if (parked_video_timestamp_ != kSbTimeMax) {
+    parked_video_timestamp_ = kSbTimeMax;
+    DecoderNeedsData(lock, MediaType::kVideo);
+  }
+}
+
+bool PlayerImpl::SkipForAudioOnly(const SbPlayerSampleInfo& sample_info) {
+  ::starboard::ScopedLock lock(mutex_);
+  bool is_key_frame = sample_info.video_sample_info.is_key_frame;
+  if (!audio_only_) {
+    if (!resume_video_at_key_frame_ || is_key_frame) {
+      resume_video_at_key_frame_ = false;
+      return false;
+    }
+  } else if (audio_codec_ == kSbMediaAudioCodecNone) {
+    // Parked rather than dropped, see IsVideoParked().
+    return false;
+  } else if (is_key_frame && state_ != State::kPresenting) {
+    // Prerolling after a seek still needs a video frame.
+    return false;
+  }
+
+  ++audio_only_skipped_frames_;
+  ++stats_.audio_only_skipped_frames;
+  ++total_video_frames_;
+  decoder_state_data_ &= ~static_cast<int>(MediaType::kVideo);
+  // Don't let video reading run ahead of audio, resuming would then wait
+  // for a key frame far past the playback position.
+  if (sample_info.timestamp > last_audio_timestamp_)
+    parked_video_timestamp_ = sample_info.timestamp;
+  else
+    DecoderNeedsData(lock, MediaType::kVideo);
+  return true;
+}
+
+void PlayerImpl::StartRateSegment(::starboard::ScopedLock&, double rate) {
+  SbTimeMonotonic now = SbTimeGetMonotonicNow();
+  SbTime cpu_time = GetProcessCpuTime();
+  const RateSegment& segment = rate_segment_;
+  SbTime elapsed = now - segment.start_time;
+  if (segment.rate != .0 && segment.start_time != 0 && elapsed > 0) {
+    uint64_t displayed = stats_.video_frames_processed >= segment.start_frames_processed
+      ? stats_.video_frames_processed - segment.start_frames_processed
+      : 0;
+    double seconds = static_cast<double>(elapsed) / kSbTimeSecond;
+    GST_INFO("Rate %.2lf for %" PRId64 "ms: cpu %.1lf%%"
+             ", displayed %.1lf fps (%.2lf frames per media second)"
+             ", video written/skipped: %d/%d",
+             segment.rate, elapsed / kSbTimeMillisecond,
+             100. * (cpu_time - segment.start_cpu_time) / elapsed,
+             displayed / seconds, displayed / (seconds * segment.rate),
+             segment.frames_written, segment.frames_skipped);
+  }
+  rate_segment_ = RateSegment();
+  rate_segment_.rate = rate;
+  rate_segment_.start_time = now;
+  rate_segment_.start_cpu_time = cpu_time;
+  rate_segment_.start_frames_processed = stats_.video_frames_processed;
+}
+
 bool PlayerImpl::ChangePipelineState(GstState state) const {
   if (force_stop_ && state > GST_STATE_READY) {
     GST_INFO_OBJECT(pipeline_, "Ignore state change due to forced stop");
@@ -2448,8 +3440,8 @@ void PlayerImpl::CheckBuffering(gint64 position) {
   if (!GST_CLOCK_TIME_IS_VALID(position))
     return;
 
-  constexpr SbTime kMarginNs =
-      350 * kSbTimeMillisecond * kSbTimeNanosecondsPerMicrosecond;
+  const SbTime kMarginNs =
+      (low_latency_ ? kLowLatencyBufferingMargin : kBufferingMargin) * kSbTimeNanosecondsPerMicrosecond;
 
   MediaType origin = MediaType::kNone;
   SbTime min_ts = MinTimestamp(&origin);
@@ -2464,6 +3456,11 @@ void PlayerImpl::CheckBuffering(gint64 position) {
       ::starboard::ScopedLock lock(mutex_);
       DecoderNeedsData(lock, origin);
       buf_target_min_ts_ = min_ts + kMarginNs;
+      // Ran out of parked video on purpose.
+      if (!IsVideoParked()) {
+        ++stats_.rebuffer_count;
+        rebuffer_start_time_ = SbTimeGetMonotonicNow();
+      }
     }
 
     PrintPositionPerSink(pipeline_);
@@ -2490,6 +3487,72 @@ void PlayerImpl::CheckBuffering(gint64 position) {
   }
 }
 
+void PlayerImpl::AdjustLiveRate(gint64 position) {
+  if (!GST_CLOCK_TIME_IS_VALID(position) || GST_STATE(pipeline_) != GST_STATE_PLAYING)
+    return;
+
+  double live_rate;
+  SbTime ahead;
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    // Only while the app plays at normal speed and nothing else is going on.
+    if (rate_ != 1. || trick_mode_ || is_seek_pending_ || pending_rate_ != .0 ||
+        need_first_segment_ack_ || buf_target_min_ts_ != kSbTimeMax ||
+        state_ != State::kPresenting)
+      return;
+    SbTime min_ts = MinTimestamp(nullptr);
+    if (min_ts == kSbTimeMax)
+      return;
+    ahead = (min_ts - position) / kSbTimeNanosecondsPerMicrosecond;
+    stats_.live_ahead = ahead;
+
+    live_rate = live_rate_;
+    if (ahead > kLiveMaxAhead)
+      live_rate = 1. + kLiveRateAdjustment;
+    else if (ahead < kLiveMinAhead)
+      live_rate = 1. - kLiveRateAdjustment;
+    else if ((live_rate_ > 1. && ahead <= kLiveTargetAhead) ||
+             (live_rate_ < 1. && ahead >= kLiveTargetAhead))
+      live_rate = 1.;
+    if (live_rate == live_rate_)
+      return;
+    live_rate_ = live_rate;
+    ++stats_.live_rate_changes;
+  }
+
+  GST_INFO_OBJECT(pipeline_, "Live edge %" PRId64 "ms ahead, playing at %.2lf",
+                  ahead / kSbTimeMillisecond, live_rate);
+  if (!SendRateChange(live_rate))
+    GST_WARNING_OBJECT(pipeline_, "Failed to adjust the live playback rate");
+}
+
+bool PlayerImpl::HoldLiveData(::starboard::ScopedLock&, MediaType media) {
+  if (!GST_CLOCK_TIME_IS_VALID(live_position_))
+    return false;
+  SbTime max_ts = max_sample_timestamps_[media == MediaType::kVideo ? kVideoIndex : kAudioIndex];
+  if (max_ts - live_position_ < kLiveMaxBuffered * kSbTimeNanosecondsPerMicrosecond)
+    return false;
+  GST_LOG_OBJECT(pipeline_, "Holding %d, %" GST_TIME_FORMAT " written",
+                 static_cast<int>(media), GST_TIME_ARGS(max_ts));
+  live_held_data_ |= static_cast<int>(media);
+  return true;
+}
+
+void PlayerImpl::ReleaseLiveData(gint64 position) {
+  ::starboard::ScopedLock lock(mutex_);
+  live_position_ = position;
+  if (live_held_data_ == static_cast<int>(MediaType::kNone))
+    return;
+  for (MediaType media : {MediaType::kVideo, MediaType::kAudio}) {
+    if ((live_held_data_ & static_cast<int>(media)) == 0 ||
+        HoldLiveData(lock, media))
+      continue;
+    live_held_data_ &= ~static_cast<int>(media);
+    if ((has_enough_data_ & static_cast<int>(media)) == 0)
+      DecoderNeedsData(lock, media);
+  }
+}
+
 gint64 PlayerImpl::GetPosition() const {
   gint64 position = GST_CLOCK_TIME_NONE;
 
@@ -2539,58 +3602,69 @@ gint64 PlayerImpl::GetPosition() const {
 }
 
 void PlayerImpl::WritePendingSamples() {
-  PendingSamples local_samples;
   bool keep_samples = false;
   int ticket = -1;
   {
     ::starboard::ScopedLock lock(mutex_);
     keep_samples = is_seek_pending_;
     ticket = ticket_;
-    local_samples.swap(pending_samples_);
-  }
-
-  if (!local_samples.empty()) {
-    std::sort(
-      local_samples.begin(), local_samples.end(),
-      [](const PendingSample& lhs, const PendingSample& rhs) -> bool {
-        return lhs.SerialID() < rhs.SerialID();
-      });
-    GstClockTime prev_timestamps[kMediaNumber] = {-1, -1};
-    for (auto& sample : local_samples) {
-      auto &prev_ts = prev_timestamps[sample.Type() == kSbMediaTypeVideo ? kVideoIndex : kAudioIndex];
-
-      if (prev_ts == sample.Timestamp()) {
-        GST_WARNING("Skipping %" GST_TIME_FORMAT ". Already written.",
-                    GST_TIME_ARGS(prev_ts));
-        continue;
-      }
-
-      GstBuffer* buffer = keep_samples ? sample.CopyBuffer() : sample.TakeBuffer();
-      GST_INFO("Writing pending: SampleType:%d id:%llu b:%" GST_PTR_FORMAT, sample.Type(), sample.SerialID(), buffer);
-      prev_ts = GST_BUFFER_TIMESTAMP(buffer);
-      if (WriteSample(sample.Type(), buffer, sample.SerialID())) {
-        GST_INFO("Pending sample was written.");
-      } else {
-        gst_buffer_unref(buffer);
-      }
-    }
+  }
 
-    if (keep_samples) {
-      {
-        ::starboard::ScopedLock lock(mutex_);
-        if (ticket_ == ticket) {
-          std::move(local_samples.begin(), local_samples.end(),
-                    std::back_inserter(pending_samples_));
-        } else {
-          keep_samples = false;
-        }
+  // Samples are replayed in the order they were written. When the seek is
+  // still pending they stay in the ring and only references are pushed,
+  // otherwise the ring is drained.
+  GstClockTime prev_timestamps[kMediaNumber] = {GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE};
+  for (size_t index = 0;; ++index) {
+    SbMediaType type;
+    uint64_t serial;
+    GstBuffer* buffer = nullptr;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      if (ticket_ != ticket) {
+        GST_INFO("Seek ticket changed (%d -> %d), stop writing pending samples.", ticket, ticket_);
+        break;
       }
       if (keep_samples) {
-        GST_INFO("Stored samples again.");
+        if (index >= pending_samples_.Size())
+          break;
+        const PendingSample& sample = pending_samples_.At(index);
+        type = sample.Type();
+        serial = sample.SerialID();
+        buffer = sample.RefBuffer();
       } else {
-        GST_INFO("Seek ticket changed (%d -> %d), dropped local samples.", ticket, ticket_);
+        if (pending_samples_.IsEmpty())
+          break;
+        PendingSample& sample = pending_samples_.At(0);
+        type = sample.Type();
+        serial = sample.SerialID();
+        buffer = sample.TakeBuffer();
+        pending_samples_.PopFront();
       }
     }
+
+    auto &prev_ts = prev_timestamps[type == kSbMediaTypeVideo ? kVideoIndex : kAudioIndex];
+    if (prev_ts == GST_BUFFER_TIMESTAMP(buffer)) {
+      GST_WARNING("Skipping %" GST_TIME_FORMAT ". Already written.",
+                  GST_TIME_ARGS(prev_ts));
+      gst_buffer_unref(buffer);
+      continue;
+    }
+
+    GST_INFO("Writing pending: SampleType:%d id:%llu b:%" GST_PTR_FORMAT, type, serial, buffer);
+    prev_ts = GST_BUFFER_TIMESTAMP(buffer);
+    if (WriteSample(type, buffer, serial)) {
+      GST_INFO("Pending sample was written.");
+    } else {
+      gst_buffer_unref(buffer);
+    }
+  }
+
+  ::starboard::ScopedLock lock(mutex_);
+  int held_data = pending_samples_held_data_;
+  pending_samples_held_data_ = static_cast<int>(MediaType::kNone);
+  for (MediaType media : {MediaType::kVideo, MediaType::kAudio}) {
+    if ((held_data & static_cast<int>(media)) != 0)
+      DecoderNeedsData(lock, media);
   }
 }
 
@@ -2644,7 +3718,16 @@ void PlayerImpl::HandleApplicationMessage(GstBus* bus, GstMessage* message) {
   if (gst_structure_has_name(structure, "force-stop") && !force_stop_) {
     GST_INFO("Received force STOP, pipeline = %p!!!", pipeline_);
     force_stop_ = true;
-    ChangePipelineState(GST_STATE_READY);
+    // Going to READY joins the streaming threads and can take a while with
+    // hardware decoders, keep it off the shared loop.
+    force_stop_thread_ = SbThreadCreate(
+        0, kSbThreadPriorityHigh, kSbThreadNoAffinity, true, "player_stop",
+        [](void* context) -> void* {
+          static_cast<PlayerImpl*>(context)->ChangePipelineState(GST_STATE_READY);
+          return nullptr;
+        }, this);
+    if (!SbThreadIsValid(force_stop_thread_))
+      ChangePipelineState(GST_STATE_READY);
     g_signal_handlers_disconnect_by_func(pipeline_, reinterpret_cast<gpointer>(&PlayerImpl::SetupSource), this);
     g_signal_handlers_disconnect_by_func(pipeline_, reinterpret_cast<gpointer>(&PlayerImpl::SetupElement), this);
     ::starboard::ScopedLock lock(source_setup_mutex_);
@@ -2674,7 +3757,30 @@ void PlayerImpl::HandleApplicationMessage(GstBus* bus, GstMessage* message) {
   }
 }
 
+// static
+void PlayerImpl::PreemptDecoder(void* owner) {
+  GetPlayerRegistry()->PreemptDecoder(static_cast<SbPlayer>(owner));
+}
+
+void PlayerImpl::OnDecoderPreempted() {
+  GST_WARNING_OBJECT(pipeline_, "Video decoder taken by another player");
+  // Same as SbPlayer force stop, the pipeline goes to READY and releases
+  // the decoder. Tasks queued after the player is destroyed are dropped.
+  GstStructure* structure = gst_structure_new_empty("force-stop");
+  gst_element_post_message(pipeline_, gst_message_new_application(GST_OBJECT(pipeline_), structure));
+  DispatchOnWorkerThread(new PlayerErrorTask(
+      player_error_func_, player_, context_,
+      kSbPlayerErrorDecode, "Video decoder taken by another player"));
+}
+
 void PlayerImpl::ConfigureLimitedVideo() {
+  ConfigureSecondaryVideoSink();
+
+  // enforce no audio
+  audio_codec_ = kSbMediaAudioCodecNone;
+}
+
+void PlayerImpl::ConfigureSecondaryVideoSink() {
   GstElementFactory* factory = gst_element_factory_find("westerossink");
   if (factory) {
     GstElement* video_sink = gst_element_factory_create(factory, nullptr);
@@ -2692,9 +3798,6 @@ void PlayerImpl::ConfigureLimitedVideo() {
     }
     gst_object_unref(GST_OBJECT(factory));
   }
-
-  // enforce no audio
-  audio_codec_ = kSbMediaAudioCodecNone;
 }
 
 }  // namespace
@@ -2704,12 +3807,85 @@ void ForceStop() {
   GetPlayerRegistry()->ForceStop();
 }
 
+bool GetPlayerStats(std::string& out_json) {
+  WPEFramework::Core::JSON::ArrayType<PlayerStatsData> players;
+  for (const PlayerStats& stats : GetPlayerRegistry()->GetStats())
+    players.Add().Set(stats);
+  return players.ToString(out_json);
+}
+
+void SetAudioOnly(bool audio_only) {
+  if (getenv("COBALT_DISABLE_BACKGROUND_AUDIO_ONLY"))
+    return;
+  using third_party::starboard::rdk::shared::player::GetPlayerRegistry;
+  GetPlayerRegistry()->SetAudioOnly(audio_only);
+}
+
+void Prewarm() {
+  if (getenv("COBALT_DISABLE_PLAYER_PREWARM"))
+    return;
+
+  GST_DEBUG_CATEGORY_INIT(cobalt_gst_player_debug, "gstplayer", 0,
+                          "Cobalt player");
+
+  using third_party::starboard::rdk::shared::drm::DrmSystemOcdm;
+  using third_party::starboard::rdk::shared::media::GstRegistryHasElementForMediaType;
+
+  SbTimeMonotonic start = SbTimeGetMonotonicNow();
+  SbTimeMonotonic phase_start = start;
+  auto phase_done = [&phase_start](const char* phase) {
+    SbTimeMonotonic now = SbTimeGetMonotonicNow();
+    SB_LOG(INFO) << "Player prewarm: " << phase << " took "
+                 << (now - phase_start) / kSbTimeMillisecond << "ms";
+    phase_start = now;
+  };
+
+  GstElement* playbin = gst_element_factory_make("playbin", nullptr);
+  if (playbin) {
+    gst_object_ref_sink(playbin);
+    gst_object_unref(playbin);
+  }
+  getGstPlayFlag("audio");
+  RegisterCobaltSrc();
+  GetPayloaderFactory();
+  phase_done("playbin");
+
+  const SbMediaVideoCodec video_codecs[] = { kSbMediaVideoCodecH264, kSbMediaVideoCodecVp9 };
+  for (SbMediaVideoCodec codec : video_codecs) {
+    if (GstRegistryHasElementForMediaType(codec))
+      PrewarmElement(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+                     CodecToGstCaps(codec), true);
+  }
+  const SbMediaAudioCodec audio_codecs[] = { kSbMediaAudioCodecAac, kSbMediaAudioCodecOpus };
+  for (SbMediaAudioCodec codec : audio_codecs) {
+    if (GstRegistryHasElementForMediaType(codec))
+      PrewarmElement(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO,
+                     CodecToGstCaps(codec), true);
+  }
+  phase_done("decoders");
+
+  // Sinks often grab display or audio resources when created, so only their
+  // plugins are loaded.
+  PrewarmElement(GST_ELEMENT_FACTORY_TYPE_SINK | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+                 { "video/x-raw" }, false);
+  PrewarmElement(GST_ELEMENT_FACTORY_TYPE_SINK | GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO,
+                 { "audio/x-raw" }, false);
+  phase_done("sinks");
+
+  DrmSystemOcdm::IsKeySystemSupported("com.widevine.alpha", "");
+  phase_done("ocdm");
+
+  SB_LOG(INFO) << "Player prewarm done in "
+               << (SbTimeGetMonotonicNow() - start) / kSbTimeMillisecond << "ms";
+}
+
 }  // namespace player
 }  // namespace shared
 }  // namespace rdk
 }  // namespace starboard
 }  // namespace third_party
 
+using third_party::starboard::rdk::shared::media::DecoderArbiter;
 using third_party::starboard::rdk::shared::player::PlayerImpl;
 
 SbPlayerPrivate::SbPlayerPrivate(
@@ -2725,21 +3901,41 @@ SbPlayerPrivate::SbPlayerPrivate(
     SbPlayerErrorFunc player_error_func,
     void* context,
     SbPlayerOutputMode output_mode,
-    SbDecodeTargetGraphicsContextProvider* provider)
-    : player_(new PlayerImpl(this,
-                             window,
-                             video_codec,
-                             audio_codec,
-                             drm_system,
-                             audio_sample_info,
-                             max_video_capabilities,
-                             sample_deallocate_func,
-                             decoder_status_func,
-                             player_status_func,
-                             player_error_func,
-                             context,
-                             output_mode,
-                             provider)) {
-  if (  !static_cast<PlayerImpl&>(*player_).IsValid() )
-    player_.reset(nullptr);
+    SbDecodeTargetGraphicsContextProvider* provider) {
+  // Before the pipeline exists, a refused player reports nothing.
+  DecoderArbiter::Decoder decoder = DecoderArbiter::kNone;
+  if (video_codec != kSbMediaVideoCodecNone) {
+    decoder = DecoderArbiter::Acquire(this, video_codec, max_video_capabilities,
+                                      &PlayerImpl::PreemptDecoder);
+    if (decoder == DecoderArbiter::kNone) {
+      SB_LOG(ERROR) << "No video decoder available";
+      return;
+    }
+  }
+
+  std::unique_ptr<PlayerImpl> impl(new PlayerImpl(this,
+                                                  window,
+                                                  video_codec,
+                                                  audio_codec,
+                                                  drm_system,
+                                                  audio_sample_info,
+                                                  max_video_capabilities,
+                                                  decoder,
+                                                  sample_deallocate_func,
+                                                  decoder_status_func,
+                                                  player_status_func,
+                                                  player_error_func,
+                                                  context,
+                                                  output_mode,
+                                                  provider));
+  if (impl->IsValid())
+    player_ = std::move(impl);
+  else
+    DecoderArbiter::Release(this);
+}
+
+SbPlayerPrivate::~SbPlayerPrivate() {
+  // The pipeline lets go of the decoder first.
+  player_.reset();
+  DecoderArbiter::Release(this);
 }
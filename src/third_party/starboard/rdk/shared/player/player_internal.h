@@ -18,6 +18,7 @@
 #define THIRD_PARTY_STARBOARD_RDK_SHARED_PLAYER_PLAYER_INTERNAL_H_
 
 #include <memory>
+#include <string>
 
 #include "starboard/player.h"
 
@@ -27,6 +28,48 @@ namespace rdk {
 namespace shared {
 namespace player {
 
+// Playback statistics gathered over the lifetime of a player from the
+// GStreamer QoS and buffering messages and the appsrc fill levels.
+struct PlayerStats {
+  uint64_t video_frames_processed { 0 };
+  uint64_t video_frames_dropped { 0 };
+  // Sinks reporting in samples or time post a QoS message per dropped
+  // buffer, those are counted per message.
+  uint64_t audio_buffers_dropped { 0 };
+  // Buffers reported late by the sinks and by how much, per stream.
+  struct Late {
+    int count { 0 };
+    SbTime total_jitter { 0 };
+    SbTime max_jitter { 0 };
+  };
+  Late late_video;
+  Late late_audio;
+  // Playback paused for lack of data.
+  int rebuffer_count { 0 };
+  SbTime rebuffer_time { 0 };
+  int buffering_messages { 0 };
+  int min_buffering_percent { 100 };
+  uint64_t video_appsrc_level_bytes { 0 };
+  uint64_t audio_appsrc_level_bytes { 0 };
+  uint64_t max_video_appsrc_level_bytes { 0 };
+  uint64_t max_audio_appsrc_level_bytes { 0 };
+  SbTime initial_preroll_time { 0 };
+  int seek_count { 0 };
+  SbTime total_seek_time { 0 };
+  SbTime max_seek_time { 0 };
+  // Delta frames not decoded while playing from key frames only.
+  uint64_t trick_mode_skipped_frames { 0 };
+  // Video frames not decoded because the sink was running late, not part
+  // of video_frames_dropped nor of the dropped frames in SbPlayerInfo2.
+  uint64_t qos_skipped_frames { 0 };
+  // Low latency profile: written samples ahead of the position at the
+  // last check and how often the rate was adjusted to keep that in bounds.
+  SbTime live_ahead { 0 };
+  int live_rate_changes { 0 };
+  // Video frames not decoded while the app was concealed.
+  uint64_t audio_only_skipped_frames { 0 };
+};
+
 struct SB_EXPORT Player {
   virtual ~Player() {}
   static int MaxNumberOfSamplesPerWrite();
@@ -39,8 +82,12 @@ struct SB_EXPORT Player {
   virtual bool SetRate(double rate) = 0;
   virtual void GetInfo(SbPlayerInfo2* info) = 0;
   virtual void SetBounds(int zindex, int x, int y, int w, int h) = 0;
+  virtual void GetStats(PlayerStats* stats) = 0;
 };
 
+// Stats of the live players as JSON, for SbRdkGetSetting("players").
+bool GetPlayerStats(std::string& out_json);
+
 }  // namespace player
 }  // namespace shared
 }  // namespace rdk
@@ -61,7 +108,7 @@ struct SbPlayerPrivate {
                   void* context,
                   SbPlayerOutputMode output_mode,
                   SbDecodeTargetGraphicsContextProvider* provider);
-  ~SbPlayerPrivate() {}
+  ~SbPlayerPrivate();
 
   int MaxNumberOfSamplesPerWrite() const {
     using third_party::starboard::rdk::shared::player::Player;
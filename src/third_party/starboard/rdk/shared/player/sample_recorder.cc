@@ -0,0 +1,235 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#include "third_party/starboard/rdk/shared/player/sample_recorder.h"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#include "starboard/atomic.h"
+#include "starboard/common/log.h"
+#include "starboard/file.h"
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace player {
+namespace {
+
+const char kMagic[] = { 'C', 'B', 'E', 'S' };
+
+template <typename T>
+void Append(std::vector<uint8_t>& out, T value) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void AppendBytes(std::vector<uint8_t>& out, const void* data, uint32_t size) {
+  Append<uint32_t>(out, size);
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  if (size)
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+std::vector<uint8_t> NewRecord(SampleRecorder::RecordType type) {
+  std::vector<uint8_t> record;
+  Append<uint8_t>(record, type);
+  Append<uint32_t>(record, 0);
+  return record;
+}
+
+void FinishRecord(std::vector<uint8_t>& record) {
+  uint32_t size = record.size() - sizeof(uint8_t) - sizeof(uint32_t);
+  memcpy(record.data() + sizeof(uint8_t), &size, sizeof(size));
+}
+
+::starboard::atomic_int32_t g_recorder_count;
+
+}  // namespace
+
+// static
+std::unique_ptr<SampleRecorder> SampleRecorder::Create(
+    SbMediaVideoCodec video_codec,
+    SbMediaAudioCodec audio_codec,
+    const SbMediaAudioSampleInfo& audio_sample_info) {
+  const char* dir = getenv("COBALT_PLAYER_CAPTURE_DIR");
+  if (!dir || !*dir)
+    return nullptr;
+
+  std::string path = std::string(dir) + "/player_" + std::to_string(getpid()) + "_" +
+    std::to_string(g_recorder_count.increment()) + ".es";
+
+  std::unique_ptr<SampleRecorder> recorder(new SampleRecorder(path));
+  if (!SbThreadIsValid(recorder->thread_))
+    return nullptr;
+
+  Record record = NewRecord(kRecordHeader);
+  Append<uint32_t>(record, video_codec);
+  Append<uint32_t>(record, audio_codec);
+  Append<uint16_t>(record, audio_sample_info.number_of_channels);
+  Append<uint32_t>(record, audio_sample_info.samples_per_second);
+  Append<uint16_t>(record, audio_sample_info.bits_per_sample);
+  AppendBytes(record, audio_sample_info.audio_specific_config,
+              audio_sample_info.audio_specific_config_size);
+  FinishRecord(record);
+  recorder->Enqueue(std::move(record));
+
+  SB_LOG(INFO) << "Capturing player input to '" << path << "'";
+  return recorder;
+}
+
+SampleRecorder::SampleRecorder(const std::string& path)
+  : path_(path) {
+  thread_ =
+    SbThreadCreate(0, kSbThreadPriorityLow, kSbThreadNoAffinity, true,
+                   "sample_recorder", &SampleRecorder::ThreadEntryPoint, this);
+}
+
+SampleRecorder::~SampleRecorder() {
+  if (SbThreadIsValid(thread_)) {
+    mutex_.Acquire();
+    running_ = false;
+    condition_.Broadcast();
+    mutex_.Release();
+    SbThreadJoin(thread_, nullptr);
+  }
+}
+
+void SampleRecorder::RecordSample(SbMediaType type, const SbPlayerSampleInfo& sample_info) {
+  Record record = NewRecord(kRecordSample);
+  record.reserve(record.size() + sample_info.buffer_size + 128);
+  Append<uint8_t>(record, type);
+  Append<int64_t>(record, sample_info.timestamp);
+  AppendBytes(record, sample_info.buffer, sample_info.buffer_size);
+
+  if (type == kSbMediaTypeVideo) {
+    const SbMediaVideoSampleInfo& info = sample_info.video_sample_info;
+    Append<uint8_t>(record, info.is_key_frame);
+    Append<int32_t>(record, info.frame_width);
+    Append<int32_t>(record, info.frame_height);
+    AppendBytes(record, &info.color_metadata, sizeof(info.color_metadata));
+  }
+
+  const SbDrmSampleInfo* drm_info = sample_info.drm_info;
+  Append<uint8_t>(record, drm_info != nullptr);
+  if (drm_info) {
+    Append<uint8_t>(record, drm_info->encryption_scheme);
+    AppendBytes(record, drm_info->initialization_vector, drm_info->initialization_vector_size);
+    AppendBytes(record, drm_info->identifier, drm_info->identifier_size);
+    Append<uint32_t>(record, drm_info->subsample_count);
+    for (int32_t i = 0; i < drm_info->subsample_count; ++i) {
+      Append<uint32_t>(record, drm_info->subsample_mapping[i].clear_byte_count);
+      Append<uint32_t>(record, drm_info->subsample_mapping[i].encrypted_byte_count);
+    }
+  }
+
+  FinishRecord(record);
+  Enqueue(std::move(record));
+}
+
+void SampleRecorder::RecordSeek(SbTime timestamp, int ticket) {
+  Record record = NewRecord(kRecordSeek);
+  Append<int64_t>(record, timestamp);
+  Append<int32_t>(record, ticket);
+  FinishRecord(record);
+  Enqueue(std::move(record));
+}
+
+void SampleRecorder::RecordRate(double rate) {
+  Record record = NewRecord(kRecordRate);
+  Append<double>(record, rate);
+  FinishRecord(record);
+  Enqueue(std::move(record));
+}
+
+void SampleRecorder::RecordEndOfStream(SbMediaType type) {
+  Record record = NewRecord(kRecordEndOfStream);
+  Append<uint8_t>(record, type);
+  FinishRecord(record);
+  Enqueue(std::move(record));
+}
+
+void SampleRecorder::Enqueue(Record&& record) {
+  ::starboard::ScopedLock lock(mutex_);
+  if (stopped_)
+    return;
+  if (queued_bytes_ + record.size() > kMaxQueuedBytes) {
+    // Going on with records missing would replay as a valid capture.
+    SB_LOG(ERROR) << "Capture '" << path_ << "' can't keep up, stopping capture";
+    stopped_ = true;
+    return;
+  }
+  queued_bytes_ += record.size();
+  queue_.emplace_back(std::move(record));
+  condition_.Signal();
+}
+
+// static
+void* SampleRecorder::ThreadEntryPoint(void* context) {
+  static_cast<SampleRecorder*>(context)->DoWork();
+  return nullptr;
+}
+
+void SampleRecorder::DoWork() {
+  SbFile file = SbFileOpen(path_.c_str(), kSbFileCreateAlways | kSbFileWrite, nullptr, nullptr);
+  if (!SbFileIsValid(file)) {
+    SB_LOG(ERROR) << "Failed to open capture file '" << path_ << "'";
+  } else {
+    uint32_t version = kVersion;
+    SbFileWriteAll(file, kMagic, sizeof(kMagic));
+    SbFileWriteAll(file, reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+
+  for (;;) {
+    std::deque<Record> records;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      while (running_ && queue_.empty())
+        condition_.Wait();
+      if (queue_.empty())
+        break;
+      records.swap(queue_);
+    }
+    size_t written_bytes = 0;
+    for (const Record& record : records) {
+      written_bytes += record.size();
+      if (!SbFileIsValid(file))
+        continue;
+      int size = static_cast<int>(record.size());
+      if (SbFileWriteAll(file, reinterpret_cast<const char*>(record.data()), size) != size) {
+        SB_LOG(ERROR) << "Failed to write capture file '" << path_ << "', stopping capture";
+        SbFileClose(file);
+        file = kSbFileInvalid;
+      }
+    }
+    records.clear();
+    ::starboard::ScopedLock lock(mutex_);
+    queued_bytes_ -= written_bytes;
+  }
+
+  if (SbFileIsValid(file))
+    SbFileClose(file);
+}
+
+}  // namespace player
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
@@ -0,0 +1,100 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_PLAYER_SAMPLE_RECORDER_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_PLAYER_SAMPLE_RECORDER_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "starboard/common/condition_variable.h"
+#include "starboard/common/mutex.h"
+#include "starboard/player.h"
+#include "starboard/thread.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+namespace player {
+
+// Records everything written to a player (samples with their video and DRM
+// info, seeks, rate changes and EOS) so a playback session can be replayed
+// outside of the app with tools/player_replay. Enabled by pointing
+// COBALT_PLAYER_CAPTURE_DIR to a writable directory; each player then
+// writes 'player_<pid>_<n>.es' there.
+//
+// The file starts with the 'CBES' magic and a version, followed by records
+// of [type: u8][size: u32][payload], all in host byte order. Records are
+// serialized on the calling thread and written out by a background thread.
+// When the records not yet written exceed kMaxQueuedBytes the capture
+// stops rather than blocking the caller, the file then ends at the last
+// record queued before.
+class SampleRecorder {
+ public:
+  enum RecordType : uint8_t {
+    kRecordHeader = 1,
+    kRecordSample = 2,
+    kRecordSeek = 3,
+    kRecordRate = 4,
+    kRecordEndOfStream = 5,
+  };
+
+  static const uint32_t kVersion = 1;
+  static const size_t kMaxQueuedBytes = 32 * 1024 * 1024;
+
+  // Returns null when capture is not enabled.
+  static std::unique_ptr<SampleRecorder> Create(
+      SbMediaVideoCodec video_codec,
+      SbMediaAudioCodec audio_codec,
+      const SbMediaAudioSampleInfo& audio_sample_info);
+
+  ~SampleRecorder();
+
+  void RecordSample(SbMediaType type, const SbPlayerSampleInfo& sample_info);
+  void RecordSeek(SbTime timestamp, int ticket);
+  void RecordRate(double rate);
+  void RecordEndOfStream(SbMediaType type);
+
+ private:
+  using Record = std::vector<uint8_t>;
+
+  explicit SampleRecorder(const std::string& path);
+
+  static void* ThreadEntryPoint(void* context);
+  void DoWork();
+  void Enqueue(Record&& record);
+
+  const std::string path_;
+  SbThread thread_ { kSbThreadInvalid };
+  ::starboard::Mutex mutex_;
+  ::starboard::ConditionVariable condition_ { mutex_ };
+  std::deque<Record> queue_;
+  // Queued and being written.
+  size_t queued_bytes_ { 0 };
+  bool stopped_ { false };
+  bool running_ { true };
+};
+
+}  // namespace player
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_PLAYER_SAMPLE_RECORDER_H_
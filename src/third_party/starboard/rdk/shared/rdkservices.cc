@@ -18,8 +18,13 @@
 #include "third_party/starboard/rdk/shared/rdkservices.h"
 
 #include <string>
+#include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
 
 #include <websocket/JSONRPCLink.h>
 
@@ -38,6 +43,8 @@
 #include "starboard/common/mutex.h"
 #include "starboard/accessibility.h"
 #include "starboard/common/file.h"
+#include "starboard/thread.h"
+#include "starboard/time.h"
 
 #include "third_party/starboard/rdk/shared/accessibility_data.h"
 #include "third_party/starboard/rdk/shared/log_override.h"
@@ -64,6 +71,11 @@ const char kAuthServiceExperienceFile[] = "/opt/www/authService/experience.dat";
 
 const uint32_t kPriviligedRequestErrorCode = -32604U;
 
+const SbTime kSlowCallThreshold = 50 * kSbTimeMillisecond;
+
+const int kPrefetchThreadCount = 3;
+const SbTime kPrefetchTimeBudget = 2 * kSbTimeSecond;
+
 class ServiceLink {
   ::starboard::scoped_ptr<JSONRPC::LinkType<Core::JSON::IElement>> link_;
   std::string callsign_;
@@ -132,19 +144,35 @@ public:
       link_.reset(new JSONRPC::LinkType<Core::JSON::IElement>(callsign, nullptr, false, buildQuery()));
   }
 
+  // With overrides enabled, '<Callsign>_<method>' provides the response and
+  // '<Callsign>_<method>_latency_ms' / '<Callsign>_<method>_rc' add a delay or
+  // force an error code, so the retry paths can be exercised without Thunder.
   template <typename PARAMETERS>
   uint32_t Get(const uint32_t waitTime, const string& method, PARAMETERS& sendObject) {
+    SbTimeMonotonic start = SbTimeGetMonotonicNow();
     if (enableEnvOverrides()) {
       std::string envValue;
       std::string envName = Core::JSONRPC::Message::Callsign(callsign_) + "_" + method;
       envName.erase(std::remove(envName.begin(), envName.end(), '.'), envName.end());
+      if (Core::SystemInfo::GetEnvironment(envName + "_latency_ms", envValue) == true) {
+        SbThreadSleep(atoi(envValue.c_str()) * kSbTimeMillisecond);
+      }
+      if (Core::SystemInfo::GetEnvironment(envName + "_rc", envValue) == true) {
+        uint32_t rc = static_cast<uint32_t>(atoi(envValue.c_str()));
+        RecordCall(method, rc, start);
+        return rc;
+      }
       if (Core::SystemInfo::GetEnvironment(envName, envValue) == true) {
-        return sendObject.FromString(envValue) ? Core::ERROR_NONE : Core::ERROR_GENERAL;
+        uint32_t rc = sendObject.FromString(envValue) ? Core::ERROR_NONE : Core::ERROR_GENERAL;
+        RecordCall(method, rc, start);
+        return rc;
       }
     }
     if (!link_)
       return Core::ERROR_UNAVAILABLE;
-    return link_->template Get<PARAMETERS>(waitTime, method, sendObject);
+    uint32_t rc = link_->template Get<PARAMETERS>(waitTime, method, sendObject);
+    RecordCall(method, rc, start);
+    return rc;
   }
 
   template <typename PARAMETERS, typename HANDLER, typename REALOBJECT>
@@ -165,7 +193,10 @@ public:
   uint32_t Subscribe(const uint32_t waitTime, const string& eventName, const METHOD& method, REALOBJECT* objectPtr) {
     if (!link_)
       return enableEnvOverrides() ? Core::ERROR_NONE : Core::ERROR_UNAVAILABLE;
-    return link_->template Subscribe<INBOUND, METHOD, REALOBJECT>(waitTime, eventName, method, objectPtr);
+    SbTimeMonotonic start = SbTimeGetMonotonicNow();
+    uint32_t rc = link_->template Subscribe<INBOUND, METHOD, REALOBJECT>(waitTime, eventName, method, objectPtr);
+    RecordCall(eventName, rc, start);
+    return rc;
   }
 
   void Unsubscribe(const uint32_t waitTime, const string& eventName) {
@@ -177,8 +208,226 @@ public:
   void Teardown() {
     link_.reset();
   }
+
+  static void LogCallStats();
+
+private:
+  void RecordCall(const string& method, uint32_t rc, SbTimeMonotonic start) const;
+};
+
+// Latency of the synchronous calls made through ServiceLink, per method.
+// Dumped on teardown to see what startup and playback spend waiting on IPC.
+struct CallStats {
+  struct Entry {
+    int count { 0 };
+    int failures { 0 };
+    SbTime total { 0 };
+    SbTime max { 0 };
+  };
+
+  void Record(const std::string& name, bool failed, SbTime duration) {
+    ::starboard::ScopedLock lock(mutex_);
+    Entry& entry = entries_[name];
+    ++entry.count;
+    if (failed)
+      ++entry.failures;
+    entry.total += duration;
+    entry.max = std::max(entry.max, duration);
+  }
+
+  void Log() {
+    ::starboard::ScopedLock lock(mutex_);
+    for (const auto& it : entries_) {
+      const Entry& entry = it.second;
+      SB_LOG(INFO) << "Call stats for '" << it.first << "':"
+                   << " count: " << entry.count
+                   << ", failures: " << entry.failures
+                   << ", avg: " << (entry.total / entry.count) / kSbTimeMillisecond << "ms"
+                   << ", max: " << entry.max / kSbTimeMillisecond << "ms";
+    }
+  }
+
+private:
+  ::starboard::Mutex mutex_;
+  std::map<std::string, Entry> entries_;
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(CallStats, GetCallStats);
+
+void ServiceLink::RecordCall(const string& method, uint32_t rc, SbTimeMonotonic start) const {
+  SbTime duration = SbTimeGetMonotonicNow() - start;
+  std::string name = callsign_.empty() ? method : callsign_ + "." + method;
+  if (duration > kSlowCallThreshold) {
+    SB_LOG(WARNING) << "Slow call to '" << name << "' took "
+                    << duration / kSbTimeMillisecond << "ms, rc=" << rc
+                    << " ( " << Core::ErrorToString(rc) << " )";
+  }
+  GetCallStats()->Record(name, Core::ERROR_NONE != rc, duration);
+}
+
+// static
+void ServiceLink::LogCallStats() {
+  GetCallStats()->Log();
+}
+
+// Last known value of a property that is expensive to query. A new value
+// is published as a whole so readers never see a partial update. Readers
+// share ownership of the snapshot they loaded, a replaced one is freed once
+// the last of them lets go.
+template <typename T>
+class CachedValue {
+public:
+  CachedValue() { }
+  CachedValue(const CachedValue&) = delete;
+  CachedValue& operator=(const CachedValue&) = delete;
+
+  std::shared_ptr<const T> Get() const {
+    return std::atomic_load(&value_);
+  }
+
+  void Publish(const T& value) {
+    std::atomic_store(&value_, std::shared_ptr<const T>(std::make_shared<T>(value)));
+  }
+
+private:
+  std::shared_ptr<const T> value_;
+};
+
+// Runs the deferred refreshes of the cached service values. Thunder calls
+// block for up to their timeout, so they are kept off the application event
+// thread. Stop() waits for a refresh in progress.
+class RefreshThread {
+public:
+  typedef void (*Callback)(void* data);
+  typedef int TaskId;
+  static const TaskId kInvalidTask = 0;
+
+  RefreshThread()
+    : condition_(mutex_) { }
+
+  TaskId Schedule(Callback callback, void* data, SbTime delay) {
+    ::starboard::ScopedLock lock(mutex_);
+    if (stopped_)
+      return kInvalidTask;
+    if (!SbThreadIsValid(thread_)) {
+      thread_ = SbThreadCreate(0, kSbThreadPriorityLow, kSbThreadNoAffinity, true,
+                               "rdkservices_refresh", &RefreshThread::ThreadEntryPoint, this);
+      if (!SbThreadIsValid(thread_))
+        return kInvalidTask;
+    }
+    Task task { ++last_id_, SbTimeGetMonotonicNow() + delay, callback, data };
+    tasks_.insert(std::make_pair(task.due, task));
+    condition_.Signal();
+    return task.id;
+  }
+
+  void Cancel(TaskId id) {
+    ::starboard::ScopedLock lock(mutex_);
+    for (auto it = tasks_.begin(); it != tasks_.end(); ++it) {
+      if (it->second.id == id) {
+        tasks_.erase(it);
+        return;
+      }
+    }
+  }
+
+  void Stop() {
+    SbThread thread;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      stopped_ = true;
+      tasks_.clear();
+      condition_.Signal();
+      thread = thread_;
+      thread_ = kSbThreadInvalid;
+    }
+    if (SbThreadIsValid(thread))
+      SbThreadJoin(thread, nullptr);
+  }
+
+private:
+  struct Task {
+    TaskId id;
+    SbTimeMonotonic due;
+    Callback callback;
+    void* data;
+  };
+
+  static void* ThreadEntryPoint(void* context) {
+    static_cast<RefreshThread*>(context)->DoWork();
+    return nullptr;
+  }
+
+  void DoWork() {
+    ::starboard::ScopedLock lock(mutex_);
+    while (!stopped_) {
+      if (tasks_.empty()) {
+        condition_.Wait();
+        continue;
+      }
+      SbTime wait = tasks_.begin()->first - SbTimeGetMonotonicNow();
+      if (wait > 0) {
+        condition_.WaitTimed(wait);
+        continue;
+      }
+      Task task = tasks_.begin()->second;
+      tasks_.erase(tasks_.begin());
+      mutex_.Release();
+      task.callback(task.data);
+      mutex_.Acquire();
+    }
+  }
+
+  ::starboard::Mutex mutex_;
+  ::starboard::ConditionVariable condition_;
+  std::multimap<SbTimeMonotonic, Task> tasks_;
+  SbThread thread_ { kSbThreadInvalid };
+  TaskId last_id_ { kInvalidTask };
+  bool stopped_ { false };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(RefreshThread, GetRefreshThread);
+
+// Notifications for the application. A warm-up prefetch runs before the
+// application exists, and service events keep arriving in warm-start
+// standby, so they are held back until Start() and then posted to the
+// application thread. Only the latest of repeated notifications is kept.
+class ApplicationNotifier {
+public:
+  typedef void (*Callback)(void* data);
+
+  void Post(Callback callback) {
+    ::starboard::ScopedLock lock(mutex_);
+    if (started_) {
+      SbEventSchedule(callback, nullptr, 0);
+      return;
+    }
+    pending_.erase(std::remove(pending_.begin(), pending_.end(), callback), pending_.end());
+    pending_.push_back(callback);
+  }
+
+  void Start() {
+    ::starboard::ScopedLock lock(mutex_);
+    started_ = true;
+    for (Callback callback : pending_)
+      SbEventSchedule(callback, nullptr, 0);
+    pending_.clear();
+  }
+
+  void Stop() {
+    ::starboard::ScopedLock lock(mutex_);
+    started_ = false;
+    pending_.clear();
+  }
+
+private:
+  ::starboard::Mutex mutex_;
+  std::vector<Callback> pending_;
+  bool started_ { false };
 };
 
+SB_ONCE_INITIALIZE_FUNCTION(ApplicationNotifier, GetApplicationNotifier);
+
 struct DeviceIdImpl {
   DeviceIdImpl() {
     JsonData::DeviceIdentification::DeviceidentificationData data;
@@ -646,9 +895,16 @@ struct AuthServiceImpl {
     if (!IsAvailable())
       return false;
 
+    std::shared_ptr<const std::string> experience = experience_.Get();
+    if (experience) {
+      out = *experience;
+      return true;
+    }
+
     ::starboard::ScopedLock lock(mutex_);
-    if (!experience_.empty()) {
-      out = experience_;
+    experience = experience_.Get();
+    if (experience) {
+      out = *experience;
       return true;
     }
 
@@ -656,8 +912,8 @@ struct AuthServiceImpl {
     uint32_t rc = ServiceLink(kAuthServiceCallsign)
       .Get(kDefaultTimeoutMs, "getExperience", data);
     if (Core::ERROR_NONE == rc && data.Get("success").Boolean()) {
-      experience_ = data.Get("experience").Value();
-      out = experience_;
+      out = data.Get("experience").Value();
+      experience_.Publish(out);
       return true;
     }
 
@@ -669,8 +925,8 @@ struct AuthServiceImpl {
       int bytes_read = file.ReadAll(buffer, kBufferSize);
       bytes_read = std::min(bytes_read, kBufferSize - 1);
       buffer[bytes_read] = '\0';
-      experience_.assign(buffer);
-      out = experience_;
+      out.assign(buffer);
+      experience_.Publish(out);
       return true;
     }
 
@@ -680,81 +936,135 @@ struct AuthServiceImpl {
 private:
   ::starboard::Mutex mutex_;
   bool is_available_ { false };
-  std::string experience_;
+  CachedValue<std::string> experience_;
 };
 
 SB_ONCE_INITIALIZE_FUNCTION(AuthServiceImpl, GetAuthService);
 
+struct DisplayInfoData {
+  ResolutionInfo resolution { 1920, 1080 };
+  uint32_t hdr_caps { DisplayInfo::kHdrNone };
+  float diagonal_size_in_inches { 0.f };
+};
+
+// Display properties are queried once and then served from the cache. The
+// 'updated' event and failed queries schedule a refresh on the refresh
+// thread, so callers on the playback path never wait for IPC after the
+// first query.
 struct DisplayInfoImpl {
   ResolutionInfo GetResolution() {
-    Refresh();
-    return resolution_info_;
+    return Get().resolution;
   }
   uint32_t GetHDRCaps() {
-    Refresh();
-    return hdr_caps_;
+    return Get().hdr_caps;
   }
   float GetDiagonalSizeInInches() {
-    Refresh();
-    return diagonal_size_in_inches_;
+    return Get().diagonal_size_in_inches;
   }
   void Teardown() {
+    {
+      ::starboard::ScopedLock lock(event_mutex_);
+      if (refresh_task_ != RefreshThread::kInvalidTask) {
+        GetRefreshThread()->Cancel(refresh_task_);
+        refresh_task_ = RefreshThread::kInvalidTask;
+      }
+    }
     display_info_.Teardown();
   }
 
 private:
-  void Refresh();
+  DisplayInfoData Get();
+  bool Refresh();
+  void ScheduleRefresh(SbTime delay);
   void OnUpdated(const Core::JSON::String&);
 
   ServiceLink display_info_ { kDisplayInfoCallsign };
-  ResolutionInfo resolution_info_ { };
-  uint32_t hdr_caps_ { DisplayInfo::kHdrNone };
-  float diagonal_size_in_inches_ { 0.f };
-  ::starboard::atomic_bool needs_refresh_ { true };
-  ::starboard::atomic_bool did_subscribe_ { false };
+  CachedValue<DisplayInfoData> data_;
+  ::starboard::Mutex refresh_mutex_;
+  ::starboard::Mutex event_mutex_;
+  RefreshThread::TaskId refresh_task_ { RefreshThread::kInvalidTask };
+  ::starboard::atomic_bool notify_pending_ { false };
+  bool did_subscribe_ { false };
 };
 
-void DisplayInfoImpl::Refresh() {
-  if (!needs_refresh_.load())
+DisplayInfoData DisplayInfoImpl::Get() {
+  std::shared_ptr<const DisplayInfoData> data = data_.Get();
+  if (!data) {
+    ::starboard::ScopedLock lock(refresh_mutex_);
+    data = data_.Get();
+    if (!data) {
+      if (Refresh())
+        ScheduleRefresh(kSbTimeSecond);
+      data = data_.Get();
+    }
+  }
+  return *data;
+}
+
+void DisplayInfoImpl::ScheduleRefresh(SbTime delay) {
+  ::starboard::ScopedLock lock(event_mutex_);
+  if (refresh_task_ != RefreshThread::kInvalidTask)
     return;
+  refresh_task_ = GetRefreshThread()->Schedule([](void* data) {
+    auto& self = *static_cast<DisplayInfoImpl*>(data);
+    self.event_mutex_.Acquire();
+    self.refresh_task_ = RefreshThread::kInvalidTask;
+    self.event_mutex_.Release();
 
+    bool needs_retry;
+    {
+      ::starboard::ScopedLock lock(self.refresh_mutex_);
+      needs_retry = self.Refresh();
+    }
+    if (needs_retry)
+      self.ScheduleRefresh(kSbTimeSecond);
+    else if (self.notify_pending_.exchange(false))
+      GetApplicationNotifier()->Post([](void*) { Application::Get()->DisplayInfoChanged(); });
+  }, this, delay);
+}
+
+// Queries all display properties and publishes them. Must be called with
+// |refresh_mutex_| held. Returns true if the query should be repeated.
+bool DisplayInfoImpl::Refresh() {
   uint32_t rc;
 
-  if (!did_subscribe_.load()) {
-    bool old_val = did_subscribe_.exchange(true);
-    if (old_val == false) {
-      rc = display_info_.Subscribe<Core::JSON::String>(kDefaultTimeoutMs, "updated", &DisplayInfoImpl::OnUpdated, this);
-      if (Core::ERROR_UNAVAILABLE == rc || kPriviligedRequestErrorCode == rc) {
-        needs_refresh_.store(false);
-        SB_LOG(ERROR) << "Failed to subscribe to '" << kDisplayInfoCallsign
-                      << ".updated' event, rc=" << rc
-                      << " ( " << Core::ErrorToString(rc) << " )";
-        return;
-      }
-      if (Core::ERROR_NONE != rc && Core::ERROR_DUPLICATE_KEY != rc) {
-        did_subscribe_.store(false);
-        SB_LOG(ERROR) << "Failed to subscribe to '" << kDisplayInfoCallsign
-                      << ".updated' event, rc=" << rc
-                      << " ( " << Core::ErrorToString(rc) << " )."
-                      << " Going to try again next time.";
-        return;
-      }
+  if (!did_subscribe_) {
+    did_subscribe_ = true;
+    rc = display_info_.Subscribe<Core::JSON::String>(kDefaultTimeoutMs, "updated", &DisplayInfoImpl::OnUpdated, this);
+    if (Core::ERROR_UNAVAILABLE == rc || kPriviligedRequestErrorCode == rc) {
+      SB_LOG(ERROR) << "Failed to subscribe to '" << kDisplayInfoCallsign
+                    << ".updated' event, rc=" << rc
+                    << " ( " << Core::ErrorToString(rc) << " )";
+      if (!data_.Get())
+        data_.Publish(DisplayInfoData());
+      return false;
+    }
+    if (Core::ERROR_NONE != rc && Core::ERROR_DUPLICATE_KEY != rc) {
+      did_subscribe_ = false;
+      SB_LOG(ERROR) << "Failed to subscribe to '" << kDisplayInfoCallsign
+                    << ".updated' event, rc=" << rc
+                    << " ( " << Core::ErrorToString(rc) << " )."
+                    << " Going to try again later.";
+      if (!data_.Get())
+        data_.Publish(DisplayInfoData());
+      return true;
     }
   }
 
+  DisplayInfoData info;
   bool needs_refresh = false;
 
   Core::JSON::String resolution;
   rc = ServiceLink(kPlayerInfoCallsign).Get(kDefaultTimeoutMs, "resolution", resolution);
   if (Core::ERROR_NONE == rc && resolution.IsSet()) {
     if (resolution.Value().find("Resolution2160") != std::string::npos) {
-      resolution_info_ = ResolutionInfo { 3840 , 2160 };
+      info.resolution = ResolutionInfo { 3840 , 2160 };
     } else {
-      resolution_info_ = ResolutionInfo { 1920 , 1080 };
+      info.resolution = ResolutionInfo { 1920 , 1080 };
     }
   } else {
     needs_refresh |= (Core::ERROR_ASYNC_FAILED == rc);
-    resolution_info_ = ResolutionInfo { 1920 , 1080 };
+    info.resolution = ResolutionInfo { 1920 , 1080 };
     SB_LOG(ERROR) << "Failed to get 'resolution', rc=" << rc << " ( " << Core::ErrorToString(rc) << " )";
   }
 
@@ -774,9 +1084,9 @@ void DisplayInfoImpl::Refresh() {
   }
 
   if (widthincentimeters && heightincentimeters) {
-    diagonal_size_in_inches_ = sqrtf(powf(widthincentimeters, 2) + powf(heightincentimeters, 2)) / 2.54f;
+    info.diagonal_size_in_inches = sqrtf(powf(widthincentimeters, 2) + powf(heightincentimeters, 2)) / 2.54f;
   } else {
-    diagonal_size_in_inches_ = 0.f;
+    info.diagonal_size_in_inches = 0.f;
   }
 
   auto detectHdrCaps = [&](const char* method)
@@ -821,25 +1131,23 @@ void DisplayInfoImpl::Refresh() {
   uint32_t tv_caps = detectHdrCaps("tvcapabilities");
   uint32_t stb_caps = detectHdrCaps("stbcapabilities");
 
-  hdr_caps_ = tv_caps & stb_caps;
+  info.hdr_caps = tv_caps & stb_caps;
 
-  needs_refresh_.store(needs_refresh);
+  data_.Publish(info);
 
   SB_LOG(INFO) << "Display info updated, resolution: "
-               << resolution_info_.Width << 'x' << resolution_info_.Height
-               << ", hdr caps: 0x" << std::hex << hdr_caps_
+               << info.resolution.Width << 'x' << info.resolution.Height
+               << ", hdr caps: 0x" << std::hex << info.hdr_caps
                << " (tvcaps: 0x"<< std::hex << tv_caps
                << ", stbcaps: 0x" << std::hex << stb_caps << ")"
-               << ", diagonal size in inches: " << std::dec << diagonal_size_in_inches_;
+               << ", diagonal size in inches: " << std::dec << info.diagonal_size_in_inches;
+
+  return needs_refresh;
 }
 
 void DisplayInfoImpl::OnUpdated(const Core::JSON::String&) {
-  if (needs_refresh_.load() == false) {
-    needs_refresh_.store(true);
-    SbEventSchedule([](void* data) {
-      Application::Get()->DisplayInfoChanged();
-    }, nullptr, 0);
-  }
+  notify_pending_.store(true);
+  ScheduleRefresh(0);
 }
 
 SB_ONCE_INITIALIZE_FUNCTION(DisplayInfoImpl, GetDisplayInfo);
@@ -852,7 +1160,7 @@ private:
   ::starboard::atomic_bool is_connected_  { false };
   ::starboard::atomic_bool is_connection_type_wireless_ { false };
   ::starboard::Mutex mutex_;
-  SbEventId event_id_ { kSbEventIdInvalid };
+  RefreshThread::TaskId refresh_task_ { RefreshThread::kInvalidTask };
 
   struct InterfaceInfo : public Core::JSON::Container {
     InterfaceInfo()
@@ -891,12 +1199,12 @@ private:
 
   void ScheduleRefresh(SbTime timeout) {
     ::starboard::ScopedLock lock(mutex_);
-    if (event_id_ == kSbEventIdInvalid) {
+    if (refresh_task_ == RefreshThread::kInvalidTask) {
       needs_refresh_.store(true);
-      event_id_ = SbEventSchedule([](void* data) {
+      refresh_task_ = GetRefreshThread()->Schedule([](void* data) {
         auto& self = *static_cast<NetworkInfoImpl*>(data);
         self.mutex_.Acquire();
-        self.event_id_ = kSbEventIdInvalid;
+        self.refresh_task_ = RefreshThread::kInvalidTask;
         self.mutex_.Release();
         self.Refresh();
       }, this, timeout);
@@ -957,9 +1265,9 @@ private:
         is_connected_.store(has_connected_interface);
 #if SB_API_VERSION >= 13
         if (has_connected_interface)
-          Application::Get()->InjectOsNetworkConnectedEvent();
+          GetApplicationNotifier()->Post([](void*) { Application::Get()->InjectOsNetworkConnectedEvent(); });
         else
-          Application::Get()->InjectOsNetworkDisconnectedEvent();
+          GetApplicationNotifier()->Post([](void*) { Application::Get()->InjectOsNetworkDisconnectedEvent(); });
 #endif
       }
     }
@@ -1001,6 +1309,92 @@ public:
 
 SB_ONCE_INITIALIZE_FUNCTION(NetworkInfoImpl, GetNetworkInfo);
 
+// Startup queries are issued from a few background threads so they overlap
+// each other and the rest of the startup instead of running one after
+// another on whichever thread asks first. A caller that needs a value
+// before it is ready only waits for that one query, as each service
+// serializes its own first query. Queries not started within the time
+// budget are left to be done on demand.
+struct ServicePrefetcher {
+  void Start() {
+    if (!threads_.empty())
+      return;
+
+    ::starboard::ScopedLock lock(mutex_);
+    start_time_ = SbTimeGetMonotonicNow();
+    tasks_ = {
+      { "DisplayInfo", []() { GetDisplayInfo()->GetResolution(); } },
+      { "DeviceIdentification", []() { GetDeviceIdImpl(); } },
+      { "Network", []() { GetNetworkInfo(); } },
+      { "AuthService", []() { std::string tmp; GetAuthService()->GetExperience(tmp); } },
+      { "TextToSpeech", []() { GetTextToSpeech(); } },
+    };
+
+    int thread_count = std::min(kPrefetchThreadCount, static_cast<int>(tasks_.size()));
+    for (int i = 0; i < thread_count; ++i) {
+      SbThread thread =
+        SbThreadCreate(0, kSbThreadNoPriority, kSbThreadNoAffinity, true,
+                       "rdkservices_prefetch", &ServicePrefetcher::ThreadEntryPoint, this);
+      if (SbThreadIsValid(thread))
+        threads_.push_back(thread);
+    }
+  }
+
+  // Drops the queries that have not started yet and waits for the rest.
+  void Stop() {
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      tasks_.clear();
+    }
+    for (SbThread thread : threads_)
+      SbThreadJoin(thread, nullptr);
+    threads_.clear();
+  }
+
+private:
+  struct Task {
+    const char* name;
+    void (*run)();
+  };
+
+  static void* ThreadEntryPoint(void* context) {
+    static_cast<ServicePrefetcher*>(context)->DoWork();
+    return nullptr;
+  }
+
+  void DoWork() {
+    for (;;) {
+      Task task;
+      {
+        ::starboard::ScopedLock lock(mutex_);
+        if (tasks_.empty())
+          return;
+        if (SbTimeGetMonotonicNow() - start_time_ > kPrefetchTimeBudget) {
+          SB_LOG(INFO) << "Prefetch time budget exceeded, leaving "
+                       << tasks_.size() << " queries for later";
+          tasks_.clear();
+          return;
+        }
+        task = tasks_.front();
+        tasks_.pop_front();
+      }
+      SbTimeMonotonic begin = SbTimeGetMonotonicNow();
+      task.run();
+      SbTimeMonotonic end = SbTimeGetMonotonicNow();
+      SB_LOG(INFO) << "Prefetched " << task.name << " in "
+                   << (end - begin) / kSbTimeMillisecond << "ms"
+                   << " (" << (end - start_time_) / kSbTimeMillisecond << "ms since start)";
+    }
+  }
+
+  ::starboard::Mutex mutex_;
+  std::deque<Task> tasks_;
+  std::vector<SbThread> threads_;
+  SbTimeMonotonic start_time_ { 0 };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(ServicePrefetcher, GetServicePrefetcher);
+
 }  // namespace
 
 ResolutionInfo DisplayInfo::GetResolution() {
@@ -1107,7 +1501,19 @@ bool AuthService::GetExperience(std::string &out) {
   return GetAuthService()->GetExperience(out);
 }
 
+void PrefetchRDKServices() {
+  GetServicePrefetcher()->Start();
+}
+
+void StartRDKServicesNotifications() {
+  GetApplicationNotifier()->Start();
+}
+
 void TeardownJSONRPCLink() {
+  GetApplicationNotifier()->Stop();
+  GetServicePrefetcher()->Stop();
+  GetRefreshThread()->Stop();
+  ServiceLink::LogCallStats();
   GetDisplayInfo()->Teardown();
   GetTextToSpeech()->Teardown();
   GetNetworkInfo()->Teardown();
@@ -102,7 +102,12 @@ public:
   static bool GetExperience(std::string &out);
 };
 
-
+// Starts querying the services above in the background, so their values
+// are likely cached by the time startup needs them.
+void PrefetchRDKServices();
+// Lets service events reach Application. Until then they are held back, so
+// the prefetch may run before Application exists.
+void StartRDKServicesNotifications();
 void TeardownJSONRPCLink();
 
 }  // namespace shared
@@ -29,12 +29,16 @@
 // limitations under the License.
 
 #include <memory>
+#include <string>
 #include <vector>
 #include <cstring>
 
 #include "starboard/system.h"
 #include "starboard/string.h"
 #include "starboard/memory.h"
+#include "starboard/once.h"
+#include "starboard/time.h"
+#include "starboard/common/mutex.h"
 
 #include "third_party/starboard/rdk/shared/hang_detector.h"
 #include "third_party/starboard/rdk/shared/log_override.h"
@@ -46,6 +50,9 @@
 
 namespace {
 
+#if defined(HAS_CRYPTOGRAPHY)
+using namespace WPEFramework::Cryptography;
+
 template<typename T>
 struct RefDeleter {
   void operator()(T* ref) { if ( ref ) ref->Release(); }
@@ -54,22 +61,12 @@ struct RefDeleter {
 template<typename T>
 using ScopedRef = std::unique_ptr<T, RefDeleter<T>>;
 
-}
-
-bool SbSystemSignWithCertificationSecretKey(const uint8_t* message,
-                                            size_t message_size_in_bytes,
-                                            uint8_t* digest,
-                                            size_t digest_size_in_bytes) {
-  bool result = false;
-
-#if defined(HAS_CRYPTOGRAPHY)
-  using namespace WPEFramework::Cryptography;
-
-  const char kDefaultKeyName[] = "0381000003810001.key";
-  const char kRFCParamName[] = "Device.DeviceInfo.X_RDKCENTRAL-COM_RFC.Feature.Cobalt.AuthCertKeyName";
-
-  third_party::starboard::rdk::shared::HangMonitor hang_monitor(__func__);
+const char kDefaultKeyName[] = "0381000003810001.key";
+const char kRFCParamName[] = "Device.DeviceInfo.X_RDKCENTRAL-COM_RFC.Feature.Cobalt.AuthCertKeyName";
 
+// |out_resolved| is false when falling back to the default, RFC may not be
+// up yet early in boot.
+std::string ResolveKeyName(bool& out_resolved) {
   std::string key_name;
   const char *env = std::getenv("COBALT_CERT_KEY_NAME");
   if ( env != nullptr ) {
@@ -87,62 +84,149 @@ bool SbSystemSignWithCertificationSecretKey(const uint8_t* message,
     SbMemoryDeallocate(callerId);
   }
 
-  if ( key_name.empty() ) {
+  out_resolved = !key_name.empty();
+  if ( !out_resolved ) {
     key_name = kDefaultKeyName;
     SB_LOG(INFO) << "Using default key name: '" << key_name << "'";
   }
+  return key_name;
+}
 
-  ScopedRef<ICryptography> icrypto;
-  ScopedRef<IVault> vault;
-  ScopedRef<IPersistent> persistent;
-  ScopedRef<IHash> hash;
-
-  icrypto.reset( ICryptography::Instance(EMPTY_STRING) );
-  if ( !icrypto ) {
-    SB_LOG(ERROR) << "Failed to create ICryptography instance";
-    return false;
+// Keeps the cryptography instance, the vault and the loaded key around
+// between calls, the setup is what makes signing slow. Any failure drops
+// the handles (e.g. the cryptography service was restarted) and the call
+// is retried once with a fresh setup. The key name is resolved until the
+// environment or RFC provides one.
+class CertificationSigner {
+public:
+  ~CertificationSigner() {
+    ::starboard::ScopedLock lock(mutex_);
+    Invalidate();
   }
 
-  vault.reset( icrypto->Vault(cryptographyvault::CRYPTOGRAPHY_VAULT_DEFAULT) );
-  if ( !vault ) {
-    SB_LOG(ERROR) << "Failed to get default vault";
+  bool Sign(const uint8_t* message,
+            size_t message_size_in_bytes,
+            uint8_t* digest,
+            size_t digest_size_in_bytes) {
+    ::starboard::ScopedLock lock(mutex_);
+    if ( !key_name_resolved_ ) {
+      std::string key_name = ResolveKeyName(key_name_resolved_);
+      if ( key_name != key_name_ ) {
+        Invalidate();
+        key_name_ = key_name;
+      }
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      bool reused = (persistent_ != nullptr);
+      if ( !reused && !Open() ) {
+        Invalidate();
+        return false;
+      }
+      if ( Calculate(message, message_size_in_bytes, digest, digest_size_in_bytes) )
+        return true;
+      Invalidate();
+      if ( !reused )
+        break;
+      SB_LOG(WARNING) << "Signing with cached key failed, reopening the vault";
+    }
     return false;
   }
 
-  persistent.reset( vault->QueryInterface<WPEFramework::Cryptography::IPersistent>() );
-  if ( !persistent ) {
-    SB_LOG(ERROR) << "IPersistent is not implemented";
-    return false;
+private:
+  bool Open() {
+    icrypto_.reset( ICryptography::Instance(EMPTY_STRING) );
+    if ( !icrypto_ ) {
+      SB_LOG(ERROR) << "Failed to create ICryptography instance";
+      return false;
+    }
+
+    vault_.reset( icrypto_->Vault(cryptographyvault::CRYPTOGRAPHY_VAULT_DEFAULT) );
+    if ( !vault_ ) {
+      SB_LOG(ERROR) << "Failed to get default vault";
+      return false;
+    }
+
+    persistent_.reset( vault_->QueryInterface<WPEFramework::Cryptography::IPersistent>() );
+    if ( !persistent_ ) {
+      SB_LOG(ERROR) << "IPersistent is not implemented";
+      return false;
+    }
+
+    uint32_t rc;
+    if ( (rc = persistent_->Load(key_name_, key_id_)) != WPEFramework::Core::ERROR_NONE ) {
+      SB_LOG(ERROR) << "Failed to load key: '" << key_name_ << "' rc: " << rc;
+      return false;
+    }
+    SB_LOG(INFO) << "Loaded key id: 0x" << std::hex << key_id_;
+    return true;
   }
 
-  uint32_t rc, key_id = 0;
-  if ( (rc = persistent->Load(key_name, key_id)) != WPEFramework::Core::ERROR_NONE ) {
-    SB_LOG(ERROR) << "Failed to load key: '" << key_name << "' rc: " << rc;
-    persistent->Flush();
+  bool Calculate(const uint8_t* message,
+                 size_t message_size_in_bytes,
+                 uint8_t* digest,
+                 size_t digest_size_in_bytes) {
+    // The key never leaves the vault, so a new HMAC context per message is
+    // as much as can be kept warm on this side.
+    ScopedRef<IHash> hash( vault_->HMAC(hashtype::SHA256, key_id_) );
+    uint32_t rc;
+    if ( !hash ) {
+      SB_LOG(ERROR) << "Vault returned null HMAC for key id: 0x" << std::hex << key_id_;
+    }
+    else if ( (rc = hash->Ingest( message_size_in_bytes, message )) != message_size_in_bytes ) {
+      SB_LOG(ERROR) << "HMAC 'Ingest' failed, rc: " << rc << " message size: " << message_size_in_bytes;
+    }
+    else if ( (rc = hash->Calculate( digest_size_in_bytes, digest )) != digest_size_in_bytes ) {
+      SB_LOG(ERROR) << "HMAC 'Calculate' failed, rc: " << rc << " digest size: " << digest_size_in_bytes;
+    }
+    else {
+      return true;
+    }
     return false;
-  } else {
-    SB_LOG(INFO) << "Loaded key id: 0x" << std::hex << key_id;
-    hash.reset( vault->HMAC(hashtype::SHA256, key_id) );
   }
 
-  if ( !hash ) {
-    SB_LOG(ERROR) << "Vault returned null HMAC for key id: 0x" << std::hex << key_id;
-  }
-  else if ( (rc = hash->Ingest( message_size_in_bytes, message )) != message_size_in_bytes ) {
-    SB_LOG(ERROR) << "HMAC 'Ingest' failed, rc: " << rc << " message size: " << message_size_in_bytes;
-  }
-  else if ( (rc = hash->Calculate( digest_size_in_bytes, digest )) != digest_size_in_bytes ) {
-    SB_LOG(ERROR) << "HMAC 'Calculate' failed, rc: " << rc << " digest size: " << digest_size_in_bytes;
-  }
-  else {
-    SB_LOG(INFO) << "Successfully signed cert scope message";
-    result = true;
+  void Invalidate() {
+    if ( persistent_ ) {
+      uint32_t rc;
+      if ( (rc = persistent_->Flush()) != WPEFramework::Core::ERROR_NONE ) {
+        SB_LOG(ERROR) << "Failed to flush persistent vault, rc: " << rc;
+      }
+    }
+    key_id_ = 0;
+    persistent_.reset();
+    vault_.reset();
+    icrypto_.reset();
   }
 
-  hash.reset();
+  ::starboard::Mutex mutex_;
+  std::string key_name_;
+  bool key_name_resolved_ { false };
+  ScopedRef<ICryptography> icrypto_;
+  ScopedRef<IVault> vault_;
+  ScopedRef<IPersistent> persistent_;
+  uint32_t key_id_ { 0 };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(CertificationSigner, GetCertificationSigner);
+#endif
+
+}  // namespace
+
+bool SbSystemSignWithCertificationSecretKey(const uint8_t* message,
+                                            size_t message_size_in_bytes,
+                                            uint8_t* digest,
+                                            size_t digest_size_in_bytes) {
+  bool result = false;
+
+#if defined(HAS_CRYPTOGRAPHY)
+  third_party::starboard::rdk::shared::HangMonitor hang_monitor(__func__);
 
-  if ( (rc = persistent->Flush()) != WPEFramework::Core::ERROR_NONE ) {
-    SB_LOG(ERROR) << "Failed to flush persistent vault, rc: " << rc;
+  SbTimeMonotonic start = SbTimeGetMonotonicNow();
+  result = GetCertificationSigner()->Sign(message, message_size_in_bytes,
+                                          digest, digest_size_in_bytes);
+  if ( result ) {
+    SB_LOG(INFO) << "Successfully signed cert scope message in "
+                 << (SbTimeGetMonotonicNow() - start) / kSbTimeMillisecond << "ms";
   }
 #endif
 
@@ -0,0 +1,319 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "third_party/starboard/rdk/shared/thread_priority.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+#include <core/JSON.h>
+
+#include "starboard/configuration.h"
+#include "starboard/once.h"
+#include "starboard/common/mutex.h"
+
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+using namespace WPEFramework;
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+namespace {
+
+#ifndef SB_RDK_THREAD_CONFIG
+#define SB_RDK_THREAD_CONFIG ""
+#endif
+
+// Above the default of kernel threads that are usually left at 1, below
+// audio servers and drivers.
+const int kDefaultRealTimePriority = 5;
+
+enum ThreadClass {
+  kClassLow,
+  kClassNormal,
+  kClassHigh,
+  kClassRealTime,
+};
+
+ThreadClass GetThreadClass(SbThreadPriority priority) {
+  switch (priority) {
+    case kSbThreadPriorityLowest:
+    case kSbThreadPriorityLow:
+      return kClassLow;
+    case kSbThreadPriorityHigh:
+    case kSbThreadPriorityHighest:
+      return kClassHigh;
+    case kSbThreadPriorityRealTime:
+      return kClassRealTime;
+    default:
+      break;
+  }
+  return kClassNormal;
+}
+
+// Also what real time threads fall back to.
+int GetNiceValue(SbThreadPriority priority) {
+  switch (priority) {
+    case kSbThreadPriorityLowest:
+      return 10;
+    case kSbThreadPriorityLow:
+      return 5;
+    case kSbThreadPriorityHigh:
+      return -5;
+    case kSbThreadPriorityHighest:
+      return -10;
+    case kSbThreadPriorityRealTime:
+      return -15;
+    default:
+      break;
+  }
+  return 0;
+}
+
+// Parses a CPU list such as "0-1,3". Returns false when empty or invalid.
+bool ParseCpuList(const std::string& list, cpu_set_t& out_set) {
+  CPU_ZERO(&out_set);
+  std::stringstream stream(list);
+  std::string range;
+  bool any = false;
+  while (std::getline(stream, range, ',')) {
+    char* end = nullptr;
+    long first = strtol(range.c_str(), &end, 10);
+    long last = first;
+    if (end == range.c_str() || first < 0)
+      return false;
+    if (*end == '-') {
+      const char* second = end + 1;
+      last = strtol(second, &end, 10);
+      if (end == second || last < first)
+        return false;
+    }
+    if (*end != '\0')
+      return false;
+    for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, &out_set);
+      any = true;
+    }
+  }
+  return any;
+}
+
+class ThreadPriorityImpl {
+public:
+  struct ThreadConfigData : public Core::JSON::Container {
+    ThreadConfigData()
+      : Core::JSON::Container() {
+      Add(_T("policy"), &Policy);
+      Add(_T("rtpriority"), &RtPriority);
+      Add(_T("lowcpus"), &LowCpus);
+      Add(_T("normalcpus"), &NormalCpus);
+      Add(_T("highcpus"), &HighCpus);
+      Add(_T("realtimecpus"), &RealTimeCpus);
+    }
+    ThreadConfigData(const ThreadConfigData&) = delete;
+    ThreadConfigData& operator=(const ThreadConfigData&) = delete;
+
+    const Core::JSON::String& Cpus(ThreadClass thread_class) const {
+      switch (thread_class) {
+        case kClassLow:      return LowCpus;
+        case kClassNormal:   return NormalCpus;
+        case kClassHigh:     return HighCpus;
+        case kClassRealTime: return RealTimeCpus;
+      }
+      return NormalCpus;
+    }
+
+    Core::JSON::String Policy;          // real time threads: "rr", "fifo" or "nice"
+    Core::JSON::DecUInt8 RtPriority;    // 1 to 99
+    Core::JSON::String LowCpus;         // CPU lists such as "0-1,3"
+    Core::JSON::String NormalCpus;
+    Core::JSON::String HighCpus;
+    Core::JSON::String RealTimeCpus;
+  };
+
+  ThreadPriorityImpl()
+    : disabled_(!!getenv("COBALT_DISABLE_THREAD_PRIORITY")) {
+    if (disabled_) {
+      SB_LOG(INFO) << "Thread priorities are disabled";
+      return;
+    }
+    const std::string defaults(SB_RDK_THREAD_CONFIG);
+    Core::OptionalType<Core::JSON::Error> error;
+    if (!defaults.empty() && !defaults_.FromString(defaults, error)) {
+      defaults_.Clear();
+      SB_LOG(ERROR) << "Failed to parse SB_RDK_THREAD_CONFIG, error: "
+                    << (error.IsSet() ? Core::JSON::ErrorDisplayMessage(error.Value()): "Unknown");
+    }
+  }
+
+  void SetSettings(const std::string& json) {
+    ::starboard::ScopedLock lock(mutex_);
+    Core::OptionalType<Core::JSON::Error> error;
+    if ( !overrides_.FromString(json, error) ) {
+      overrides_.Clear();
+      SB_LOG(ERROR) << "Failed to parse threadconfig settings, error: "
+                    << (error.IsSet() ? Core::JSON::ErrorDisplayMessage(error.Value()): "Unknown");
+      return;
+    }
+    SB_LOG(INFO) << "Thread config override: " << json;
+  }
+
+  bool GetSettings(std::string& out_json) const {
+    ::starboard::ScopedLock lock(mutex_);
+    ThreadConfigData effective;
+    effective.Policy = GetPolicyLocked();
+    effective.RtPriority = static_cast<uint8_t>(GetRtPriorityLocked());
+    SetIfNotEmpty(effective.LowCpus, GetCpusLocked(kClassLow));
+    SetIfNotEmpty(effective.NormalCpus, GetCpusLocked(kClassNormal));
+    SetIfNotEmpty(effective.HighCpus, GetCpusLocked(kClassHigh));
+    SetIfNotEmpty(effective.RealTimeCpus, GetCpusLocked(kClassRealTime));
+    return effective.ToString(out_json);
+  }
+
+  // kSbThreadNoPriority is applied as normal, otherwise those threads would
+  // keep the real time policy and nice value of their creator.
+  void Apply(SbThreadPriority priority) {
+    if (disabled_)
+      return;
+
+    ThreadClass thread_class = GetThreadClass(priority);
+    std::string policy, cpus;
+    int rt_priority;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      policy = GetPolicyLocked();
+      rt_priority = GetRtPriorityLocked();
+      cpus = GetCpusLocked(thread_class);
+    }
+
+    bool real_time = false;
+    if (thread_class == kClassRealTime && policy != "nice") {
+      struct sched_param param = {};
+      param.sched_priority = rt_priority;
+      int result = pthread_setschedparam(pthread_self(), policy == "fifo" ? SCHED_FIFO : SCHED_RR, &param);
+      real_time = (result == 0);
+      if (!real_time)
+        WarnOnce(warned_real_time_, "real time scheduling", result);
+    } else {
+      // Threads inherit the policy of their creator, a normal thread started
+      // from a real time one must not stay real time.
+      struct sched_param param = {};
+      pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    }
+
+    if (!real_time) {
+      pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+      if (setpriority(PRIO_PROCESS, tid, GetNiceValue(priority)) != 0 && GetNiceValue(priority) < 0)
+        WarnOnce(warned_nice_, "negative nice values", errno);
+    }
+
+    cpu_set_t set;
+    if (!cpus.empty()) {
+      if (!ParseCpuList(cpus, set)) {
+        WarnOnce(warned_affinity_, ("CPU list '" + cpus + "'").c_str(), EINVAL);
+      } else {
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (result != 0)
+          WarnOnce(warned_affinity_, "CPU affinity", result);
+      }
+    }
+  }
+
+private:
+  static void SetIfNotEmpty(Core::JSON::String& field, const std::string& value) {
+    if (!value.empty())
+      field = value;
+  }
+
+  void WarnOnce(bool& warned, const char* what, int error) {
+    ::starboard::ScopedLock lock(mutex_);
+    if (warned)
+      return;
+    warned = true;
+    SB_LOG(WARNING) << "Can't use " << what << " for threads (" << strerror(error)
+                    << "), falling back to the default";
+  }
+
+  std::string GetPolicyLocked() const {
+    if (overrides_.Policy.IsSet())
+      return overrides_.Policy.Value();
+    if (defaults_.Policy.IsSet())
+      return defaults_.Policy.Value();
+    return "rr";
+  }
+
+  int GetRtPriorityLocked() const {
+    int value = kDefaultRealTimePriority;
+    if (overrides_.RtPriority.IsSet())
+      value = overrides_.RtPriority.Value();
+    else if (defaults_.RtPriority.IsSet())
+      value = defaults_.RtPriority.Value();
+    return std::max(1, std::min(99, value));
+  }
+
+  std::string GetCpusLocked(ThreadClass thread_class) const {
+    if (overrides_.Cpus(thread_class).IsSet())
+      return overrides_.Cpus(thread_class).Value();
+    if (defaults_.Cpus(thread_class).IsSet())
+      return defaults_.Cpus(thread_class).Value();
+    return std::string();
+  }
+
+  const bool disabled_;
+  mutable ::starboard::Mutex mutex_;
+  ThreadConfigData defaults_;
+  ThreadConfigData overrides_;
+  bool warned_real_time_ { false };
+  bool warned_nice_ { false };
+  bool warned_affinity_ { false };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(ThreadPriorityImpl, GetThreadPriority);
+
+}  // namespace
+
+// static
+void ThreadPriority::Apply(SbThreadPriority priority) {
+  GetThreadPriority()->Apply(priority);
+}
+
+// static
+void ThreadPriority::SetSettings(const std::string& json) {
+  GetThreadPriority()->SetSettings(json);
+}
+
+// static
+bool ThreadPriority::GetSettings(std::string& out_json) {
+  return GetThreadPriority()->GetSettings(out_json);
+}
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
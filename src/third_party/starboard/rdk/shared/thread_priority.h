@@ -0,0 +1,52 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_THREAD_PRIORITY_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_THREAD_PRIORITY_H_
+
+#include <string>
+
+#include "starboard/thread.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+// Maps Starboard thread priorities onto Linux scheduling. Real time threads
+// get SCHED_RR (or SCHED_FIFO), the others, threads without a priority
+// included, SCHED_OTHER and a nice value; when the process may not raise
+// its priority the closest nice value is used instead. Each class ("low",
+// "normal", "high", "realtime") can be pinned to a set of CPUs. The
+// defaults come from SB_RDK_THREAD_CONFIG and can be overridden with
+// SbRdkSetSetting("threadconfig", json) before the threads start.
+// COBALT_DISABLE_THREAD_PRIORITY leaves all threads at the default.
+class ThreadPriority {
+public:
+  // Applies |priority| to the calling thread.
+  static void Apply(SbThreadPriority priority);
+
+  static void SetSettings(const std::string& json);
+  static bool GetSettings(std::string& out_json);
+};
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_THREAD_PRIORITY_H_
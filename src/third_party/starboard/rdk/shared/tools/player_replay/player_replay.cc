@@ -0,0 +1,605 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Replays a capture made with COBALT_PLAYER_CAPTURE_DIR (see
+// player/sample_recorder.h) through SbPlayer, without Cobalt, and reports
+// write throughput, preroll and seek latency and dropped frames.
+//
+//   player_replay --capture=<file.es> [--fake_sinks] [--honor_pauses]
+//
+// Samples are written as the player asks for them, per stream, and seeks,
+// rate changes and EOS are applied at the point they were recorded.
+// Pauses are skipped unless --honor_pauses is given, the capture has no
+// wall clock so a paused player would never ask for more data.
+// --fake_sinks renders into fakesinks (COBALT_PLAYER_FAKE_SINKS) to time
+// the pipeline without a display. Encrypted captures are not supported,
+// there is no license to decrypt them with.
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "starboard/common/condition_variable.h"
+#include "starboard/common/file.h"
+#include "starboard/common/log.h"
+#include "starboard/common/mutex.h"
+#include "starboard/event.h"
+#include "starboard/player.h"
+#include "starboard/system.h"
+#include "starboard/thread.h"
+#include "starboard/time.h"
+#include "starboard/window.h"
+
+namespace {
+
+const char kMagic[] = { 'C', 'B', 'E', 'S' };
+const uint32_t kVersion = 1;
+
+// Matches SampleRecorder::RecordType.
+enum RecordType : uint8_t {
+  kRecordHeader = 1,
+  kRecordSample = 2,
+  kRecordSeek = 3,
+  kRecordRate = 4,
+  kRecordEndOfStream = 5,
+};
+
+const SbTime kStallTimeout = 10 * kSbTimeSecond;
+const SbTime kEndOfStreamGrace = 30 * kSbTimeSecond;
+
+// Bounds checked reads out of a record.
+class Reader {
+ public:
+  Reader(const uint8_t* data, size_t size) : data_(data), size_(size) { }
+
+  template <typename T>
+  bool Read(T& value) {
+    if (size_ - pos_ < sizeof(T))
+      return false;
+    memcpy(&value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadBytes(const uint8_t*& bytes, uint32_t& size) {
+    if (!Read(size) || size_ - pos_ < size)
+      return false;
+    bytes = data_ + pos_;
+    pos_ += size;
+    return true;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ { 0 };
+};
+
+struct Sample {
+  SbTime timestamp { 0 };
+  const uint8_t* data { nullptr };
+  uint32_t size { 0 };
+  bool is_key_frame { false };
+  int frame_width { 0 };
+  int frame_height { 0 };
+  SbMediaColorMetadata color_metadata;
+};
+
+struct Control {
+  enum Kind { kNone, kSeek, kRate };
+  Kind kind { kNone };
+  SbTime timestamp { 0 };
+  double rate { 0 };
+};
+
+// What was written between two seeks or rate changes. Index 0 is audio,
+// 1 video.
+struct Segment {
+  std::vector<Sample> samples[2];
+  bool end_of_stream[2] { false, false };
+  Control control;
+};
+
+int StreamIndex(SbMediaType type) {
+  return type == kSbMediaTypeVideo ? 1 : 0;
+}
+
+class Replay {
+ public:
+  bool Load(const std::string& path);
+  int Run(bool honor_pauses);
+
+ private:
+  static void DeallocateSample(SbPlayer, void*, const void*) { }
+  static void OnDecoderStatus(SbPlayer player, void* context, SbMediaType type,
+                              SbPlayerDecoderState state, int ticket);
+  static void OnPlayerStatus(SbPlayer player, void* context, SbPlayerState state, int ticket);
+  static void OnPlayerError(SbPlayer player, void* context, SbPlayerError error, const char* message);
+
+  bool WriteSegment(const Segment& segment);
+  bool WaitForState(SbPlayerState state, SbTime timeout);
+  void Seek(SbTime timestamp);
+  void Report(SbTime elapsed);
+
+  std::vector<uint8_t> file_;
+  std::vector<Segment> segments_;
+  SbMediaVideoCodec video_codec_ { kSbMediaVideoCodecNone };
+  SbMediaAudioSampleInfo audio_sample_info_;
+
+  SbPlayer player_ { kSbPlayerInvalid };
+
+  ::starboard::Mutex mutex_;
+  ::starboard::ConditionVariable condition_ { mutex_ };
+  int ticket_ { 0 };
+  bool needs_data_[2] { false, false };
+  SbPlayerState state_ { kSbPlayerStateInitialized };
+  bool initialized_ { false };
+  bool error_ { false };
+
+  // Results.
+  SbTimeMonotonic create_time_ { 0 };
+  SbTimeMonotonic seek_time_ { 0 };
+  bool seek_pending_ { false };
+  std::vector<SbTime> prerolls_;
+  uint64_t bytes_written_[2] { 0, 0 };
+  int samples_written_[2] { 0, 0 };
+  SbTime media_start_ { -1 };
+  SbTime media_end_ { 0 };
+  int skipped_pauses_ { 0 };
+};
+
+bool Replay::Load(const std::string& path) {
+  ::starboard::ScopedFile file(path.c_str(), kSbFileOpenOnly | kSbFileRead);
+  if (!file.IsValid()) {
+    SB_LOG(ERROR) << "Can't open '" << path << "'";
+    return false;
+  }
+  int64_t size = file.GetSize();
+  if (size <= static_cast<int64_t>(sizeof(kMagic) + sizeof(kVersion)) || size > kSbInt32Max) {
+    SB_LOG(ERROR) << "'" << path << "' is not a capture";
+    return false;
+  }
+  file_.resize(static_cast<size_t>(size));
+  if (file.ReadAll(reinterpret_cast<char*>(file_.data()), static_cast<int>(size)) != size) {
+    SB_LOG(ERROR) << "Failed to read '" << path << "'";
+    return false;
+  }
+
+  Reader reader(file_.data(), file_.size());
+  char magic[sizeof(kMagic)];
+  uint32_t version = 0;
+  if (!reader.Read(magic) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      !reader.Read(version) || version != kVersion) {
+    SB_LOG(ERROR) << "'" << path << "' is not a version " << kVersion << " capture";
+    return false;
+  }
+
+  bool has_header = false;
+  segments_.emplace_back();
+  for (;;) {
+    uint8_t type;
+    const uint8_t* payload;
+    uint32_t payload_size;
+    if (!reader.Read(type))
+      break;
+    if (!reader.ReadBytes(payload, payload_size)) {
+      SB_LOG(WARNING) << "Truncated capture, replaying what was read";
+      break;
+    }
+    Reader record(payload, payload_size);
+    bool ok = true;
+    switch (type) {
+      case kRecordHeader: {
+        uint32_t video_codec, audio_codec, samples_per_second, asc_size;
+        uint16_t channels, bits_per_sample;
+        const uint8_t* asc;
+        ok = record.Read(video_codec) && record.Read(audio_codec) &&
+             record.Read(channels) && record.Read(samples_per_second) &&
+             record.Read(bits_per_sample) && record.ReadBytes(asc, asc_size);
+        if (!ok)
+          break;
+        video_codec_ = static_cast<SbMediaVideoCodec>(video_codec);
+        memset(&audio_sample_info_, 0, sizeof(audio_sample_info_));
+        audio_sample_info_.codec = static_cast<SbMediaAudioCodec>(audio_codec);
+        audio_sample_info_.mime = "";
+        audio_sample_info_.number_of_channels = channels;
+        audio_sample_info_.samples_per_second = samples_per_second;
+        audio_sample_info_.bits_per_sample = bits_per_sample;
+        audio_sample_info_.audio_specific_config = asc_size ? asc : nullptr;
+        audio_sample_info_.audio_specific_config_size = static_cast<uint16_t>(asc_size);
+        has_header = true;
+        break;
+      }
+      case kRecordSample: {
+        uint8_t media_type, has_drm_info;
+        int64_t timestamp;
+        Sample sample;
+        ok = record.Read(media_type) && record.Read(timestamp) &&
+             record.ReadBytes(sample.data, sample.size);
+        if (ok && media_type == kSbMediaTypeVideo) {
+          uint8_t is_key_frame;
+          int32_t width, height;
+          const uint8_t* color_metadata;
+          uint32_t color_metadata_size;
+          ok = record.Read(is_key_frame) && record.Read(width) && record.Read(height) &&
+               record.ReadBytes(color_metadata, color_metadata_size) &&
+               color_metadata_size == sizeof(sample.color_metadata);
+          if (ok) {
+            sample.is_key_frame = is_key_frame;
+            sample.frame_width = width;
+            sample.frame_height = height;
+            memcpy(&sample.color_metadata, color_metadata, sizeof(sample.color_metadata));
+          }
+        }
+        ok = ok && record.Read(has_drm_info);
+        if (!ok)
+          break;
+        if (has_drm_info) {
+          SB_LOG(ERROR) << "Encrypted captures can't be replayed";
+          return false;
+        }
+        sample.timestamp = timestamp;
+        segments_.back().samples[StreamIndex(static_cast<SbMediaType>(media_type))].push_back(sample);
+        break;
+      }
+      case kRecordSeek:
+      case kRecordRate: {
+        Control& control = segments_.back().control;
+        if (type == kRecordSeek) {
+          int64_t timestamp;
+          int32_t ticket;
+          ok = record.Read(timestamp) && record.Read(ticket);
+          control.kind = Control::kSeek;
+          control.timestamp = timestamp;
+        } else {
+          ok = record.Read(control.rate);
+          control.kind = Control::kRate;
+        }
+        segments_.emplace_back();
+        break;
+      }
+      case kRecordEndOfStream: {
+        uint8_t media_type;
+        ok = record.Read(media_type);
+        if (ok)
+          segments_.back().end_of_stream[StreamIndex(static_cast<SbMediaType>(media_type))] = true;
+        break;
+      }
+      default:
+        SB_LOG(WARNING) << "Skipping unknown record " << static_cast<int>(type);
+        break;
+    }
+    if (!ok) {
+      SB_LOG(ERROR) << "Malformed record " << static_cast<int>(type) << " in '" << path << "'";
+      return false;
+    }
+  }
+
+  if (!has_header) {
+    SB_LOG(ERROR) << "'" << path << "' has no header";
+    return false;
+  }
+  return true;
+}
+
+// static
+void Replay::OnDecoderStatus(SbPlayer, void* context, SbMediaType type,
+                             SbPlayerDecoderState state, int ticket) {
+  Replay* replay = static_cast<Replay*>(context);
+  ::starboard::ScopedLock lock(replay->mutex_);
+  if (ticket != replay->ticket_ || state != kSbPlayerDecoderStateNeedsData)
+    return;
+  replay->needs_data_[StreamIndex(type)] = true;
+  replay->condition_.Broadcast();
+}
+
+// static
+void Replay::OnPlayerStatus(SbPlayer, void* context, SbPlayerState state, int ticket) {
+  Replay* replay = static_cast<Replay*>(context);
+  ::starboard::ScopedLock lock(replay->mutex_);
+  if (state == kSbPlayerStateInitialized) {
+    replay->initialized_ = true;
+    SB_LOG(INFO) << "Player initialized in "
+                 << (SbTimeGetMonotonicNow() - replay->create_time_) / kSbTimeMillisecond << "ms";
+  }
+  if (ticket != replay->ticket_)
+    return;
+  replay->state_ = state;
+  if (state == kSbPlayerStatePresenting && replay->seek_pending_) {
+    replay->seek_pending_ = false;
+    replay->prerolls_.push_back(SbTimeGetMonotonicNow() - replay->seek_time_);
+  }
+  replay->condition_.Broadcast();
+}
+
+// static
+void Replay::OnPlayerError(SbPlayer, void* context, SbPlayerError error, const char* message) {
+  Replay* replay = static_cast<Replay*>(context);
+  SB_LOG(ERROR) << "Player error " << error << ": " << (message ? message : "");
+  ::starboard::ScopedLock lock(replay->mutex_);
+  replay->error_ = true;
+  replay->condition_.Broadcast();
+}
+
+void Replay::Seek(SbTime timestamp) {
+  int ticket;
+  {
+    ::starboard::ScopedLock lock(mutex_);
+    ticket = ++ticket_;
+    needs_data_[0] = needs_data_[1] = false;
+    seek_pending_ = true;
+    seek_time_ = SbTimeGetMonotonicNow();
+  }
+  SbPlayerSeek2(player_, timestamp, ticket);
+}
+
+bool Replay::WaitForState(SbPlayerState state, SbTime timeout) {
+  SbTimeMonotonic deadline = SbTimeGetMonotonicNow() + timeout;
+  ::starboard::ScopedLock lock(mutex_);
+  while (!error_ && state_ != state) {
+    SbTime remaining = deadline - SbTimeGetMonotonicNow();
+    if (remaining <= 0)
+      return false;
+    condition_.WaitTimed(remaining);
+  }
+  return !error_;
+}
+
+bool Replay::WriteSegment(const Segment& segment) {
+  size_t next[2] = { 0, 0 };
+  bool eos_written[2] = { !segment.end_of_stream[0], !segment.end_of_stream[1] };
+
+  for (;;) {
+    int index = -1;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      SbTimeMonotonic deadline = SbTimeGetMonotonicNow() + kStallTimeout;
+      for (;;) {
+        if (error_)
+          return false;
+        bool pending = false;
+        for (int i = 0; i < 2; ++i) {
+          bool has_more = next[i] < segment.samples[i].size() || !eos_written[i];
+          pending |= has_more;
+          if (has_more && needs_data_[i] && index < 0)
+            index = i;
+        }
+        if (!pending)
+          return true;
+        if (index >= 0) {
+          needs_data_[index] = false;
+          break;
+        }
+        SbTime remaining = deadline - SbTimeGetMonotonicNow();
+        if (remaining <= 0) {
+          SB_LOG(ERROR) << "Player stalled, no data requested for " << kStallTimeout / kSbTimeSecond << "s";
+          return false;
+        }
+        condition_.WaitTimed(remaining);
+      }
+    }
+
+    const SbMediaType type = index == 1 ? kSbMediaTypeVideo : kSbMediaTypeAudio;
+    if (next[index] == segment.samples[index].size()) {
+      SbPlayerWriteEndOfStream(player_, type);
+      eos_written[index] = true;
+      continue;
+    }
+
+    const Sample& sample = segment.samples[index][next[index]++];
+    SbPlayerSampleInfo info;
+    memset(&info, 0, sizeof(info));
+    info.type = type;
+    info.buffer = sample.data;
+    info.buffer_size = static_cast<int>(sample.size);
+    info.timestamp = sample.timestamp;
+    if (type == kSbMediaTypeVideo) {
+      info.video_sample_info.codec = video_codec_;
+      info.video_sample_info.mime = "";
+      info.video_sample_info.max_video_capabilities = "";
+      info.video_sample_info.is_key_frame = sample.is_key_frame;
+      info.video_sample_info.frame_width = sample.frame_width;
+      info.video_sample_info.frame_height = sample.frame_height;
+      info.video_sample_info.color_metadata = sample.color_metadata;
+    } else {
+      info.audio_sample_info = audio_sample_info_;
+    }
+    SbPlayerWriteSample2(player_, type, &info, 1);
+
+    bytes_written_[index] += sample.size;
+    ++samples_written_[index];
+    if (media_start_ < 0 || sample.timestamp < media_start_)
+      media_start_ = sample.timestamp;
+    media_end_ = std::max(media_end_, sample.timestamp);
+  }
+}
+
+int Replay::Run(bool honor_pauses) {
+  SbWindow window = SbWindowCreate(nullptr);
+
+  SbPlayerCreationParam param;
+  memset(&param, 0, sizeof(param));
+  param.drm_system = kSbDrmSystemInvalid;
+  param.audio_sample_info = audio_sample_info_;
+  param.video_sample_info.codec = video_codec_;
+  param.video_sample_info.mime = "";
+  param.video_sample_info.max_video_capabilities = "";
+  param.output_mode = kSbPlayerOutputModePunchOut;
+
+  create_time_ = SbTimeGetMonotonicNow();
+  player_ = SbPlayerCreate(window, &param, &Replay::DeallocateSample,
+                           &Replay::OnDecoderStatus, &Replay::OnPlayerStatus,
+                           &Replay::OnPlayerError, this, nullptr);
+  if (!SbPlayerIsValid(player_)) {
+    SB_LOG(ERROR) << "Failed to create player";
+    SbWindowDestroy(window);
+    return 1;
+  }
+  SbPlayerSetBounds(player_, 0, 0, 0, 1920, 1080);
+
+  bool ok = true;
+  {
+    SbTimeMonotonic deadline = SbTimeGetMonotonicNow() + kStallTimeout;
+    ::starboard::ScopedLock lock(mutex_);
+    while (!initialized_ && !error_ && SbTimeGetMonotonicNow() < deadline)
+      condition_.WaitTimed(deadline - SbTimeGetMonotonicNow());
+    ok = initialized_ && !error_;
+  }
+
+  // Captures start with the app's initial seek, start at the first sample
+  // when that was missed.
+  if (ok && (!segments_[0].samples[0].empty() || !segments_[0].samples[1].empty())) {
+    SbTime start = kSbTimeMax;
+    for (const auto& samples : segments_[0].samples) {
+      if (!samples.empty())
+        start = std::min(start, samples.front().timestamp);
+    }
+    Seek(start);
+  }
+
+  SbTimeMonotonic start = SbTimeGetMonotonicNow();
+  bool reached_end_of_stream = false;
+  for (size_t i = 0; ok && i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    ok = WriteSegment(segment);
+    if (!ok)
+      break;
+    if (segment.end_of_stream[0] || segment.end_of_stream[1])
+      reached_end_of_stream = true;
+    switch (segment.control.kind) {
+      case Control::kSeek:
+        Seek(segment.control.timestamp);
+        reached_end_of_stream = false;
+        break;
+      case Control::kRate:
+        if (segment.control.rate == 0 && !honor_pauses) {
+          ++skipped_pauses_;
+          break;
+        }
+        SbPlayerSetPlaybackRate(player_, segment.control.rate);
+        break;
+      case Control::kNone:
+        break;
+    }
+  }
+
+  if (ok && reached_end_of_stream) {
+    SbTime media_duration = std::max<SbTime>(0, media_end_ - media_start_);
+    ok = WaitForState(kSbPlayerStateEndOfStream, media_duration + kEndOfStreamGrace);
+    if (!ok)
+      SB_LOG(ERROR) << "Player didn't reach end of stream";
+  }
+
+  Report(SbTimeGetMonotonicNow() - start);
+
+  SbPlayerDestroy(player_);
+  player_ = kSbPlayerInvalid;
+  SbWindowDestroy(window);
+  return ok ? 0 : 1;
+}
+
+void Replay::Report(SbTime elapsed) {
+  SbPlayerInfo2 info;
+  memset(&info, 0, sizeof(info));
+  SbPlayerGetInfo2(player_, &info);
+
+  const char* const kStreamNames[] = { "audio", "video" };
+  double seconds = std::max<double>(elapsed, 1) / kSbTimeSecond;
+  SB_LOG(INFO) << "Replayed " << (media_end_ - media_start_) / kSbTimeMillisecond
+               << "ms of media in " << elapsed / kSbTimeMillisecond << "ms";
+  for (int i = 0; i < 2; ++i) {
+    if (!samples_written_[i])
+      continue;
+    SB_LOG(INFO) << kStreamNames[i] << ": " << samples_written_[i] << " samples, "
+                 << bytes_written_[i] / 1024 << "KB, "
+                 << static_cast<int>(samples_written_[i] / seconds) << " samples/s, "
+                 << static_cast<int>(bytes_written_[i] / 1024 / seconds) << "KB/s";
+  }
+  for (size_t i = 0; i < prerolls_.size(); ++i) {
+    SB_LOG(INFO) << (i == 0 ? "Preroll: " : "Seek latency: ")
+                 << prerolls_[i] / kSbTimeMillisecond << "ms";
+  }
+  SB_LOG(INFO) << "Video frames: " << info.total_video_frames
+               << ", dropped: " << info.dropped_video_frames
+               << ", corrupted: " << info.corrupted_video_frames;
+  if (skipped_pauses_)
+    SB_LOG(INFO) << "Skipped " << skipped_pauses_ << " pauses";
+}
+
+std::string GetOption(const SbEventStartData* data, const std::string& name) {
+  const std::string prefix = "--" + name + "=";
+  for (int i = 1; i < data->argument_count; ++i) {
+    std::string argument = data->argument_values[i];
+    if (argument.compare(0, prefix.size(), prefix) == 0)
+      return argument.substr(prefix.size());
+  }
+  return std::string();
+}
+
+bool HasOption(const SbEventStartData* data, const std::string& name) {
+  const std::string flag = "--" + name;
+  for (int i = 1; i < data->argument_count; ++i) {
+    if (flag == data->argument_values[i])
+      return true;
+  }
+  return false;
+}
+
+struct ReplayOptions {
+  std::string capture;
+  bool honor_pauses { false };
+};
+
+void* ReplayThread(void* context) {
+  std::unique_ptr<ReplayOptions> options(static_cast<ReplayOptions*>(context));
+  Replay replay;
+  int result = replay.Load(options->capture) ? replay.Run(options->honor_pauses) : 1;
+  SbSystemRequestStop(result);
+  return nullptr;
+}
+
+}  // namespace
+
+void SbEventHandle(const SbEvent* event) {
+  if (event->type != kSbEventTypeStart)
+    return;
+
+  const SbEventStartData* data = static_cast<const SbEventStartData*>(event->data);
+  std::unique_ptr<ReplayOptions> options(new ReplayOptions);
+  options->capture = GetOption(data, "capture");
+  options->honor_pauses = HasOption(data, "honor_pauses");
+  if (options->capture.empty()) {
+    SB_LOG(ERROR) << "Usage: player_replay --capture=<file.es> [--fake_sinks] [--honor_pauses]";
+    SbSystemRequestStop(1);
+    return;
+  }
+  if (HasOption(data, "fake_sinks"))
+    setenv("COBALT_PLAYER_FAKE_SINKS", "1", 1);
+
+  // Replay blocks on the player, the event loop has to keep running.
+  SbThread thread = SbThreadCreate(0, kSbThreadNoPriority, kSbThreadNoAffinity, false,
+                                   "player_replay", &ReplayThread, options.get());
+  if (!SbThreadIsValid(thread)) {
+    SbSystemRequestStop(1);
+    return;
+  }
+  options.release();
+}
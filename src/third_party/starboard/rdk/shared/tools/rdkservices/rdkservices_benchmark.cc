@@ -0,0 +1,263 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Times the Thunder calls rdkservices.cc makes, over the same JSONRPC link
+// it uses. Meant to run against rdkservices_stub (or a device) with
+// THUNDER_ACCESS set:
+//
+//   rdkservices_benchmark [-n iterations] [-r retries] [-i retry_interval_ms]
+//
+// Reports per method call latency, event delivery latency for the
+// subscriptions and, against the stub, how long the retry loop takes to
+// get through injected failures.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <core/core.h>
+#include <websocket/JSONRPCLink.h>
+
+using namespace WPEFramework;
+
+namespace {
+
+const uint32_t kDefaultTimeoutMs = 100;
+const uint32_t kEventTimeoutMs = 1000;
+const char kStubCallsign[] = "Stub.1";
+
+typedef std::chrono::steady_clock Clock;
+
+struct Method {
+  const char* callsign;
+  const char* name;
+};
+
+// Mirrors the calls rdkservices.cc makes at startup and on refresh.
+const Method kMethods[] = {
+  { "DisplayInfo.1", "widthincentimeters" },
+  { "DisplayInfo.1", "heightincentimeters" },
+  { "DisplayInfo.1", "tvcapabilities" },
+  { "DisplayInfo.1", "stbcapabilities" },
+  { "PlayerInfo.1", "resolution" },
+  { "DeviceIdentification.1", "deviceidentification" },
+  { "org.rdk.Network.1", "getInterfaces" },
+  { "org.rdk.Network.1", "getDefaultInterface" },
+  { "org.rdk.TextToSpeech.1", "isttsenabled" },
+  { "org.rdk.AuthService.1", "getExperience" },
+};
+
+const Method kEvents[] = {
+  { "DisplayInfo.1", "updated" },
+  { "org.rdk.Network.1", "onConnectionStatusChanged" },
+  { "org.rdk.TextToSpeech.1", "onttsstatechanged" },
+};
+
+typedef JSONRPC::LinkType<Core::JSON::IElement> Link;
+
+double ToMs(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void Report(const std::string& name, std::vector<double>& samples, int failures) {
+  if (samples.empty()) {
+    printf("%-55s failed: %d\n", name.c_str(), failures);
+    return;
+  }
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+  size_t p95 = std::min(samples.size() - 1, samples.size() * 95 / 100);
+  printf("%-55s min: %7.2fms avg: %7.2fms p95: %7.2fms max: %7.2fms failed: %d\n",
+         name.c_str(), samples.front(), total / samples.size(), samples[p95], samples.back(), failures);
+}
+
+void BenchmarkCalls(int iterations) {
+  printf("Call latency (%d iterations)\n", iterations);
+  for (const Method& method : kMethods) {
+    Link link(method.callsign, nullptr, false);
+    std::vector<double> samples;
+    int failures = 0;
+    for (int i = 0; i < iterations; ++i) {
+      Core::JSON::String response;
+      Clock::time_point start = Clock::now();
+      uint32_t rc = link.Get(kDefaultTimeoutMs, method.name, response);
+      if (rc == Core::ERROR_NONE)
+        samples.push_back(ToMs(Clock::now() - start));
+      else
+        ++failures;
+    }
+    Report(std::string(method.callsign) + "." + method.name, samples, failures);
+  }
+}
+
+class EventProbe {
+public:
+  explicit EventProbe(const Method& event)
+    : link_(event.callsign, nullptr, false)
+    , name_(std::string(event.callsign) + "." + event.name) {
+    subscribed_ = link_.Subscribe<Core::JSON::String>(kDefaultTimeoutMs, event.name, &EventProbe::OnEvent, this) == Core::ERROR_NONE;
+  }
+
+  ~EventProbe() {
+    if (subscribed_)
+      link_.Unsubscribe(kDefaultTimeoutMs, name_.substr(name_.rfind('.') + 1));
+  }
+
+  bool subscribed() const { return subscribed_; }
+  const std::string& name() const { return name_; }
+
+  // Has the stub send the event and waits for it to come back. Returns the
+  // round trip in ms or a negative value if it didn't arrive.
+  double Fire(Link& control) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    received_ = false;
+    lock.unlock();
+
+    JsonObject params;
+    params["event"] = name_;
+    Core::JSON::String delivered;
+    Clock::time_point start = Clock::now();
+    if (control.Invoke<JsonObject, Core::JSON::String>(kDefaultTimeoutMs, "fire", params, delivered) != Core::ERROR_NONE)
+      return -1;
+
+    lock.lock();
+    if (!condition_.wait_for(lock, std::chrono::milliseconds(kEventTimeoutMs), [this]() { return received_; }))
+      return -1;
+    return ToMs(received_at_ - start);
+  }
+
+private:
+  void OnEvent(const Core::JSON::String&) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    received_at_ = Clock::now();
+    received_ = true;
+    condition_.notify_all();
+  }
+
+  Link link_;
+  const std::string name_;
+  bool subscribed_ { false };
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool received_ { false };
+  Clock::time_point received_at_;
+};
+
+void BenchmarkEvents(int iterations) {
+  printf("Event delivery latency (%d iterations)\n", iterations);
+  Link control(kStubCallsign, nullptr, false);
+  for (const Method& event : kEvents) {
+    Clock::time_point start = Clock::now();
+    EventProbe probe(event);
+    double subscribe_ms = ToMs(Clock::now() - start);
+    if (!probe.subscribed()) {
+      printf("%-55s subscribe failed\n", probe.name().c_str());
+      continue;
+    }
+    printf("%-55s subscribe: %7.2fms\n", probe.name().c_str(), subscribe_ms);
+    std::vector<double> samples;
+    int failures = 0;
+    for (int i = 0; i < iterations; ++i) {
+      double latency = probe.Fire(control);
+      if (latency < 0)
+        ++failures;
+      else
+        samples.push_back(latency);
+    }
+    Report(probe.name(), samples, failures);
+  }
+}
+
+// Injects |failures| errors on a method and retries it like the refresh
+// paths do, to see how long it takes to recover.
+void BenchmarkRetries(int max_failures, int interval_ms) {
+  printf("Retry (interval %dms)\n", interval_ms);
+  Link control(kStubCallsign, nullptr, false);
+  const Method& method = kMethods[0];
+  const std::string full_name = std::string(method.callsign) + "." + method.name;
+  for (int failures = 1; failures <= max_failures; ++failures) {
+    JsonObject params;
+    params["method"] = full_name;
+    params["error"] = Core::ERROR_UNAVAILABLE;
+    params["failures"] = failures;
+    Core::JSON::String ignored;
+    if (control.Invoke<JsonObject, Core::JSON::String>(kDefaultTimeoutMs, "configure", params, ignored) != Core::ERROR_NONE) {
+      printf("Retries need rdkservices_stub, skipped\n");
+      return;
+    }
+
+    Link link(method.callsign, nullptr, false);
+    int attempts = 0;
+    uint32_t rc = Core::ERROR_GENERAL;
+    Clock::time_point start = Clock::now();
+    while (attempts <= max_failures && rc != Core::ERROR_NONE) {
+      if (attempts++ > 0)
+        usleep(interval_ms * 1000);
+      Core::JSON::String response;
+      rc = link.Get(kDefaultTimeoutMs, method.name, response);
+    }
+    printf("%-55s failures: %d attempts: %d time: %7.2fms%s\n",
+           full_name.c_str(), failures, attempts, ToMs(Clock::now() - start),
+           rc == Core::ERROR_NONE ? "" : " (gave up)");
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 100;
+  int retries = 3;
+  int retry_interval_ms = 100;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:r:i:h")) != -1) {
+    switch (opt) {
+      case 'n':
+        iterations = std::max(1, atoi(optarg));
+        break;
+      case 'r':
+        retries = atoi(optarg);
+        break;
+      case 'i':
+        retry_interval_ms = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n iterations] [-r retries] [-i retry_interval_ms]\n", argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  if (getenv("THUNDER_ACCESS") == nullptr) {
+    fprintf(stderr, "THUNDER_ACCESS is not set, e.g. THUNDER_ACCESS=127.0.0.1:9998\n");
+    return 1;
+  }
+
+  BenchmarkCalls(iterations);
+  BenchmarkEvents(iterations);
+  BenchmarkRetries(retries, retry_interval_ms);
+
+  Core::Singleton::Dispose();
+  return 0;
+}
@@ -0,0 +1,744 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Stand-in for the Thunder JSON-RPC endpoint, answering the methods and
+// events rdkservices.cc uses so it can be exercised and timed off-device.
+// Speaks JSON-RPC over a WebSocket like WPEFramework, point Cobalt (or the
+// benchmark) at it with THUNDER_ACCESS=127.0.0.1:<port>.
+//
+//   rdkservices_stub [-p port] [-c config]
+//
+// The config file replaces or adds responses, one per line:
+//
+//   method <callsign.version.method> <latency_ms> <error> <failures> <result json>
+//   event  <callsign.version.event> <interval_ms> <params json>
+//
+// <error> is the JSON-RPC error code to answer with, 0 for none. With
+// <failures> above 0 only that many calls fail before the result is
+// returned, e.g. to measure retries. Events with an interval are sent
+// periodically to their subscribers, all of them can be sent on demand.
+//
+// The stub itself answers on the "Stub.1" callsign:
+//   Stub.1.configure {"method":..., "latency":..., "error":..., "failures":...}
+//   Stub.1.fire      {"event":"DisplayInfo.1.updated"}
+//   Stub.1.stats     -> {"calls":..., "failed":..., "events":...}
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kDefaultPort = 9998;
+
+// JSON-RPC "method not found".
+const int kErrorUnknownMethod = -32601;
+
+struct MethodConfig {
+  int latency_ms { 0 };
+  int error { 0 };
+  int failures { 0 };
+  std::string result;
+};
+
+struct EventConfig {
+  int interval_ms { 0 };
+  std::string params;
+};
+
+// Responses for everything rdkservices.cc queries on a healthy device.
+const char* const kDefaultMethods[][2] = {
+  { "DisplayInfo.1.widthincentimeters", "121" },
+  { "DisplayInfo.1.heightincentimeters", "68" },
+  { "DisplayInfo.1.tvcapabilities", "[\"HDR_10\",\"HDR_HLG\"]" },
+  { "DisplayInfo.1.stbcapabilities", "[\"HDR_10\",\"HDR_HLG\",\"HDR_DOLBYVISION\"]" },
+  { "PlayerInfo.1.resolution", "\"Resolution1080P\"" },
+  { "DeviceIdentification.1.deviceidentification",
+    "{\"firmwareversion\":\"1.0.0-stub\",\"chipset\":\"STUB CHIPSET\",\"identifier\":\"0000\"}" },
+  { "org.rdk.Network.1.getInterfaces",
+    "{\"interfaces\":[{\"interface\":\"ETHERNET\",\"macAddress\":\"00:00:00:00:00:00\","
+    "\"enabled\":true,\"connected\":true}],\"success\":true}" },
+  { "org.rdk.Network.1.getDefaultInterface", "{\"interface\":\"ETHERNET\",\"success\":true}" },
+  { "org.rdk.TextToSpeech.1.isttsenabled", "{\"isenabled\":false,\"TTS_Status\":0,\"success\":true}" },
+  { "org.rdk.TextToSpeech.1.speak", "{\"speechid\":1,\"TTS_Status\":0,\"success\":true}" },
+  { "org.rdk.TextToSpeech.1.cancel", "{\"TTS_Status\":0,\"success\":true}" },
+  { "org.rdk.AuthService.1.getExperience", "{\"experience\":\"Flex\",\"success\":true}" },
+  { "status@org.rdk.AuthService.1", "[{\"callsign\":\"org.rdk.AuthService\",\"state\":\"activated\"}]" },
+  { "Controller.1.status@org.rdk.AuthService.1",
+    "[{\"callsign\":\"org.rdk.AuthService\",\"state\":\"activated\"}]" },
+};
+
+const char* const kDefaultEvents[][2] = {
+  { "DisplayInfo.1.updated", "{}" },
+  { "org.rdk.Network.1.onConnectionStatusChanged", "{\"interface\":\"ETHERNET\",\"status\":\"CONNECTED\"}" },
+  { "org.rdk.TextToSpeech.1.onttsstatechanged", "{\"state\":false}" },
+};
+
+// Just enough JSON to pick fields out of flat JSON-RPC messages.
+size_t SkipValue(const std::string& json, size_t pos) {
+  int depth = 0;
+  bool in_string = false;
+  for (; pos < json.size(); ++pos) {
+    char c = json[pos];
+    if (in_string) {
+      if (c == '\\')
+        ++pos;
+      else if (c == '"')
+        in_string = false;
+      if (!in_string && depth == 0)
+        return pos + 1;
+      continue;
+    }
+    if (c == '"') {
+      in_string = true;
+    } else if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0)
+        return pos;
+      if (--depth == 0)
+        return pos + 1;
+    } else if (c == ',' && depth == 0) {
+      return pos;
+    }
+  }
+  return pos;
+}
+
+// Returns the raw value of top level |key| in the object |json|.
+bool FindRaw(const std::string& json, const std::string& key, std::string& out) {
+  const std::string pattern = "\"" + key + "\"";
+  size_t pos = 0;
+  int depth = 0;
+  bool in_string = false;
+  for (; pos < json.size(); ++pos) {
+    char c = json[pos];
+    if (in_string) {
+      if (c == '\\')
+        ++pos;
+      else if (c == '"')
+        in_string = false;
+      continue;
+    }
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      --depth;
+    } else if (c == '"') {
+      if (depth == 1 && json.compare(pos, pattern.size(), pattern) == 0) {
+        size_t colon = json.find(':', pos + pattern.size());
+        if (colon == std::string::npos)
+          return false;
+        size_t begin = json.find_first_not_of(" \t\r\n", colon + 1);
+        if (begin == std::string::npos)
+          return false;
+        size_t end = SkipValue(json, begin);
+        out = json.substr(begin, end - begin);
+        while (!out.empty() && isspace(static_cast<unsigned char>(out.back())))
+          out.pop_back();
+        return true;
+      }
+      in_string = true;
+    }
+  }
+  return false;
+}
+
+bool FindString(const std::string& json, const std::string& key, std::string& out) {
+  std::string raw;
+  if (!FindRaw(json, key, raw) || raw.size() < 2 || raw[0] != '"')
+    return false;
+  out = raw.substr(1, raw.size() - 2);
+  return true;
+}
+
+bool FindInt(const std::string& json, const std::string& key, int& out) {
+  std::string raw;
+  if (!FindRaw(json, key, raw) || raw.empty())
+    return false;
+  out = atoi(raw.c_str());
+  return true;
+}
+
+// SHA-1, only needed for the WebSocket handshake.
+std::string Sha1(const std::string& input) {
+  uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+  std::string data = input;
+  uint64_t bit_length = static_cast<uint64_t>(input.size()) * 8;
+  data.push_back(static_cast<char>(0x80));
+  while (data.size() % 64 != 56)
+    data.push_back(0);
+  for (int i = 7; i >= 0; --i)
+    data.push_back(static_cast<char>(bit_length >> (i * 8)));
+
+  auto rotl = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
+  for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const unsigned char* p = reinterpret_cast<const unsigned char*>(&data[chunk + i * 4]);
+      w[i] = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+    for (int i = 16; i < 80; ++i)
+      w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotl(b, 30);
+      b = a;
+      a = temp;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+
+  std::string digest;
+  for (uint32_t value : h) {
+    for (int i = 3; i >= 0; --i)
+      digest.push_back(static_cast<char>(value >> (i * 8)));
+  }
+  return digest;
+}
+
+std::string Base64(const std::string& input) {
+  static const char kTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  size_t i = 0;
+  for (; i + 2 < input.size(); i += 3) {
+    uint32_t n = (static_cast<unsigned char>(input[i]) << 16) |
+                 (static_cast<unsigned char>(input[i + 1]) << 8) |
+                 static_cast<unsigned char>(input[i + 2]);
+    out += kTable[(n >> 18) & 63];
+    out += kTable[(n >> 12) & 63];
+    out += kTable[(n >> 6) & 63];
+    out += kTable[n & 63];
+  }
+  if (i < input.size()) {
+    uint32_t n = static_cast<unsigned char>(input[i]) << 16;
+    if (i + 1 < input.size())
+      n |= static_cast<unsigned char>(input[i + 1]) << 8;
+    out += kTable[(n >> 18) & 63];
+    out += kTable[(n >> 12) & 63];
+    out += (i + 1 < input.size()) ? kTable[(n >> 6) & 63] : '=';
+    out += '=';
+  }
+  return out;
+}
+
+bool ReadFully(int fd, void* buffer, size_t size) {
+  char* p = static_cast<char*>(buffer);
+  while (size > 0) {
+    ssize_t n = read(fd, p, size);
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool WriteFully(int fd, const void* buffer, size_t size) {
+  const char* p = static_cast<const char*>(buffer);
+  while (size > 0) {
+    ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+    if (n <= 0)
+      return false;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+class Connection {
+public:
+  explicit Connection(int fd) : fd_(fd) { }
+  ~Connection() { close(fd_); }
+
+  int fd() const { return fd_; }
+
+  bool Handshake() {
+    std::string request;
+    char c;
+    while (request.size() < 8192 && request.find("\r\n\r\n") == std::string::npos) {
+      if (read(fd_, &c, 1) != 1)
+        return false;
+      request.push_back(c);
+    }
+    const std::string kKeyHeader = "sec-websocket-key:";
+    std::string lower = request;
+    for (char& ch : lower)
+      ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+    size_t pos = lower.find(kKeyHeader);
+    if (pos == std::string::npos)
+      return false;
+    size_t begin = request.find_first_not_of(' ', pos + kKeyHeader.size());
+    size_t end = request.find("\r\n", begin);
+    std::string key = request.substr(begin, end - begin);
+    std::string accept = Base64(Sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+    std::string response =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: " + accept + "\r\n";
+    // WPEFramework asks for the "json" protocol, echo whatever came.
+    const std::string kProtocolHeader = "sec-websocket-protocol:";
+    pos = lower.find(kProtocolHeader);
+    if (pos != std::string::npos) {
+      begin = request.find_first_not_of(' ', pos + kProtocolHeader.size());
+      end = request.find("\r\n", begin);
+      std::string protocol = request.substr(begin, end - begin);
+      size_t comma = protocol.find(',');
+      if (comma != std::string::npos)
+        protocol.resize(comma);
+      response += "Sec-WebSocket-Protocol: " + protocol + "\r\n";
+    }
+    response += "\r\n";
+    return WriteFully(fd_, response.data(), response.size());
+  }
+
+  // Returns false once the peer is gone or closed the connection.
+  bool ReadMessage(std::string& out) {
+    out.clear();
+    for (;;) {
+      unsigned char header[2];
+      if (!ReadFully(fd_, header, 2))
+        return false;
+      bool fin = header[0] & 0x80;
+      int opcode = header[0] & 0x0F;
+      bool masked = header[1] & 0x80;
+      uint64_t length = header[1] & 0x7F;
+      if (length == 126) {
+        unsigned char ext[2];
+        if (!ReadFully(fd_, ext, 2))
+          return false;
+        length = (ext[0] << 8) | ext[1];
+      } else if (length == 127) {
+        unsigned char ext[8];
+        if (!ReadFully(fd_, ext, 8))
+          return false;
+        length = 0;
+        for (int i = 0; i < 8; ++i)
+          length = (length << 8) | ext[i];
+      }
+      if (length > 16 * 1024 * 1024)
+        return false;
+      unsigned char mask[4] = { 0, 0, 0, 0 };
+      if (masked && !ReadFully(fd_, mask, 4))
+        return false;
+      std::string payload(length, '\0');
+      if (length && !ReadFully(fd_, &payload[0], length))
+        return false;
+      if (masked) {
+        for (size_t i = 0; i < payload.size(); ++i)
+          payload[i] ^= mask[i % 4];
+      }
+      switch (opcode) {
+        case 0x8:
+          Send(0x8, payload);
+          return false;
+        case 0x9:
+          Send(0xA, payload);
+          continue;
+        case 0xA:
+          continue;
+        default:
+          out += payload;
+          break;
+      }
+      if (fin)
+        return true;
+    }
+  }
+
+  bool Send(const std::string& text) {
+    return Send(0x1, text);
+  }
+
+  void AddSubscription(const std::string& event, const std::string& designator) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscriptions_.insert(std::make_pair(event, designator));
+  }
+
+  void RemoveSubscription(const std::string& event, const std::string& designator) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = subscriptions_.equal_range(event);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == designator) {
+        subscriptions_.erase(it);
+        return;
+      }
+    }
+  }
+
+  std::vector<std::string> GetDesignators(const std::string& event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> result;
+    auto range = subscriptions_.equal_range(event);
+    for (auto it = range.first; it != range.second; ++it)
+      result.push_back(it->second);
+    return result;
+  }
+
+private:
+  bool Send(int opcode, const std::string& payload) {
+    std::string frame;
+    frame.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+      frame.push_back(static_cast<char>(payload.size()));
+    } else if (payload.size() < 65536) {
+      frame.push_back(126);
+      frame.push_back(static_cast<char>(payload.size() >> 8));
+      frame.push_back(static_cast<char>(payload.size()));
+    } else {
+      frame.push_back(127);
+      for (int i = 7; i >= 0; --i)
+        frame.push_back(static_cast<char>(static_cast<uint64_t>(payload.size()) >> (i * 8)));
+    }
+    frame += payload;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return WriteFully(fd_, frame.data(), frame.size());
+  }
+
+  const int fd_;
+  std::mutex write_mutex_;
+  std::mutex mutex_;
+  // Event ("DisplayInfo.1.updated") to the designators it was registered for.
+  std::multimap<std::string, std::string> subscriptions_;
+};
+
+class Stub {
+public:
+  Stub() {
+    for (const auto& entry : kDefaultMethods)
+      methods_[entry[0]].result = entry[1];
+    for (const auto& entry : kDefaultEvents)
+      events_[entry[0]].params = entry[1];
+  }
+
+  bool LoadConfig(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+      fprintf(stderr, "Can't open %s\n", path.c_str());
+      return false;
+    }
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+      ++line_number;
+      std::istringstream stream(line);
+      std::string kind, name;
+      if (!(stream >> kind) || kind[0] == '#')
+        continue;
+      if (kind == "method") {
+        MethodConfig config;
+        if (!(stream >> name >> config.latency_ms >> config.error >> config.failures)) {
+          fprintf(stderr, "%s:%d: expected 'method <name> <latency_ms> <error> <failures> <result>'\n",
+                  path.c_str(), line_number);
+          return false;
+        }
+        std::getline(stream >> std::ws, config.result);
+        if (config.result.empty())
+          config.result = "null";
+        methods_[name] = config;
+      } else if (kind == "event") {
+        EventConfig config;
+        if (!(stream >> name >> config.interval_ms)) {
+          fprintf(stderr, "%s:%d: expected 'event <name> <interval_ms> <params>'\n",
+                  path.c_str(), line_number);
+          return false;
+        }
+        std::getline(stream >> std::ws, config.params);
+        if (config.params.empty())
+          config.params = "{}";
+        events_[name] = config;
+      } else {
+        fprintf(stderr, "%s:%d: unknown entry '%s'\n", path.c_str(), line_number, kind.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Serve(int port) {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(server, 16) != 0) {
+      perror("rdkservices_stub: bind");
+      exit(1);
+    }
+    printf("Listening on 127.0.0.1:%d, set THUNDER_ACCESS=127.0.0.1:%d\n", port, port);
+    fflush(stdout);
+
+    std::thread(&Stub::SendPeriodicEvents, this).detach();
+
+    for (;;) {
+      int fd = accept(server, nullptr, nullptr);
+      if (fd < 0)
+        continue;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+      std::thread(&Stub::HandleConnection, this, std::make_shared<Connection>(fd)).detach();
+    }
+  }
+
+private:
+  void HandleConnection(std::shared_ptr<Connection> connection) {
+    if (!connection->Handshake())
+      return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      connections_.push_back(connection);
+    }
+    std::string message;
+    while (connection->ReadMessage(message))
+      HandleMessage(connection, message);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = connections_.begin(); it != connections_.end(); ++it) {
+      if (*it == connection) {
+        connections_.erase(it);
+        break;
+      }
+    }
+  }
+
+  void HandleMessage(const std::shared_ptr<Connection>& connection, const std::string& message) {
+    std::string id, method, params;
+    FindRaw(message, "id", id);
+    FindString(message, "method", method);
+    FindRaw(message, "params", params);
+    if (method.empty() || id.empty())
+      return;
+
+    const std::string kRegister = ".register";
+    const std::string kUnregister = ".unregister";
+    if (EndsWith(method, kRegister) || EndsWith(method, kUnregister)) {
+      bool subscribe = EndsWith(method, kRegister);
+      std::string callsign = method.substr(0, method.size() - (subscribe ? kRegister.size() : kUnregister.size()));
+      std::string event, designator;
+      FindString(params, "event", event);
+      FindString(params, "id", designator);
+      if (subscribe)
+        connection->AddSubscription(callsign + "." + event, designator);
+      else
+        connection->RemoveSubscription(callsign + "." + event, designator);
+      Reply(connection, id, "0", 0);
+      return;
+    }
+
+    if (method == "Stub.1.configure") {
+      std::string name;
+      FindString(params, "method", name);
+      std::lock_guard<std::mutex> lock(mutex_);
+      MethodConfig& config = methods_[name];
+      FindInt(params, "latency", config.latency_ms);
+      FindInt(params, "error", config.error);
+      FindInt(params, "failures", config.failures);
+      std::string result;
+      if (FindRaw(params, "result", result))
+        config.result = result;
+      Reply(connection, id, "null", 0);
+      return;
+    }
+    if (method == "Stub.1.fire") {
+      std::string event;
+      FindString(params, "event", event);
+      int delivered = Fire(event);
+      Reply(connection, id, std::to_string(delivered), 0);
+      return;
+    }
+    if (method == "Stub.1.stats") {
+      std::ostringstream result;
+      result << "{\"calls\":" << calls_.load() << ",\"failed\":" << failed_.load()
+             << ",\"events\":" << events_sent_.load() << "}";
+      Reply(connection, id, result.str(), 0);
+      return;
+    }
+
+    MethodConfig config;
+    bool known;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = methods_.find(method);
+      known = (it != methods_.end());
+      if (known) {
+        config = it->second;
+        // A counted error goes away once the failures are used up, one
+        // without a count fails every call.
+        if (it->second.error != 0 && it->second.failures > 0 && --it->second.failures == 0)
+          it->second.error = 0;
+      }
+    }
+    ++calls_;
+
+    int error = known ? config.error : kErrorUnknownMethod;
+    if (error)
+      ++failed_;
+
+    if (config.latency_ms <= 0) {
+      Reply(connection, id, config.result, error);
+      return;
+    }
+    // Answer late without holding up the other requests on the link.
+    std::thread([this, connection, id, config, error]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(config.latency_ms));
+      Reply(connection, id, config.result, error);
+    }).detach();
+  }
+
+  void Reply(const std::shared_ptr<Connection>& connection, const std::string& id,
+             const std::string& result, int error) {
+    std::string response = "{\"jsonrpc\":\"2.0\",\"id\":" + id + ",";
+    if (error)
+      response += "\"error\":{\"code\":" + std::to_string(error) + ",\"message\":\"stub error\"}}";
+    else
+      response += "\"result\":" + (result.empty() ? std::string("null") : result) + "}";
+    connection->Send(response);
+  }
+
+  // Sends |event| ("DisplayInfo.1.updated") to its subscribers, returns how
+  // many got it.
+  int Fire(const std::string& event) {
+    std::string params = "{}";
+    std::vector<std::shared_ptr<Connection>> connections;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = events_.find(event);
+      if (it != events_.end())
+        params = it->second.params;
+      connections = connections_;
+    }
+    size_t dot = event.rfind('.');
+    if (dot == std::string::npos)
+      return 0;
+    const std::string name = event.substr(dot + 1);
+    int delivered = 0;
+    for (const auto& connection : connections) {
+      for (const std::string& designator : connection->GetDesignators(event)) {
+        std::string notification = "{\"jsonrpc\":\"2.0\",\"method\":\"" + designator + "." + name +
+                                   "\",\"params\":" + params + "}";
+        if (connection->Send(notification))
+          ++delivered;
+      }
+    }
+    events_sent_ += delivered;
+    return delivered;
+  }
+
+  void SendPeriodicEvents() {
+    std::map<std::string, std::chrono::steady_clock::time_point> next;
+    for (;;) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      auto now = std::chrono::steady_clock::now();
+      std::vector<std::string> due;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : events_) {
+          if (entry.second.interval_ms <= 0)
+            continue;
+          auto it = next.find(entry.first);
+          if (it == next.end()) {
+            next[entry.first] = now + std::chrono::milliseconds(entry.second.interval_ms);
+          } else if (now >= it->second) {
+            it->second = now + std::chrono::milliseconds(entry.second.interval_ms);
+            due.push_back(entry.first);
+          }
+        }
+      }
+      for (const std::string& event : due)
+        Fire(event);
+    }
+  }
+
+  static bool EndsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() &&
+           value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  std::mutex mutex_;
+  std::map<std::string, MethodConfig> methods_;
+  std::map<std::string, EventConfig> events_;
+  std::vector<std::shared_ptr<Connection>> connections_;
+  std::atomic<uint64_t> calls_ { 0 };
+  std::atomic<uint64_t> failed_ { 0 };
+  std::atomic<uint64_t> events_sent_ { 0 };
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int port = kDefaultPort;
+  std::string config;
+  int opt;
+  while ((opt = getopt(argc, argv, "p:c:h")) != -1) {
+    switch (opt) {
+      case 'p':
+        port = atoi(optarg);
+        break;
+      case 'c':
+        config = optarg;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-p port] [-c config]\n", argv[0]);
+        return opt == 'h' ? 0 : 1;
+    }
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+
+  Stub stub;
+  if (!config.empty() && !stub.LoadConfig(config))
+    return 1;
+  stub.Serve(port);
+  return 0;
+}
@@ -0,0 +1,280 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "third_party/starboard/rdk/shared/trace_recorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "starboard/once.h"
+#include "starboard/time.h"
+#include "starboard/common/mutex.h"
+
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+namespace {
+
+// Per thread, a power of two. 32 bytes per event.
+const uint32_t kEventsPerThread = 4096;
+// Buffers of exited threads are reused once this many exist.
+const size_t kMaxThreadBuffers = 64;
+
+struct TraceEvent {
+  const char* name;
+  SbTimeMonotonic timestamp;
+  int64_t value;
+  char phase;
+};
+
+// Written by its thread only. The reader copies the slots and then drops the
+// ones the writer may have overwritten in the meantime.
+struct ThreadBuffer {
+  void Reset() {
+    tid = 0;
+    name[0] = '\0';
+    write_index.store(0, std::memory_order_relaxed);
+  }
+
+  void Add(char phase, const char* event_name, int64_t value) {
+    uint32_t index = write_index.load(std::memory_order_relaxed);
+    TraceEvent& event = events[index & (kEventsPerThread - 1)];
+    event.name = event_name;
+    event.timestamp = SbTimeGetMonotonicNow();
+    event.value = value;
+    event.phase = phase;
+    write_index.store(index + 1, std::memory_order_release);
+  }
+
+  // Appends the events still in the ring, oldest first.
+  void Copy(std::vector<TraceEvent>& out) const {
+    uint32_t end = write_index.load(std::memory_order_acquire);
+    uint32_t begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+    size_t first = out.size();
+    for (uint32_t i = begin; i != end; ++i)
+      out.push_back(events[i & (kEventsPerThread - 1)]);
+    // Slot |now| may be half written and shares its place with the event
+    // kEventsPerThread before it.
+    uint32_t now = write_index.load(std::memory_order_acquire);
+    uint32_t overwritten = now >= kEventsPerThread ? now - kEventsPerThread + 1 : 0;
+    if (overwritten > begin) {
+      size_t drop = std::min<size_t>(overwritten - begin, out.size() - first);
+      out.erase(out.begin() + first, out.begin() + first + drop);
+    }
+  }
+
+  pid_t tid { 0 };
+  char name[16] { };
+  std::atomic<bool> in_use { false };
+  std::atomic<uint32_t> write_index { 0 };
+  TraceEvent events[kEventsPerThread];
+};
+
+class Registry {
+public:
+  ThreadBuffer* Acquire() {
+    ::starboard::ScopedLock lock(mutex_);
+    ThreadBuffer* buffer = nullptr;
+    if (buffers_.size() < kMaxThreadBuffers) {
+      buffers_.emplace_back(new ThreadBuffer);
+      buffer = buffers_.back().get();
+    } else {
+      for (auto& candidate : buffers_) {
+        if (!candidate->in_use.load(std::memory_order_acquire)) {
+          buffer = candidate.get();
+          break;
+        }
+      }
+      if (!buffer)
+        return nullptr;
+      buffer->Reset();
+    }
+#ifdef SYS_gettid
+    buffer->tid = syscall(SYS_gettid);
+#endif
+    pthread_getname_np(pthread_self(), buffer->name, sizeof(buffer->name));
+    buffer->in_use.store(true, std::memory_order_release);
+    return buffer;
+  }
+
+  bool Export(std::string& out_json) {
+    // Built by hand, the export can hold a few hundred thousand events.
+    std::vector<TraceEvent> events;
+    const long pid = getpid();
+    char line[256];
+
+    out_json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto append = [&](const char* text) {
+      if (!first)
+        out_json += ",\n";
+      out_json += text;
+      first = false;
+    };
+
+    ::starboard::ScopedLock lock(mutex_);
+    for (const auto& buffer : buffers_) {
+      const long tid = buffer->tid;
+      snprintf(line, sizeof(line),
+               "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%ld,\"tid\":%ld,\"args\":{\"name\":\"%s\"}}",
+               pid, tid, Escape(buffer->name).c_str());
+      append(line);
+
+      events.clear();
+      buffer->Copy(events);
+      for (const TraceEvent& event : events) {
+        std::string name = Escape(event.name);
+        const long long ts = event.timestamp;
+        switch (event.phase) {
+          case 'C':
+            snprintf(line, sizeof(line),
+                     "{\"ph\":\"C\",\"name\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":%lld,\"args\":{\"value\":%lld}}",
+                     name.c_str(), pid, tid, ts, static_cast<long long>(event.value));
+            break;
+          case 'i':
+            snprintf(line, sizeof(line),
+                     "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":%lld}",
+                     name.c_str(), pid, tid, ts);
+            break;
+          default:
+            snprintf(line, sizeof(line),
+                     "{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":%ld,\"tid\":%ld,\"ts\":%lld}",
+                     event.phase, name.c_str(), pid, tid, ts);
+            break;
+        }
+        append(line);
+      }
+    }
+    out_json += "]}";
+    return true;
+  }
+
+private:
+  static std::string Escape(const char* text) {
+    std::string result;
+    for (; text && *text; ++text) {
+      if (*text == '"' || *text == '\\')
+        result += '\\';
+      if (static_cast<unsigned char>(*text) >= 0x20)
+        result += *text;
+    }
+    return result;
+  }
+
+  ::starboard::Mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(Registry, GetRegistry);
+
+// Hands the buffer back to the registry when the thread exits.
+struct ThreadBufferHolder {
+  ~ThreadBufferHolder() {
+    if (buffer)
+      buffer->in_use.store(false, std::memory_order_release);
+  }
+  ThreadBuffer* buffer { nullptr };
+  bool acquired { false };
+};
+
+thread_local ThreadBufferHolder tls_buffer;
+
+ThreadBuffer* GetThreadBuffer() {
+  if (!tls_buffer.acquired) {
+    tls_buffer.acquired = true;
+    tls_buffer.buffer = GetRegistry()->Acquire();
+  }
+  return tls_buffer.buffer;
+}
+
+void AddEvent(char phase, const char* name, int64_t value) {
+  if (ThreadBuffer* buffer = GetThreadBuffer())
+    buffer->Add(phase, name, value);
+}
+
+}  // namespace
+
+// static
+const bool TraceRecorder::enabled_ = !!getenv("COBALT_TRACE");
+
+// static
+void TraceRecorder::Begin(const char* name) {
+  AddEvent('B', name, 0);
+}
+
+// static
+void TraceRecorder::End(const char* name) {
+  AddEvent('E', name, 0);
+}
+
+// static
+void TraceRecorder::Instant(const char* name) {
+  AddEvent('i', name, 0);
+}
+
+// static
+void TraceRecorder::Counter(const char* name, int64_t value) {
+  AddEvent('C', name, value);
+}
+
+// static
+bool TraceRecorder::Export(std::string& out_json) {
+  if (!enabled_)
+    return false;
+  return GetRegistry()->Export(out_json);
+}
+
+// static
+std::string TraceRecorder::Dump() {
+  std::string json;
+  if (!Export(json))
+    return std::string();
+
+  const char* dir = getenv("COBALT_TEMP");
+  std::string path = std::string(dir && *dir ? dir : "/tmp") +
+                     "/cobalt_trace_" + std::to_string(getpid()) + ".json";
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) {
+    SB_LOG(ERROR) << "Failed to open trace file: " << path;
+    return std::string();
+  }
+  size_t written = fwrite(json.data(), 1, json.size(), file);
+  fclose(file);
+  if (written != json.size()) {
+    SB_LOG(ERROR) << "Failed to write trace file: " << path;
+    return std::string();
+  }
+  SB_LOG(INFO) << "Trace written to " << path;
+  return path;
+}
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
@@ -0,0 +1,98 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_TRACE_RECORDER_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_TRACE_RECORDER_H_
+
+#include <cstdint>
+#include <string>
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+// Records begin/end, instant and counter events into a ring buffer per
+// thread, so the media and application threads can be lined up on one
+// timeline. Writers never lock, the oldest events are overwritten.
+// Disabled unless COBALT_TRACE is set, a disabled trace point costs one
+// branch. Event names must be string literals (or otherwise outlive the
+// process), only the pointer is stored.
+//
+// The buffers are exported in the Chrome trace event format, viewable in
+// chrome://tracing or Perfetto: on demand through SbRdkGetSetting("trace")
+// and to $COBALT_TEMP/cobalt_trace_<pid>.json when a hang monitor expires.
+class TraceRecorder {
+public:
+  static bool IsEnabled() { return enabled_; }
+
+  static void Begin(const char* name);
+  static void End(const char* name);
+  static void Instant(const char* name);
+  static void Counter(const char* name, int64_t value);
+
+  static bool Export(std::string& out_json);
+  // Writes the export to the default location, returns the path written.
+  static std::string Dump();
+
+private:
+  static const bool enabled_;
+};
+
+class TraceScope {
+public:
+  explicit TraceScope(const char* name)
+    : name_(TraceRecorder::IsEnabled() ? name : nullptr) {
+    if (name_)
+      TraceRecorder::Begin(name_);
+  }
+  ~TraceScope() {
+    if (name_)
+      TraceRecorder::End(name_);
+  }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  const char* name_;
+};
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#define RDK_TRACE_CONCAT_INNER(a, b) a##b
+#define RDK_TRACE_CONCAT(a, b) RDK_TRACE_CONCAT_INNER(a, b)
+
+#define RDK_TRACE_SCOPE(name)                                                     \
+  ::third_party::starboard::rdk::shared::TraceScope RDK_TRACE_CONCAT(             \
+      rdk_trace_scope_, __LINE__)(name)
+
+#define RDK_TRACE_INSTANT(name)                                                   \
+  do {                                                                            \
+    if (::third_party::starboard::rdk::shared::TraceRecorder::IsEnabled())        \
+      ::third_party::starboard::rdk::shared::TraceRecorder::Instant(name);        \
+  } while (0)
+
+#define RDK_TRACE_COUNTER(name, value)                                            \
+  do {                                                                            \
+    if (::third_party::starboard::rdk::shared::TraceRecorder::IsEnabled())        \
+      ::third_party::starboard::rdk::shared::TraceRecorder::Counter(name, value); \
+  } while (0)
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_TRACE_RECORDER_H_
@@ -0,0 +1,132 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "third_party/starboard/rdk/shared/warm_start.h"
+
+#include <gst/gst.h>
+
+#include "starboard/once.h"
+#include "starboard/thread.h"
+#include "starboard/time.h"
+#include "starboard/common/mutex.h"
+
+#include "third_party/starboard/rdk/shared/rdkservices.h"
+#include "third_party/starboard/rdk/shared/log_override.h"
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+namespace player {
+void Prewarm();
+}  // namespace player
+
+namespace {
+
+class WarmUp {
+public:
+  void Begin() {
+    ::starboard::ScopedLock lock(mutex_);
+    if (started_)
+      return;
+    started_ = true;
+    thread_ =
+      SbThreadCreate(0, kSbThreadPriorityLow, kSbThreadNoAffinity, true,
+                     "warm_start", &WarmUp::ThreadEntryPoint, this);
+    if (!SbThreadIsValid(thread_))
+      SB_LOG(ERROR) << "Failed to start warm-up thread";
+  }
+
+  bool Finish() {
+    SbThread thread;
+    {
+      ::starboard::ScopedLock lock(mutex_);
+      thread = thread_;
+      thread_ = kSbThreadInvalid;
+    }
+    if (!SbThreadIsValid(thread))
+      return IsWarm();
+    SbTimeMonotonic start = SbTimeGetMonotonicNow();
+    SbThreadJoin(thread, nullptr);
+    SB_LOG(INFO) << "Waited " << (SbTimeGetMonotonicNow() - start) / kSbTimeMillisecond
+                 << "ms for warm-up to finish";
+    return IsWarm();
+  }
+
+  bool IsWarm() {
+    ::starboard::ScopedLock lock(mutex_);
+    return warm_;
+  }
+
+private:
+  static void* ThreadEntryPoint(void* context) {
+    static_cast<WarmUp*>(context)->DoWork();
+    return nullptr;
+  }
+
+  void DoWork() {
+    SbTimeMonotonic start = SbTimeGetMonotonicNow();
+
+    GError* error = NULL;
+    if (!gst_init_check(NULL, NULL, &error)) {
+      SB_LOG(ERROR) << "Warm-up failed to initialize GStreamer: "
+                    << (error ? error->message : "unknown error");
+      g_clear_error(&error);
+      return;
+    }
+
+    // There is no Application yet, service events are held back until it
+    // starts.
+    PrefetchRDKServices();
+    player::Prewarm();
+
+    SB_LOG(INFO) << "Warm-up took " << (SbTimeGetMonotonicNow() - start) / kSbTimeMillisecond << "ms";
+
+    ::starboard::ScopedLock lock(mutex_);
+    warm_ = true;
+  }
+
+  ::starboard::Mutex mutex_;
+  SbThread thread_ { kSbThreadInvalid };
+  bool started_ { false };
+  bool warm_ { false };
+};
+
+SB_ONCE_INITIALIZE_FUNCTION(WarmUp, GetWarmUp);
+
+}  // namespace
+
+// static
+void WarmStart::Begin() {
+  GetWarmUp()->Begin();
+}
+
+// static
+bool WarmStart::Finish() {
+  return GetWarmUp()->Finish();
+}
+
+// static
+bool WarmStart::IsWarm() {
+  return GetWarmUp()->IsWarm();
+}
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
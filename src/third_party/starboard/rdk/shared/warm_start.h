@@ -0,0 +1,46 @@
+//
+// Copyright 2020 Comcast Cable Communications Management, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef THIRD_PARTY_STARBOARD_RDK_SHARED_WARM_START_H_
+#define THIRD_PARTY_STARBOARD_RDK_SHARED_WARM_START_H_
+
+namespace third_party {
+namespace starboard {
+namespace rdk {
+namespace shared {
+
+// Platform initialization that does not depend on the URL or the launch
+// arguments: GStreamer and its registry, the rdkservices links and the
+// player prewarm. Started through SbRdkWarmUp() by a host that is waiting
+// for the go signal, so StarboardMain() finds it done.
+class WarmStart {
+public:
+  // Starts the warm-up on a low priority thread. Only the first call has an
+  // effect.
+  static void Begin();
+  // Waits for a warm-up started by Begin(). Returns false if there was none.
+  static bool Finish();
+  // True once a warm-up has completed.
+  static bool IsWarm();
+};
+
+}  // namespace shared
+}  // namespace rdk
+}  // namespace starboard
+}  // namespace third_party
+
+#endif  // THIRD_PARTY_STARBOARD_RDK_SHARED_WARM_START_H_